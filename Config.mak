@@ -30,3 +30,10 @@ HDF5LIB=$(shell pkg-config --libs hdf5) -lhdf5_hl
 # is typically more effective; when your model includes overdetermined (redundant) particle-and-joint
 # systems and the default solver fails, then the QR factorisation may be able to provide a solution)
 #SUITESPARSE=/Users/tomek/Devel/SuiteSparse
+
+# MPI (when enabled the code is compiled with mpicxx and particles are distributed
+# across MPI ranks along the Morton curve, see domain.cpp; run as mpirun -np 4 ./parmec8 ...;
+# on one machine ghost motion is shared through POSIX shared memory (PARMEC_SHM=0 sends messages
+# instead; trees are not shared) and one rank per socket can be run as: PARMEC_PIN=1 mpirun -np 2
+# --map-by socket --bind-to socket ./parmec8 -ntasks <cores per socket> ...)
+#MPI=yes
@@ -0,0 +1,123 @@
+# PARMEC benchmark --> scalable synthetic models
+#   parmec8 [-ntasks n] bench/models.py model size steps [result.json]
+# model: bed, hopper, lattice, joints, mesh; size: approximate number of particles;
+# the model is stepped 'steps' times and the throughput and phase timers are
+# written as JSON to 'result.json' (or printed); see bench/run.py; output is
+# written only at the start and the end and its time is left out of the throughput
+
+import json, random
+from math import sin, cos, pi
+
+args = ARGV()
+model = args[0] if len(args) > 0 else 'bed'
+size = int(args[1]) if len(args) > 1 else 1000
+steps = int(args[2]) if len(args) > 2 else 100
+result = args[3] if len(args) > 3 else None
+
+rnd = random.Random (1) # reproducible jitter
+rad = 0.05 # particle radius
+mat = MATERIAL (1E3, 1E7, 0.25)
+GRANULAR (1, 1, 1E6, 0.5, 0.2)
+GRAVITY (0., 0., -10.)
+
+def side (n):
+  return max (int(round(n**(1.0/3.0))), 1)
+
+def floor (x0, y0, x1, y1, z):
+  OBSTACLE ([(x0,y0,z, x1,y0,z, x1,y1,z), (x0,y0,z, x1,y1,z, x0,y1,z)], 2)
+
+def spheres (n, x0, y0, z0, gap = 0.1):
+  '''n x n x n jittered spheres above (x0, y0, z0); returns particle numbers'''
+  d = 2*rad*(1.0+gap)
+  parts = []
+  for i in range (n):
+    for j in range (n):
+      for k in range (n):
+        c = (x0+rad+i*d+0.01*rad*rnd.random(), y0+rad+j*d+0.01*rad*rnd.random(), z0+rad+k*d)
+        parts.append (SPHERE (c, rad, mat, 1))
+  return parts
+
+def bed ():
+  '''sphere bed of size particles settling on a plane'''
+  n = side (size)
+  L = n*2.2*rad
+  floor (-L, -L, 2*L, 2*L, 0.0)
+  return spheres (n, 0.0, 0.0, 0.0)
+
+def hopper ():
+  '''hopper discharge: spheres falling through a pyramidal funnel onto a box floor'''
+  n = side (size)
+  L = n*2.2*rad
+  a, b = 0.4*L, 0.6*L
+  OBSTACLE ([(0,0,0, L,0,0, a,a,-L), (a,a,-L, L,0,0, b,a,-L),
+             (0,0,0, 0,L,0, a,a,-L), (a,a,-L, 0,L,0, a,b,-L),
+             (0,L,0, L,L,0, a,b,-L), (a,b,-L, L,L,0, b,b,-L),
+             (L,L,0, L,0,0, b,a,-L), (b,a,-L, L,L,0, b,b,-L)], 2)
+  floor (-L, -L, 2*L, 2*L, -2*L)
+  return spheres (n, 0.0, 0.0, 0.1*L)
+
+def lattice ():
+  '''spring lattice: a cube of spheres joined by springs to their lattice neighbours'''
+  n = side (size)
+  d = 2.2*rad
+  parts = spheres (n, 0.0, 0.0, 0.2, gap = 0.1)
+  floor (-n*d, -n*d, 2*n*d, 2*n*d, 0.0)
+  idx = lambda i, j, k: parts[(i*n+j)*n+k]
+  pos = lambda i, j, k: (rad+i*d, rad+j*d, 0.2+rad+k*d)
+  for i in range (n):
+    for j in range (n):
+      for k in range (n):
+        for (p, q, r) in ((i+1, j, k), (i, j+1, k), (i, j, k+1)):
+          if p < n and q < n and r < n:
+            SPRING (idx(i,j,k), pos(i,j,k), idx(p,q,r), pos(p,q,r), [-1,-1E5, 1,1E5], [-1, -1E2, 1, 1E2])
+  return parts
+
+def joints ():
+  '''ball-joint forest: chains of ten spheres hanging from the ground'''
+  L = 10
+  m = max (int(round((size/L)**0.5)), 1)
+  d = 2.2*rad
+  parts = []
+  for x in range (m):
+    for y in range (m):
+      prev = -1
+      for i in range (L):
+        c = (x*4*d, y*4*d, -i*d)
+        p = SPHERE (c, rad, mat, 1)
+        BALL_JOINT (p, (c[0], c[1], c[2]+0.5*d), prev)
+        parts.append (p)
+        prev = p
+      VELOCITY (prev, (1.0, 0.5, 0.0)) # swing the chain
+  return parts
+
+def mesh ():
+  '''spheres falling onto a wavy obstacle surface of about size triangles'''
+  n = side (size)
+  L = n*2.2*rad
+  m = max (int((size/2)**0.5), 1)
+  h = L/m
+  z = lambda x, y: 0.05*L*sin(2*pi*x/L)*cos(2*pi*y/L)
+  tris = []
+  for i in range (m):
+    for j in range (m):
+      x0, y0, x1, y1 = i*h, j*h, (i+1)*h, (j+1)*h
+      tris.append ((x0,y0,z(x0,y0), x1,y0,z(x1,y0), x1,y1,z(x1,y1)))
+      tris.append ((x0,y0,z(x0,y0), x1,y1,z(x1,y1), x0,y1,z(x0,y1)))
+  OBSTACLE (tris, 2)
+  return spheres (n, 0.0, 0.0, 0.1*L)
+
+parts = {'bed': bed, 'hopper': hopper, 'lattice': lattice, 'joints': joints, 'mesh': mesh}[model]()
+
+step = 0.5 * CRITICAL ()
+duration = steps * step
+DEM (duration, step, (duration, duration), verbose = 0)
+
+timers = TIMERS ()
+seconds = timers['total'] - timers['output']
+data = {'model': model, 'size': size, 'particles': len(parts), 'steps': timers['steps'], 'step': step,
+        'seconds': seconds, 'particle_steps_per_second': len(parts)*timers['steps']/max(seconds, 1E-12),
+        'timers': timers, 'argv': ARGV(False)}
+
+if result:
+  with open (result, 'w') as f: json.dump (data, f)
+else: print (json.dumps (data, indent = 2))
@@ -0,0 +1,84 @@
+# PARMEC benchmark driver
+#   python3 bench/run.py ./parmec8 [--models bed hopper ...] [--sizes 1000 8000 ...]
+#                        [--ntasks 1 2 4 ...] [--steps 100] [--output bench.json]
+#                        [--baseline old.json] [--tolerance 0.1] [--pin [both]]
+# every model is run at every size and number of tasks (see bench/models.py);
+# particle-steps per second and the largest phases are summarised on one line
+# per run and all results are written to a JSON file; with --baseline the
+# throughput is compared against an earlier result file and the exit status is
+# non-zero when any run is slower by more than the tolerance; --pin sets
+# PARMEC_PIN=1 so that task threads are pinned to cores (see tasksys.cpp);
+# --pin both runs every case unpinned and pinned and prints the pinned over
+# unpinned throughput ratio: with --ntasks spanning one and both sockets this
+# shows the cross-socket scaling of first-touch placed buffers
+
+import os, sys, json, shutil, subprocess, argparse, tempfile
+
+MODELS = ['bed', 'hopper', 'lattice', 'joints', 'mesh']
+
+def run (exe, model, size, ntasks, steps, tmp, pin):
+  out = os.path.join (tmp, '%s_%d_%d.json' % (model, size, ntasks))
+  path = os.path.join (tmp, 'models.py') # output files land next to the input file
+  env = dict (os.environ, PARMEC_PIN = '1' if pin else '0')
+  subprocess.check_call ([exe, '-ntasks', str(ntasks), path, model, str(size), str(steps), out], stdout=subprocess.DEVNULL, env=env)
+  with open (out) as f: data = json.load (f)
+  data['ntasks'] = ntasks
+  data['pinned'] = pin
+  return data
+
+def key (data):
+  return (data['model'], data['size'], data['ntasks'], data.get ('pinned', False))
+
+def summary (data):
+  timers = data['timers']
+  phases = sorted ([(v, k) for k, v in timers.items() if k not in ('total', 'steps', 'contacts',
+    'chain_blocks', 'repartitions', 'lock_spins')], reverse=True)[:3]
+  total = max (timers['total'], 1E-12)
+  return '%-8s %8d particles %3d tasks: %10.3e particle-steps/s (%s)' % (data['model'], data['particles'],
+    data['ntasks'], data['particle_steps_per_second'], ', '.join ('%s %.0f%%' % (k, 100.0*v/total) for v, k in phases))
+
+if __name__ == '__main__':
+  parser = argparse.ArgumentParser (description='PARMEC benchmark driver')
+  parser.add_argument ('executable', help='parmec executable')
+  parser.add_argument ('--models', nargs='+', default=MODELS, choices=MODELS, help='benchmark models')
+  parser.add_argument ('--sizes', nargs='+', type=int, default=[1000, 8000, 64000], help='approximate numbers of particles')
+  parser.add_argument ('--ntasks', nargs='+', type=int, default=[1, os.cpu_count() or 1], help='numbers of tasks')
+  parser.add_argument ('--steps', type=int, default=100, help='number of time steps per run')
+  parser.add_argument ('--output', default='bench.json', help='results file')
+  parser.add_argument ('--baseline', help='earlier results file to compare against')
+  parser.add_argument ('--tolerance', type=float, default=0.1, help='tolerated relative throughput loss')
+  parser.add_argument ('--pin', nargs='?', const='on', default='off', choices=['off', 'on', 'both'],
+    help='pin task threads to cores (both: compare unpinned and pinned runs)')
+  args = parser.parse_args()
+
+  pins = {'off': [False], 'on': [True], 'both': [False, True]}[args.pin]
+  results = []
+  tmp = tempfile.mkdtemp()
+  shutil.copy (os.path.join (os.path.dirname (os.path.abspath (__file__)), 'models.py'), tmp)
+  for model in args.models:
+    for size in args.sizes:
+      for ntasks in sorted (set (args.ntasks)):
+        for pin in pins:
+          data = run (args.executable, model, size, ntasks, args.steps, tmp, pin)
+          results.append (data)
+          print (summary (data) + (' pinned' if pin else ''))
+          sys.stdout.flush()
+        if len (pins) > 1:
+          print ('%-8s %8d particles %3d tasks: pinned/unpinned throughput %.2f' % (model, results[-1]['particles'],
+            ntasks, results[-1]['particle_steps_per_second']/max(results[-2]['particle_steps_per_second'], 1E-12)))
+
+  with open (args.output, 'w') as f:
+    json.dump ({'executable': args.executable, 'steps': args.steps, 'pinned': args.pin, 'results': results}, f, indent=1)
+
+  failed = 0
+  if args.baseline:
+    with open (args.baseline) as f: base = dict ((key (d), d) for d in json.load (f)['results'])
+    for data in results:
+      if key (data) not in base: continue
+      old = base[key (data)]['particle_steps_per_second']
+      new = data['particle_steps_per_second']
+      if new < (1.0-args.tolerance)*old:
+        print ('REGRESSION %s %d particles %d tasks: %.3e -> %.3e particle-steps/s' % (key (data)[0], data['particles'], data['ntasks'], old, new))
+        failed += 1
+
+  sys.exit (1 if failed else 0)
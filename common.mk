@@ -32,14 +32,25 @@ else
   SUITEFLG=
 endif
 
-ISPC_OBJS4=$(addprefix objs4/, $(ISPC_SRC:.ispc=_ispc.o))
-ISPC_OBJS8=$(addprefix objs8/, $(ISPC_SRC:.ispc=_ispc.o))
+ifdef MPI
+  CXX=mpicxx
+  CFLAGS+=-DPARMEC_MPI
+endif
+
+# dispatch and per target ISPC objects
+ISPC_SUFFIXES=_ispc.o $(foreach isa, $(ISPC_ISA), _ispc_$(isa).o)
+ISPC_OBJS4=$(foreach suf, $(ISPC_SUFFIXES), $(addprefix objs4/, $(ISPC_SRC:.ispc=$(suf))))
+ISPC_OBJS8=$(foreach suf, $(ISPC_SUFFIXES), $(addprefix objs8/, $(ISPC_SRC:.ispc=$(suf))))
+ISPC_OBJS48=$(foreach suf, $(ISPC_SUFFIXES), $(addprefix objs48/, $(ISPC_SRC:.ispc=$(suf))))
 ISPC_HEADERS4=$(addprefix objs4/, $(ISPC_SRC:.ispc=_ispc.h))
 ISPC_HEADERS8=$(addprefix objs8/, $(ISPC_SRC:.ispc=_ispc.h))
+ISPC_HEADERS48=$(addprefix objs48/, $(ISPC_SRC:.ispc=_ispc.h))
 CPP_OBJS4=$(addprefix objs4/, $(CPP_SRC:.cpp=.o))
 CPP_OBJS8=$(addprefix objs8/, $(CPP_SRC:.cpp=.o))
+CPP_OBJS48=$(addprefix objs48/, $(CPP_SRC:.cpp=.o))
 C_OBJS4=$(addprefix objs4/, $(C_SRC:.c=.o))
 C_OBJS8=$(addprefix objs8/, $(C_SRC:.c=.o))
+C_OBJS48=$(addprefix objs48/, $(C_SRC:.c=.o))
 LIBS=-lm $(PYTHONLIB) $(HDF5LIB)
 ifdef MEDINC
   LIBS+=$(MEDLIB)
@@ -47,10 +58,31 @@ endif
 ifdef SUITESPARSE
   LIBS+= -L$(SUITESPARSE)/lib -lspqr -lcholmod
 endif
+ifdef MPI
+  ifeq ($(UNAME_S),Linux)
+    LIBS+= -lrt # shm_open with glibc older than 2.34
+  endif
+endif
+
+default: dirs version $(ISPC_HEADERS4) $(ISPC_HEADERS8) $(CPP_OBJS4) $(CPP_OBJS8) $(C_OBJS4) $(C_OBJS8) $(LIB)4.a $(LIB)8.a $(EXE)4 $(EXE)8 $(EXE)-post headers
+
+# mixed precision (GREAL=4): single precision leaf data and new contact tests; contact
+# updates, force evaluation and accumulation stay in double precision
+mixed: dirs version $(ISPC_HEADERS48) $(CPP_OBJS48) $(C_OBJS48) $(EXE)48
 
-default: dirs version $(ISPC_HEADERS4) $(ISPC_HEADERS8) $(CPP_OBJS4) $(CPP_OBJS8) $(C_OBJS4) $(C_OBJS8) $(LIB)4.a $(LIB)8.a $(EXE)4 $(EXE)8 headers
+# compare the mixed precision build against the double precision build
+precision: default mixed
+	python3 python/precision_compare.py ./$(EXE)8 ./$(EXE)48
 
-.PHONY: dirs clean print
+# compare a distributed run against a single process run (build with MPI=yes)
+mpi: default
+	python3 python/mpi_compare.py ./$(EXE)8
+
+# throughput benchmarks of scalable synthetic models (see bench/run.py for options)
+bench: default
+	python3 bench/run.py ./$(EXE)8
+
+.PHONY: dirs clean print mixed precision mpi bench
 
 print:
 	@echo $(ISPC_HEADERS4)
@@ -65,6 +97,7 @@ print:
 dirs:
 	/bin/mkdir -p objs4/
 	/bin/mkdir -p objs8/
+	/bin/mkdir -p objs48/
 
 headers:
 	python3 headers.py
@@ -76,15 +109,16 @@ del:
 	find ./ -iname "*.h5" -exec rm '{}' ';'
 	find ./ -iname "*.xmf" -exec rm '{}' ';'
 	find ./ -iname "*.med" -exec rm '{}' ';'
+	find ./tests -iname "*.csv" -exec rm '{}' ';'
 	find ./tests -type d -name doc -prune -o -iname "*.png" -exec rm '{}' ';'
 
 clean:  del
-	/bin/rm -rf objs* *~ $(EXE)4 $(EXE)8 *.dSYM $(LIB)4.a $(LIB)8.a parmec4.h parmec8.h condet4.h condet8.h
+	/bin/rm -rf objs* *~ $(EXE)4 $(EXE)8 $(EXE)48 $(EXE)-post *.dSYM $(LIB)4.a $(LIB)8.a parmec4.h parmec8.h condet4.h condet8.h
 	find ./ -iname "*.dump" -exec rm '{}' ';'
 	find ./ -iname "*.pyc" -exec rm '{}' ';'
 
 qlean:	del
-	/bin/rm -fr $(CPP_OBJS4) $(CPP_OBJS8) $(C_OBJS4) $(C_OBJS8) *~ $(EXE)4 $(EXE)8 *.dSYM $(LIB)4.a $(LIB)8.a parmec4.h parmec8.h condet4.h condet8.h
+	/bin/rm -fr $(CPP_OBJS4) $(CPP_OBJS8) $(CPP_OBJS48) $(C_OBJS4) $(C_OBJS8) $(C_OBJS48) *~ $(EXE)4 $(EXE)8 $(EXE)48 $(EXE)-post *.dSYM $(LIB)4.a $(LIB)8.a parmec4.h parmec8.h condet4.h condet8.h
 
 version:
 	python3 version.py
@@ -103,42 +137,78 @@ $(EXE)4: objs4/main.o $(CPP_OBJS4) $(C_OBJS4) $(ISPC_OBJS4)
 $(EXE)8: objs8/main.o $(CPP_OBJS8) $(C_OBJS8) $(ISPC_OBJS8)
 	$(CXX) $(CFLAGS) -fopenmp -o $@ $^ $(LIBS)
 
+$(EXE)48: objs48/main.o $(CPP_OBJS48) $(C_OBJS48) $(ISPC_OBJS48)
+	$(CXX) $(CFLAGS) -fopenmp -o $@ $^ $(LIBS)
+
+$(EXE)-post: objs8/post.o objs8/h5read.o
+	$(CXX) $(CFLAGS) -fopenmp -o $@ $^ -lm $(HDF5LIB)
+
 objs4/main.o: main.cpp version.h
 	$(CXX) -DREAL=4 -Iobjs4 $(CFLAGS) $< -c -o $@
 
 objs8/main.o: main.cpp version.h
 	$(CXX) -DREAL=8 -Iobjs8 $(CFLAGS) $< -c -o $@
 
+objs48/main.o: main.cpp version.h
+	$(CXX) -DREAL=8 -DGREAL=4 -Iobjs48 $(CFLAGS) $< -c -o $@
+
 objs4/input.o: input.cpp
 	$(CXX) -DREAL=4 -Iobjs4 $(CFLAGS) $(PYTHONINC) $(MEDFLG) $< -c -o $@
 
 objs8/input.o: input.cpp
 	$(CXX) -DREAL=8 -Iobjs8 $(CFLAGS) $(PYTHONINC) $(MEDFLG) $< -c -o $@
 
+objs48/input.o: input.cpp
+	$(CXX) -DREAL=8 -DGREAL=4 -Iobjs48 $(CFLAGS) $(PYTHONINC) $(MEDFLG) $< -c -o $@
+
 objs4/output.o: output.cpp
 	$(CXX) -DREAL=4 -Iobjs4 $(CFLAGS) $(PYTHONINC) $(HDF5INC) $(MEDFLG) $(MEDINC) $< -c -o $@
 
 objs8/output.o: output.cpp
 	$(CXX) -DREAL=8 -Iobjs8 $(CFLAGS) $(PYTHONINC) $(HDF5INC) $(MEDFLG) $(MEDINC) $< -c -o $@
 
+objs48/output.o: output.cpp
+	$(CXX) -DREAL=8 -DGREAL=4 -Iobjs48 $(CFLAGS) $(PYTHONINC) $(HDF5INC) $(MEDFLG) $(MEDINC) $< -c -o $@
+
+objs4/h5read.o: h5read.cpp
+	$(CXX) -DREAL=4 -Iobjs4 $(CFLAGS) $(HDF5INC) $< -c -o $@
+
+objs8/h5read.o: h5read.cpp
+	$(CXX) -DREAL=8 -Iobjs8 $(CFLAGS) $(HDF5INC) $< -c -o $@
+
+objs48/h5read.o: h5read.cpp
+	$(CXX) -DREAL=8 -DGREAL=4 -Iobjs48 $(CFLAGS) $(HDF5INC) $< -c -o $@
+
+objs8/post.o: post.cpp version.h
+	$(CXX) -DREAL=8 -Iobjs8 $(CFLAGS) $(HDF5INC) $< -c -o $@
+
 objs4/joints.o: joints.cpp
 	$(CXX) -DREAL=4 -Iobjs4 $(CFLAGS) $(SUITEFLG) -I. -std=c++11 $< -c -o $@
 
 objs8/joints.o: joints.cpp
 	$(CXX) -DREAL=8 -Iobjs8 $(CFLAGS) $(SUITEFLG) -I. -std=c++11 $< -c -o $@
 
-objs4/%_ispc.h objs4/%_ispc.o: %.ispc
+objs48/joints.o: joints.cpp
+	$(CXX) -DREAL=8 -DGREAL=4 -Iobjs48 $(CFLAGS) $(SUITEFLG) -I. -std=c++11 $< -c -o $@
+
+objs4/%_ispc.h $(addprefix objs4/%, $(ISPC_SUFFIXES)): %.ispc
 	$(ISPC) -DREAL=4 -Iobjs4 --target=$(ISPC_TARGET) $< -o objs4/$*_ispc.o -h objs4/$*_ispc.h
 
-objs8/%_ispc.h objs8/%_ispc.o: %.ispc
+objs8/%_ispc.h $(addprefix objs8/%, $(ISPC_SUFFIXES)): %.ispc
 	$(ISPC) -DREAL=8 -Iobjs8 --target=$(ISPC_TARGET) $< -o objs8/$*_ispc.o -h objs8/$*_ispc.h
 
+objs48/%_ispc.h $(addprefix objs48/%, $(ISPC_SUFFIXES)): %.ispc
+	$(ISPC) -DREAL=8 -DGREAL=4 -Iobjs48 --target=$(ISPC_TARGET) $< -o objs48/$*_ispc.o -h objs48/$*_ispc.h
+
 objs4/tasksys.o: tasksys.cpp
 	$(CXX) $(CFLAGS) $(TASKSYS) $< -c -o $@
 
 objs8/tasksys.o: tasksys.cpp
 	$(CXX) $(CFLAGS) $(TASKSYS) $< -c -o $@
 
+objs48/tasksys.o: tasksys.cpp
+	$(CXX) $(CFLAGS) $(TASKSYS) $< -c -o $@
+
 objs4/%.o: %.cpp $(ISPC_HEADERS4)
 	$(CXX) -DREAL=4 -Iobjs4 -Iobjs4 $(CFLAGS) $< -c -o $@
 
@@ -150,3 +220,9 @@ objs4/%.o: %.c $(ISPC_HEADERS4)
 
 objs8/%.o: %.c $(ISPC_HEADERS8)
 	$(CC) -DREAL=8 -Iobjs8 $(CFLAGS) $< -c -o $@
+
+objs48/%.o: %.cpp $(ISPC_HEADERS48)
+	$(CXX) -DREAL=8 -DGREAL=4 -Iobjs48 $(CFLAGS) $< -c -o $@
+
+objs48/%.o: %.c $(ISPC_HEADERS48)
+	$(CC) -DREAL=8 -DGREAL=4 -Iobjs48 $(CFLAGS) $< -c -o $@
@@ -42,6 +42,7 @@ struct master_conpnt
   uniform REAL kcur[CONBUF]; /* current spring stiffness */
   uniform REAL ecur[CONBUF]; /* current damper stiffness */
   uniform REAL state[NSTATE][CONBUF]; /* state parameters */
+  uniform int feature[CONBUF]; /* closest triangle feature of sphere-triangle contacts, see condet.ispc:triangle_sphere */
   uniform int size;
 
   uniform master_conpnt * uniform next; /* local list */
@@ -63,4 +64,16 @@ struct slave_conpnt
   uniform int lock; /* list update lock */
 };
 
+/* bounding volume hierarchy of obstacle triangles;
+ * built once per DEM call and refitted after obstacle motion */
+struct obstacle_tree
+{
+  uniform int nodnum; /* number of nodes */
+  uniform int * uniform node; /* node[2*i], node[2*i+1]: children, or -(first+1), count of leaf triangles */
+  uniform REAL * uniform box; /* box[6*i] ... box[6*i+5]: node lower and upper extents */
+  uniform int trinum; /* number of obstacle triangles */
+  uniform int * uniform order; /* obstacle triangle indices in leaf order */
+  uniform int moving; /* number of moving obstacle triangles */
+};
+
 #endif
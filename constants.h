@@ -49,7 +49,11 @@ namespace parmec
     HIS_TRQSPR_R, HIS_TRQSPR_P, HIS_TRQSPR_Y, HIS_JREAC_X, HIS_JREAC_Y,
     HIS_JREAC_Z, HIS_JREAC_L, HIS_TIME}; /* history entities */
 
-  enum {OUT_FORMAT_DUMP = 1, OUT_FORMAT_VTK = 2, OUT_FORMAT_XDMF = 4, OUT_FORMAT_MED = 8}; /* output format */
+  enum {OUT_FORMAT_DUMP = 1, OUT_FORMAT_VTK = 2, OUT_FORMAT_XDMF = 4, OUT_FORMAT_MED = 8, OUT_FORMAT_STREAM = 16}; /* output format */
+
+  enum {OUT_PRECISION_DOUBLE, OUT_PRECISION_FLOAT, OUT_PRECISION_SCALED, OUT_PRECISION_DELTA}; /* output dataset precision */
+
+  enum {OUT_ROI_NONE, OUT_ROI_SPHERE, OUT_ROI_BOX}; /* output region of interest kind */
 
   enum {OUT_MODE_SPH = 1, OUT_MODE_MESH = 2, OUT_MODE_RB = 4, OUT_MODE_CD = 8, OUT_MODE_SL = 16, OUT_MODE_ST = 32, OUT_MODE_JT = 64}; /* output modes */
 
@@ -69,6 +73,15 @@ namespace parmec
 
   enum {OP_SUM, OP_MAX, OP_MIN}; /* unspring operators */
 
+  enum {PERF_CONTACTS, PERF_ACCUMULATE, PERF_SPRINGS, PERF_TRQSPR, PERF_UNSPRING, PERF_SPINS, PERF_POINTS, PERF_BLOCKS, NPERF}; /* forces subphase clock ticks, lock spins, contact points and chain blocks */
+
+  enum {PHASE_STORE, PHASE_CREATE, PHASE_CONDET, PHASE_CONTACTS, PHASE_ACCUMULATE, PHASE_SPRINGS, PHASE_TRQSPR, PHASE_UNSPRING,
+    PHASE_MULTIRATE, PHASE_JOINTS, PHASE_DYNAMICS, PHASE_SHAPES, PHASE_OBSTACLES, PHASE_CALLBACKS, PHASE_REORDER, PHASE_DOMAIN, PHASE_OUTPUT, PHASE_TOTAL, NPHASE}; /* timed phases; forces subphases follow PERF_ order */
+
+  enum {COUNT_STEPS, COUNT_CONTACTS, COUNT_BLOCKS, COUNT_REPART, COUNT_SPINS, NCOUNT}; /* performance counters */
+
+  enum {SCHED_CONTACTS, SCHED_ACCUMULATE, SCHED_SPRINGS, SCHED_TRQSPR, SCHED_DYNAMICS, NSCHED}; /* balanced task spans */
+
 #ifdef __cplusplus
 }
 #endif
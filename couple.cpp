@@ -0,0 +1,195 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2015 Tomasz Koziara
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+ */
+
+/* Contributors: Tomasz Koziara */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <sched.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "macros.h"
+#include "couple.h"
+
+namespace parmec { /* namespace */
+
+static couple_header *channel = NULL; /* mapped channel */
+static size_t channel_size = 0; /* mapped size */
+static char *channel_path = NULL; /* channel file path */
+
+/* k-th channel array */
+inline static double* array (int k)
+{
+  return (double*)(channel+1) + (size_t)k*channel->count;
+}
+
+/* monotonic seconds */
+static double seconds ()
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+
+  return (double)ts.tv_sec + 1E-9*(double)ts.tv_nsec;
+}
+
+/* open co-simulation channel at 'path' for 'count' particles (return 0 on success) */
+int couple_open (const char *path, int count, int *part)
+{
+  int fd;
+  void *ptr;
+
+  couple_close ();
+
+  channel_size = sizeof (couple_header) + (size_t)COUPLE_ARRAYS*count*sizeof (double);
+
+  if ((fd = open (path, O_RDWR|O_CREAT|O_TRUNC, 0600)) < 0) return -1;
+
+  if (ftruncate (fd, channel_size) != 0)
+  {
+    close (fd);
+    return -1;
+  }
+
+  ptr = mmap (NULL, channel_size, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+
+  close (fd);
+
+  if (ptr == MAP_FAILED) return -1;
+
+  channel = (couple_header*)ptr;
+  memset (channel, 0, channel_size);
+  channel->count = count;
+
+  for (int i = 0; i < count; i ++) array (COUPLE_ID)[i] = part[i];
+
+  ERRMEM (channel_path = new char [strlen (path)+1]);
+  strcpy (channel_path, path);
+
+  __atomic_store_n (&channel->magic, COUPLE_MAGIC, __ATOMIC_RELEASE); /* initialised */
+
+  return 0;
+}
+
+/* publish kinematics and inner forces of coupled particles and wait up to 'timeout'
+ * seconds for the coupled solver to answer with outer forces */
+void couple_exchange (int count, int *part, REAL time, REAL step, REAL *position[6], REAL *rotation[9],
+  REAL *linear[3], REAL *angular[6], REAL *force[3], REAL *torque[3], REAL *outer[6], double timeout)
+{
+  int i, j, k;
+
+  ASSERT (channel && channel->count == count, "Co-simulation channel is not open");
+
+  for (k = 0; k < 3; k ++)
+  {
+    double *x = array (COUPLE_POSITION+k), *v = array (COUPLE_LINEAR+k), *o = array (COUPLE_ANGULAR+k),
+           *f = array (COUPLE_INNER+k), *t = array (COUPLE_INNER+3+k);
+
+    for (i = 0; i < count; i ++)
+    {
+      j = part[i];
+      x[i] = position[k][j];
+      v[i] = linear[k][j];
+      o[i] = angular[3+k][j];
+      f[i] = force[k][j];
+      t[i] = torque[k][j];
+    }
+  }
+
+  for (k = 0; k < 9; k ++)
+  {
+    double *r = array (COUPLE_ROTATION+k);
+
+    for (i = 0; i < count; i ++) r[i] = rotation[k][part[i]];
+  }
+
+  channel->time = time;
+  channel->step = step;
+
+  int64_t seq = channel->sent + 1;
+
+  __atomic_store_n (&channel->sent, seq, __ATOMIC_RELEASE);
+
+  double start = seconds ();
+
+  for (int spin = 0; __atomic_load_n (&channel->received, __ATOMIC_ACQUIRE) < seq; spin ++)
+  {
+    if (spin < 1000) sched_yield (); /* short waits */
+    else
+    {
+      struct timespec ts = {0, 50000};
+
+      nanosleep (&ts, NULL);
+
+      ASSERT (seconds () - start < timeout, "Co-simulation partner at %s did not answer within %g seconds", channel_path, timeout);
+    }
+  }
+
+  for (k = 0; k < 6; k ++)
+  {
+    double *f = array (COUPLE_OUTER+k);
+
+    for (i = 0; i < count; i ++) outer[k][i] = f[i];
+  }
+}
+
+/* add outer forces to coupled particles */
+void couple_forces (int count, int *part, REAL *outer[6], REAL *force[3], REAL *torque[3])
+{
+  for (int i = 0; i < count; i ++)
+  {
+    int j = part[i];
+
+    force[0][j] += outer[0][i]; /* force and torque are zeroed at every time step */
+    force[1][j] += outer[1][i];
+    force[2][j] += outer[2][i];
+    torque[0][j] += outer[3][i];
+    torque[1][j] += outer[4][i];
+    torque[2][j] += outer[5][i];
+  }
+}
+
+/* close co-simulation channel; the coupled solver sees sent == -1 */
+void couple_close ()
+{
+  if (channel)
+  {
+    __atomic_store_n (&channel->sent, (int64_t)-1, __ATOMIC_RELEASE);
+
+    munmap (channel, channel_size);
+
+    unlink (channel_path); /* the coupled solver keeps its mapping */
+
+    delete [] channel_path;
+
+    channel = NULL;
+    channel_path = NULL;
+    channel_size = 0;
+  }
+}
+
+} /* namespace */
@@ -0,0 +1,77 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2015 Tomasz Koziara
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+ */
+
+/* Contributors: Tomasz Koziara */
+
+#include <stdint.h>
+
+#ifndef __couple__
+#define __couple__
+
+#define COUPLE_MAGIC 0x434D524150LL /* "PARMC" */
+
+/* co-simulation channel: a memory mapped file (e.g. under /dev/shm) holding this header
+ * followed by COUPLE_ARRAYS flat arrays of doubles, each indexed by coupling slot and of
+ * 'count' items; PARMEC publishes kinematics and inner forces and increments 'sent', the
+ * coupled solver writes outer forces and sets 'received' to 'sent'; see python/couple_partner.py */
+struct couple_header
+{
+  int64_t magic; /* COUPLE_MAGIC once the channel is initialised */
+  int64_t count; /* number of coupling slots */
+  int64_t sent; /* number of exchanges published by PARMEC; -1 after closing */
+  int64_t received; /* number of exchanges answered by the coupled solver */
+  double time; /* time of the last exchange */
+  double step; /* time between exchanges */
+  int64_t unused[2]; /* 64 byte header */
+};
+
+/* array offsets */
+enum {COUPLE_ID = 0, /* particle number */
+  COUPLE_POSITION = 1, /* mass center */
+  COUPLE_ROTATION = 4, /* rotation operator (column-wise) */
+  COUPLE_LINEAR = 13, /* linear velocity */
+  COUPLE_ANGULAR = 16, /* spatial angular velocity */
+  COUPLE_INNER = 19, /* inner force and torque computed by PARMEC */
+  COUPLE_OUTER = 25, /* outer force and torque imported from the coupled solver */
+  COUPLE_ARRAYS = 31};
+
+namespace parmec { /* namespace */
+
+/* open co-simulation channel at 'path' for 'count' particles (return 0 on success) */
+int couple_open (const char *path, int count, int *part);
+
+/* publish kinematics and inner forces of coupled particles and wait up to 'timeout'
+ * seconds for the coupled solver to answer with outer forces */
+void couple_exchange (int count, int *part, REAL time, REAL step, REAL *position[6], REAL *rotation[9],
+  REAL *linear[3], REAL *angular[6], REAL *force[3], REAL *torque[3], REAL *outer[6], double timeout);
+
+/* add outer forces to coupled particles */
+void couple_forces (int count, int *part, REAL *outer[6], REAL *force[3], REAL *torque[3]);
+
+/* close co-simulation channel; the coupled solver sees sent == -1 */
+void couple_close ();
+
+} /* namespace */
+
+#endif
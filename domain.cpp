@@ -0,0 +1,1089 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2015 Tomasz Koziara
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+ */
+
+/* Contributors: Tomasz Koziara */
+
+#if PARMEC_MPI
+#define OMPI_SKIP_MPICXX /* C bindings only: REAL is a macro below */
+#define MPICH_SKIP_MPICXX
+#include <mpi.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <float.h>
+#include <algorithm>
+#include <vector>
+#include "macros.h"
+#include "parmec.h"
+#include "output.h"
+#include "domain.h"
+#include "partition_ispc.h"
+
+using namespace ispc;
+
+namespace parmec { /* namespace */
+
+#if PARMEC_MPI
+
+#define SKIN 0.5 /* ghost skin relative to the largest ellipsoid radius */
+#define SAMPLES 32 /* average number of Morton code samples per rank used to split the curve */
+
+enum {PARTICLE_RECORD = 65, /* particle number, material, flags, number of ellipsoids and particle state */
+  ELLIPSOID_RECORD = 28, /* ellipsoid color, centers, radii and orientations */
+  SPRING_RECORD = 18, /* spring number and history dependent spring state */
+  CONTACT_BASE = 18, /* contact point record size less the state size */
+  MOTION_RECORD = 27}; /* ghost position, rotation, velocities, force and torque */
+
+static const int nstate = sizeof (master_conpnt::state) / sizeof (master_conpnt::state[0]); /* see condet.h:NSTATE */
+static const int CONTACT_RECORD = CONTACT_BASE + nstate; /* ellipsoid, slave, colors, point, normal, depth, force, kcur, ecur, state, feature */
+
+static int myrank = 0; /* this rank */
+static int nranks = 1; /* number of ranks */
+static int created = 0; /* distributed data created flag */
+static int parown = 0; /* number of own particles; ghosts follow them */
+static int ellown = 0; /* number of own particles' ellipsoids */
+static int sprown = 0; /* number of springs whose first particle is own */
+static int sprlive = 0; /* number of springs whose particles are present on this rank */
+static REAL skin = 0.0; /* distance within which particles of other ranks are ghosted */
+static std::vector<int> owner; /* particle number to owner rank */
+static std::vector<int> local; /* particle number to local index or -1 */
+static std::vector<char> pinned; /* particles present on all ranks (history sources) */
+static std::vector<int> sprend[2]; /* spring number to particle numbers (-1 for obstacles) */
+static std::vector<std::vector<int> > sendidx; /* own particles ghosted by other ranks */
+static std::vector<std::vector<int> > recvidx; /* ghost particles received from other ranks */
+static std::vector<REAL> anchor; /* own ellipsoid centers at the last rebuild */
+static std::vector<int> published; /* own particles ghosted by any rank */
+static REAL *shared = NULL; /* node-local motion records of all particles, two copies; see domain_exchange */
+static size_t shared_size = 0; /* mapped size */
+static int parity = 0; /* copy written by the next exchange */
+
+/* vector data or NULL */
+template <class T> inline static T* ptr (std::vector<T> &v)
+{
+  return v.empty() ? NULL : &v[0];
+}
+
+/* largest ellipsoid radius */
+inline static REAL ellipsoid_radius (int j)
+{
+  return radii[1][j] < 0.0 ? radii[0][j] : std::max (radii[0][j], std::max (radii[1][j], radii[2][j]));
+}
+
+/* index of the first ellipsoid of particle i; ellipsoids are sorted by particles */
+inline static int first_ellipsoid (int i)
+{
+  return std::lower_bound (part, part+ellnum, i) - part;
+}
+
+/* send buffers to all ranks and receive into 'recv'; data from rank s starts at disp[s] */
+static void alltoall (std::vector<std::vector<double> > &send, std::vector<double> &recv, std::vector<int> &disp)
+{
+  std::vector<int> scount (nranks), sdisp (nranks), rcount (nranks);
+  std::vector<double> sbuf;
+
+  for (int s = 0; s < nranks; s ++)
+  {
+    sdisp[s] = sbuf.size();
+    scount[s] = send[s].size();
+    sbuf.insert (sbuf.end(), send[s].begin(), send[s].end());
+  }
+
+  MPI_Alltoall (&scount[0], 1, MPI_INT, &rcount[0], 1, MPI_INT, MPI_COMM_WORLD);
+
+  disp.assign (nranks+1, 0);
+
+  for (int s = 0; s < nranks; s ++) disp[s+1] = disp[s] + rcount[s];
+
+  recv.resize (disp[nranks]);
+
+  MPI_Alltoallv (ptr (sbuf), &scount[0], &sdisp[0], MPI_DOUBLE, ptr (recv), &rcount[0], &disp[0], MPI_DOUBLE, MPI_COMM_WORLD);
+}
+
+/* write motion record of particle i into 'r' */
+inline static void pack_motion (REAL *r, int i)
+{
+  int k;
+
+  for (k = 0; k < 3; k ++) *(r ++) = position[k][i];
+  for (k = 0; k < 9; k ++) *(r ++) = rotation[k][i];
+  for (k = 0; k < 3; k ++) *(r ++) = linear[k][i];
+  for (k = 0; k < 6; k ++) *(r ++) = angular[k][i];
+  for (k = 0; k < 3; k ++) *(r ++) = force[k][i];
+  for (k = 0; k < 3; k ++) *(r ++) = torque[k][i];
+}
+
+/* read motion record 'r' of particle i */
+inline static void unpack_motion (const REAL *r, int i)
+{
+  int k;
+
+  for (k = 0; k < 3; k ++) position[k][i] = *(r ++);
+  for (k = 0; k < 9; k ++) rotation[k][i] = *(r ++);
+  for (k = 0; k < 3; k ++) linear[k][i] = *(r ++);
+  for (k = 0; k < 6; k ++) angular[k][i] = *(r ++);
+  for (k = 0; k < 3; k ++) force[k][i] = *(r ++);
+  for (k = 0; k < 3; k ++) torque[k][i] = *(r ++);
+}
+
+/* append particle i and its ellipsoids */
+static void pack_particle (std::vector<double> &buf, int i)
+{
+  int j = first_ellipsoid (i), n = std::upper_bound (part+j, part+ellnum, i) - part - j, k;
+
+  buf.push_back (parid[i]);
+  buf.push_back (parmat[i]);
+  buf.push_back (flags[i]);
+  buf.push_back (n);
+  for (k = 0; k < 6; k ++) buf.push_back (angular[k][i]);
+  for (k = 0; k < 3; k ++) buf.push_back (linear[k][i]);
+  for (k = 0; k < 9; k ++) buf.push_back (rotation[k][i]);
+  for (k = 0; k < 6; k ++) buf.push_back (position[k][i]);
+  for (k = 0; k < 9; k ++) buf.push_back (inertia[k][i]);
+  for (k = 0; k < 9; k ++) buf.push_back (inverse[k][i]);
+  buf.push_back (mass[i]);
+  buf.push_back (invm[i]);
+  for (k = 0; k < 3; k ++) buf.push_back (force[k][i]);
+  for (k = 0; k < 3; k ++) buf.push_back (torque[k][i]);
+  for (k = 0; k < 3; k ++) buf.push_back (kact[k][i]);
+  buf.push_back (kmax[i]);
+  buf.push_back (emax[i]);
+  for (k = 0; k < 6; k ++) buf.push_back (krot[k][i]);
+
+  for (; n > 0; n --, j ++)
+  {
+    buf.push_back (ellcol[j]);
+    for (k = 0; k < 6; k ++) buf.push_back (center[k][j]);
+    for (k = 0; k < 3; k ++) buf.push_back (radii[k][j]);
+    for (k = 0; k < 18; k ++) buf.push_back (orient[k][j]);
+  }
+}
+
+/* overwrite a present particle or append a new one from record 'r'; return the number of items read */
+static int unpack_particle (const double *r, int *index)
+{
+  const double *r0 = r;
+  int gid = (int)r[0], n = (int)r[3], i, j, k;
+
+  if ((i = local[gid]) < 0) /* new particle; its ellipsoids go last, which keeps them sorted */
+  {
+    if (parnum >= particle_buffer_size) particle_buffer_grow ();
+
+    i = parnum ++;
+
+    local[gid] = i;
+    parid[i] = gid;
+
+    for (k = 0; k < n; k ++)
+    {
+      if (ellnum >= ellipsoid_buffer_size) ellipsoid_buffer_grow ();
+
+      part[ellnum ++] = i;
+    }
+  }
+
+  parmat[i] = (int)r[1];
+  flags[i] = (int)r[2];
+  r += 4;
+  for (k = 0; k < 6; k ++) angular[k][i] = *(r ++);
+  for (k = 0; k < 3; k ++) linear[k][i] = *(r ++);
+  for (k = 0; k < 9; k ++) rotation[k][i] = *(r ++);
+  for (k = 0; k < 6; k ++) position[k][i] = *(r ++);
+  for (k = 0; k < 9; k ++) inertia[k][i] = *(r ++);
+  for (k = 0; k < 9; k ++) inverse[k][i] = *(r ++);
+  mass[i] = *(r ++);
+  invm[i] = *(r ++);
+  for (k = 0; k < 3; k ++) force[k][i] = *(r ++);
+  for (k = 0; k < 3; k ++) torque[k][i] = *(r ++);
+  for (k = 0; k < 3; k ++) kact[k][i] = *(r ++);
+  kmax[i] = *(r ++);
+  emax[i] = *(r ++);
+  for (k = 0; k < 6; k ++) krot[k][i] = *(r ++);
+
+  for (j = first_ellipsoid (i); n > 0; n --, j ++)
+  {
+    ellcol[j] = (int) *(r ++);
+    for (k = 0; k < 6; k ++) center[k][j] = *(r ++);
+    for (k = 0; k < 3; k ++) radii[k][j] = *(r ++);
+    for (k = 0; k < 18; k ++) orient[k][j] = *(r ++);
+  }
+
+  *index = i;
+
+  return r - r0;
+}
+
+/* append contact point k stored under particle m as seen from its master (flip = 0) or slave particle (flip = 1);
+ * ellipsoids are stored relative to their particles and particles by their numbers */
+static void pack_contact (std::vector<double> &buf, master_conpnt *con, int k, int m, int flip)
+{
+  int l = con->slave[0][k], s = flip ? -1 : 1, j;
+
+  if (flip)
+  {
+    buf.push_back (con->slave[1][k] - first_ellipsoid (l));
+    buf.push_back (parid[m]);
+    buf.push_back (con->master[k] - first_ellipsoid (m));
+  }
+  else
+  {
+    buf.push_back (con->master[k] - first_ellipsoid (m));
+    buf.push_back (l < 0 ? l : parid[l]); /* obstacle code or particle number */
+    buf.push_back (l < 0 ? con->slave[1][k] : con->slave[1][k] - first_ellipsoid (l)); /* -(triangle+1) or ellipsoid */
+  }
+  buf.push_back (con->color[flip][k]);
+  buf.push_back (con->color[!flip][k]);
+  for (j = 0; j < 3; j ++) buf.push_back (con->point[j][k]);
+  for (j = 0; j < 3; j ++) buf.push_back (s*con->normal[j][k]);
+  buf.push_back (con->depth[k]);
+  for (j = 0; j < 3; j ++) buf.push_back (s*con->force[j][k]);
+  buf.push_back (con->kcur[k]);
+  buf.push_back (con->ecur[k]);
+  for (j = 0; j < nstate; j ++) buf.push_back (j < 3 ? s*con->state[j][k] : con->state[j][k]); /* see parmec.cpp:tidy_contacts */
+  buf.push_back (con->feature[k]);
+}
+
+/* store contact record 'c' of master ellipsoid 'ei' of particle i and slave l, el (flip = 0) or the other way around (flip = 1) */
+static void unpack_contact (master_conpnt *con, int k, const double *c, int i, int ei, int l, int el, int flip)
+{
+  int s = flip ? -1 : 1, j;
+
+  con->master[k] = flip ? el : ei;
+  con->slave[0][k] = flip ? i : l;
+  con->slave[1][k] = flip ? ei : el;
+  con->color[flip][k] = (int)c[3];
+  con->color[!flip][k] = (int)c[4];
+  c += 5;
+  for (j = 0; j < 3; j ++) con->point[j][k] = *(c ++);
+  for (j = 0; j < 3; j ++) con->normal[j][k] = s * *(c ++);
+  con->depth[k] = *(c ++);
+  for (j = 0; j < 3; j ++) con->force[j][k] = s * *(c ++);
+  con->kcur[k] = *(c ++);
+  con->ecur[k] = *(c ++);
+  for (j = 0; j < nstate; j ++, c ++) con->state[j][k] = j < 3 ? s * *c : *c;
+  con->feature[k] = (int) *c;
+}
+
+/* find contact point of master ellipsoid 'ei' and slave l, el in the list of particle i */
+static master_conpnt* find_contact (int i, int ei, int l, int el, int *k)
+{
+  for (master_conpnt *con = &master[i]; con; con = con->next)
+  {
+    for (*k = 0; *k < con->size; (*k) ++)
+    {
+      if (con->master[*k] == ei && con->slave[0][*k] == l && con->slave[1][*k] == el) return con;
+    }
+  }
+
+  return NULL;
+}
+
+/* add migrated contact points 'pend' (particle number followed by contact record), replacing present
+ * ones of the same pairs, which may have been computed on a ghost copy for only a part of their history */
+static void resolve_contacts (std::vector<double> &pend)
+{
+  for (size_t p = 0; p < pend.size(); p += 1+CONTACT_RECORD)
+  {
+    const double *c = &pend[p+1];
+    int i = local[(int)pend[p]], code = (int)c[1], l = code < 0 ? code : local[code], ei, el, k, flip = 0;
+
+    if (i < 0 || (code >= 0 && l < 0)) continue; /* slave particle is not present */
+
+    ei = first_ellipsoid (i) + (int)c[0];
+    el = code < 0 ? (int)c[2] : first_ellipsoid (l) + (int)c[2];
+
+    master_conpnt *con = find_contact (i, ei, l, el, &k);
+
+    if (!con && code >= 0 && (con = find_contact (l, el, i, ei, &k))) flip = 1;
+
+    if (!con) con = master_append (&master[i], &k);
+
+    unpack_contact (con, k, c, i, ei, l, el, flip);
+  }
+
+  tidy_contacts (); /* key pairs under smaller particle indices */
+}
+
+/* append the history dependent state of spring i */
+static void pack_spring (std::vector<double> &buf, int i)
+{
+  int k;
+
+  buf.push_back (sprid[i]);
+  buf.push_back (unspring[i]);
+  buf.push_back (sprflg[i]);
+  for (k = 0; k < 6; k ++) buf.push_back (sprdir[k][i]);
+  for (k = 0; k < 3; k ++) buf.push_back (sprsdsp[k][i]);
+  for (k = 0; k < 3; k ++) buf.push_back (stroke[k][i]);
+  for (k = 0; k < 3; k ++) buf.push_back (sprfrc[k][i]);
+}
+
+/* overwrite spring state from record 'r' */
+static void unpack_spring (const double *r)
+{
+  int i = sprmap[(int)r[0]], k;
+
+  unspring[i] = (int)r[1];
+  sprflg[i] = (int)r[2];
+  r += 3;
+  for (k = 0; k < 6; k ++) sprdir[k][i] = *(r ++);
+  for (k = 0; k < 3; k ++) sprsdsp[k][i] = *(r ++);
+  for (k = 0; k < 3; k ++) stroke[k][i] = *(r ++);
+  for (k = 0; k < 3; k ++) sprfrc[k][i] = *(r ++);
+}
+
+/* map springs to local particles; springs whose particles are not all present get
+ * the particle index parnum, so that they are sorted last and not computed */
+static void assign_springs ()
+{
+  sprlive = 0;
+
+  for (int i = 0; i < sprnum; i ++)
+  {
+    int id = sprid[i], a = local[sprend[0][id]], b = sprend[1][id] < 0 ? -1 : local[sprend[1][id]];
+
+    if (a >= 0 && (sprend[1][id] < 0 || b >= 0))
+    {
+      sprpart[0][i] = a;
+      sprpart[1][i] = b;
+      sprlive ++;
+    }
+    else
+    {
+      sprpart[0][i] = parnum;
+      sprpart[1][i] = -1;
+    }
+  }
+
+  if (sprnum) sort_springs ();
+
+  for (sprown = 0; sprown < sprnum && sprpart[0][sprown] < parown; sprown ++);
+}
+
+/* send own particles (own[]) to ranks which need them as ghosts: those within the skin of their own
+ * particles' bounding box, pinned particles and spring partners; on return sendidx[s] lists own
+ * particles ghosted by rank s and recvidx[s] local indices of ghosts received from rank s */
+static void halo (std::vector<int> &own)
+{
+  std::vector<std::vector<double> > send (nranks);
+  std::vector<double> pbox (6*own.size()), box (6*nranks), recv;
+  std::vector<int> disp;
+  double mybox[6] = {DBL_MAX, DBL_MAX, DBL_MAX, -DBL_MAX, -DBL_MAX, -DBL_MAX};
+  int i, j, k, s;
+
+  for (size_t n = 0; n < own.size(); n ++)
+  {
+    double *p = &pbox[6*n];
+
+    for (k = 0; k < 3; k ++)
+    {
+      p[k] = DBL_MAX;
+      p[3+k] = -DBL_MAX;
+    }
+
+    for (i = own[n], j = first_ellipsoid (i); j < ellnum && part[j] == i; j ++)
+    {
+      REAL r = ellipsoid_radius (j);
+
+      for (k = 0; k < 3; k ++)
+      {
+        p[k] = std::min (p[k], (double)(center[k][j]-r));
+        p[3+k] = std::max (p[3+k], (double)(center[k][j]+r));
+      }
+    }
+
+    for (k = 0; k < 3; k ++)
+    {
+      mybox[k] = std::min (mybox[k], p[k]);
+      mybox[3+k] = std::max (mybox[3+k], p[3+k]);
+    }
+  }
+
+  MPI_Allgather (mybox, 6, MPI_DOUBLE, &box[0], 6, MPI_DOUBLE, MPI_COMM_WORLD);
+
+  sendidx.assign (nranks, std::vector<int>());
+
+  for (size_t n = 0; n < own.size(); n ++)
+  {
+    double *p = &pbox[6*n];
+
+    for (s = 0; s < nranks; s ++)
+    {
+      if (s == myrank) continue;
+
+      double *b = &box[6*s];
+
+      if (pinned[parid[own[n]]] ||
+         (p[0]-skin <= b[3] && p[3]+skin >= b[0] &&
+          p[1]-skin <= b[4] && p[4]+skin >= b[1] &&
+          p[2]-skin <= b[5] && p[5]+skin >= b[2])) sendidx[s].push_back (own[n]);
+    }
+  }
+
+  for (size_t id = 0; id < sprend[0].size(); id ++) /* spring partners */
+  {
+    int a = sprend[0][id], b = sprend[1][id];
+
+    if (b < 0 || owner[a] == owner[b]) continue;
+
+    if (owner[a] == myrank) sendidx[owner[b]].push_back (local[a]);
+    else if (owner[b] == myrank) sendidx[owner[a]].push_back (local[b]);
+  }
+
+  for (s = 0; s < nranks; s ++)
+  {
+    std::sort (sendidx[s].begin(), sendidx[s].end());
+
+    sendidx[s].erase (std::unique (sendidx[s].begin(), sendidx[s].end()), sendidx[s].end());
+
+    for (std::vector<int>::iterator it = sendidx[s].begin(); it != sendidx[s].end(); ++ it)
+    {
+      pack_particle (send[s], *it);
+
+      send[s].push_back (0); /* ghosts carry no contact points */
+    }
+  }
+
+  alltoall (send, recv, disp);
+
+  recvidx.assign (nranks, std::vector<int>());
+
+  for (s = 0; s < nranks; s ++)
+  {
+    for (int p = disp[s]; p < disp[s+1]; p ++) /* skipping the zero number of contact points */
+    {
+      p += unpack_particle (&recv[p], &i);
+
+      recvidx[s].push_back (i);
+    }
+  }
+}
+
+/* keep own particles (own[]) in Morton order followed by ghosts; other particles are dropped */
+static void redistribute (int ntasks, std::vector<int> &own)
+{
+  std::vector<REAL> x (own.size()), y (own.size()), z (own.size());
+  std::vector<int> order (own.size());
+  int i, n = own.size(), s;
+
+  for (i = 0; i < n; i ++)
+  {
+    x[i] = position[0][own[i]];
+    y[i] = position[1][own[i]];
+    z[i] = position[2][own[i]];
+  }
+
+  morton_order (ntasks, n, ptr (x), ptr (y), ptr (z), ptr (order));
+
+  for (i = 0; i < n; i ++) order[i] = own[order[i]];
+
+  halo (order);
+
+  std::vector<int> perm (order), inv (parnum, -1);
+
+  for (s = 0; s < nranks; s ++) perm.insert (perm.end(), recvidx[s].begin(), recvidx[s].end());
+
+  for (i = 0; i < (int)perm.size(); i ++) inv[perm[i]] = i;
+
+  for (i = 0; i < sprnum; i ++) sprpart[0][i] = sprpart[1][i] = -1; /* not remapped; see assign_springs */
+
+  reorder_particles (ptr (perm), perm.size(), NULL);
+
+  for (s = 0; s < nranks; s ++)
+  {
+    for (std::vector<int>::iterator it = sendidx[s].begin(); it != sendidx[s].end(); ++ it) *it = inv[*it];
+    for (std::vector<int>::iterator it = recvidx[s].begin(); it != recvidx[s].end(); ++ it) *it = inv[*it];
+  }
+
+  published.clear();
+
+  for (s = 0; s < nranks; s ++) published.insert (published.end(), sendidx[s].begin(), sendidx[s].end());
+
+  std::sort (published.begin(), published.end());
+
+  published.erase (std::unique (published.begin(), published.end()), published.end());
+
+  parown = n;
+
+  ellown = first_ellipsoid (parown);
+
+  std::fill (local.begin(), local.end(), -1);
+
+  for (i = 0; i < parnum; i ++) local[parid[i]] = i;
+
+  assign_springs ();
+
+  anchor.resize (3*ellown);
+
+  for (i = 0; i < ellown; i ++)
+  {
+    anchor[3*i] = center[0][i];
+    anchor[3*i+1] = center[1][i];
+    anchor[3*i+2] = center[2][i];
+  }
+}
+
+/* map node-local memory for motion records of 'n' particles when all ranks run on one machine
+ * and PARMEC_SHM=0 is not set in the environment; return 1 on success, 0 to exchange messages */
+static int shared_open (int n)
+{
+  const char *env = getenv ("PARMEC_SHM");
+  void *map = MAP_FAILED;
+  int size, fd = -1, ok;
+  MPI_Comm node;
+  char name[64];
+  long id;
+
+  if (n == 0 || (env && atoi (env) == 0)) return 0;
+
+  MPI_Comm_split_type (MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, 0, MPI_INFO_NULL, &node);
+  MPI_Comm_size (node, &size);
+  MPI_Comm_free (&node);
+
+  if (size < nranks) return 0; /* ranks on several machines */
+
+  id = getpid ();
+
+  MPI_Bcast (&id, 1, MPI_LONG, 0, MPI_COMM_WORLD);
+
+  snprintf (name, sizeof (name), "/parmec-%ld", id);
+
+  shared_size = (size_t)2*MOTION_RECORD*n*sizeof (REAL);
+
+  if (myrank == 0 && (fd = shm_open (name, O_RDWR|O_CREAT|O_EXCL, 0600)) >= 0 && ftruncate (fd, shared_size) != 0)
+  {
+    close (fd);
+    shm_unlink (name);
+    fd = -1;
+  }
+
+  ok = myrank > 0 || fd >= 0;
+
+  MPI_Bcast (&ok, 1, MPI_INT, 0, MPI_COMM_WORLD);
+
+  if (!ok) return 0;
+
+  if (myrank > 0) fd = shm_open (name, O_RDWR, 0600);
+
+  if (fd >= 0)
+  {
+    map = mmap (NULL, shared_size, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+
+    close (fd);
+  }
+
+  ok = map != MAP_FAILED;
+
+  MPI_Allreduce (MPI_IN_PLACE, &ok, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+
+  if (myrank == 0) shm_unlink (name); /* all ranks hold their mappings now */
+
+  if (!ok)
+  {
+    if (map != MAP_FAILED) munmap (map, shared_size);
+
+    return 0;
+  }
+
+  shared = (REAL*)map;
+  parity = 0;
+
+  return 1;
+}
+
+/* unmap node-local memory */
+static void shared_close ()
+{
+  if (shared) munmap (shared, shared_size);
+
+  shared = NULL;
+  shared_size = 0;
+}
+
+/* initialise MPI */
+void domain_init (int *argc, char ***argv)
+{
+  int provided;
+
+  MPI_Init_thread (argc, argv, MPI_THREAD_FUNNELED, &provided); /* MPI is only called from the main thread */
+
+  MPI_Comm_rank (MPI_COMM_WORLD, &myrank);
+
+  MPI_Comm_size (MPI_COMM_WORLD, &nranks);
+}
+
+/* finalise MPI */
+void domain_finalize ()
+{
+  shared_close ();
+
+  MPI_Finalize ();
+}
+
+/* this rank */
+int domain_rank ()
+{
+  return myrank;
+}
+
+/* number of ranks */
+int domain_size ()
+{
+  return nranks;
+}
+
+/* keep own particles and their ghosts */
+void domain_create (int ntasks)
+{
+  std::vector<int> own;
+  REAL rmax = 0.0;
+  int i, j, n = parnum;
+
+  if (nranks == 1 || created) return;
+
+  ASSERT (ellcon == 0, "Analytical particles are not supported in distributed runs");
+  ASSERT (elenum == 0, "Meshed particles are not supported in distributed runs");
+  ASSERT (trqsprnum == 0 && unsprnum == 0 && jnum == 0, "Torsion springs, unsprings and joints are not supported in distributed runs");
+  ASSERT (rstnum == 0 && prsnum == 0 && cplnum == 0 && !prescribed_body_forces,
+          "Restraints, prescribed motion and coupling are not supported in distributed runs");
+  ASSERT (mrmax == 0, "Multi-rate stepping is not supported in distributed runs");
+  ASSERT (outnum == 0 && !(outformat & OUT_FORMAT_STREAM), "Output lists and streaming are not supported in distributed runs");
+
+  pinned.assign (n, 0);
+
+  for (i = 0; i < hisnum; i ++)
+  {
+    if (hisent[i] == HIS_TIME || h5file[i]) continue;
+
+    ASSERT ((hiskind[i] & (HIS_LIST|HIS_SPHERE|HIS_BOX)) == HIS_LIST && hisent[i] < HIS_LENGTH,
+            "Only time and particle list histories are supported in distributed runs");
+
+    for (j = hisidx[i]; j < hisidx[i+1]; j ++) pinned[parid[hislst[j]]] = 1; /* present on all ranks */
+  }
+
+  for (j = 0; j < 2; j ++) sprend[j].assign (sprnum, -1);
+
+  for (i = 0; i < sprnum; i ++)
+  {
+    ASSERT (sprid[i] < sprnum && sprpart[0][i] >= 0, "Inconsistent spring data");
+
+    sprend[0][sprid[i]] = parid[sprpart[0][i]];
+    sprend[1][sprid[i]] = sprpart[1][i] < 0 ? -1 : parid[sprpart[1][i]];
+  }
+
+  for (j = 0; j < ellnum; j ++) rmax = std::max (rmax, ellipsoid_radius (j));
+
+  skin = SKIN * rmax;
+
+  owner.assign (n, 0);
+
+  if (myrank == 0 && n > 0) /* equal pieces of the Morton curve */
+  {
+    std::vector<int> order (n);
+
+    morton_order (ntasks, n, position[0], position[1], position[2], &order[0]);
+
+    for (i = 0; i < n; i ++) owner[parid[order[i]]] = (int)((long)i*nranks/n);
+  }
+
+  MPI_Bcast (ptr (owner), n, MPI_INT, 0, MPI_COMM_WORLD);
+
+  local.assign (n, -1);
+
+  for (i = 0; i < n; i ++)
+  {
+    local[parid[i]] = i;
+
+    if (owner[parid[i]] == myrank) own.push_back (i);
+  }
+
+  redistribute (ntasks, own);
+
+  shared_open (n);
+
+  /* buffers are reallocated at smaller sizes by parmec.cpp:numa_touch */
+  particle_buffer_size = std::min (particle_buffer_size, std::max (256, 2*parnum));
+  ellipsoid_buffer_size = std::min (ellipsoid_buffer_size, std::max (256, 2*ellnum));
+
+  created = 1;
+}
+
+/* migrate particles and rebuild ghosts */
+int domain_balance (int ntasks, int force)
+{
+  int i, j, s;
+
+  if (nranks == 1 || !created) return 0;
+
+  if (!force) /* rebuild when a particle may have moved more than the skin relative to another */
+  {
+    double d = 0.0, dmax;
+
+    for (j = 0; j < ellown; j ++)
+    {
+      REAL dx = center[0][j]-anchor[3*j], dy = center[1][j]-anchor[3*j+1], dz = center[2][j]-anchor[3*j+2];
+
+      d = std::max (d, (double)(dx*dx+dy*dy+dz*dz));
+    }
+
+    MPI_Allreduce (&d, &dmax, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+
+    if (dmax <= 0.25*skin*skin) return 0;
+  }
+
+  /* Morton codes of own particles within common extents */
+  double e[6] = {DBL_MAX, DBL_MAX, DBL_MAX, DBL_MAX, DBL_MAX, DBL_MAX}, g[6];
+  long mine = parown, total;
+
+  for (i = 0; i < parown; i ++)
+  {
+    for (j = 0; j < 3; j ++)
+    {
+      e[j] = std::min (e[j], (double)position[j][i]);
+      e[3+j] = std::min (e[3+j], -(double)position[j][i]);
+    }
+  }
+
+  MPI_Allreduce (e, g, 6, MPI_DOUBLE, MPI_MIN, MPI_COMM_WORLD);
+
+  MPI_Allreduce (&mine, &total, 1, MPI_LONG, MPI_SUM, MPI_COMM_WORLD);
+
+  if (total == 0) return 0;
+
+  REAL extents[6] = {(REAL)g[0], (REAL)g[1], (REAL)g[2], (REAL)-g[3], (REAL)-g[4], (REAL)-g[5]};
+  std::vector<uint32_t> code (parown);
+  std::vector<int> order (parown);
+
+  morton_codes (ntasks, parown, position[0], position[1], position[2], extents, ptr (code), ptr (order));
+
+  /* splitters from code samples, in numbers proportional to the numbers of own particles */
+  int nsam = parown ? std::max (1L, SAMPLES*nranks*mine/total) : 0;
+  std::vector<int> count (nranks), disp (nranks+1, 0);
+  std::vector<uint32_t> sam (nsam);
+
+  for (i = 0; i < nsam; i ++) sam[i] = code[(long)i*parown/nsam];
+
+  MPI_Allgather (&nsam, 1, MPI_INT, &count[0], 1, MPI_INT, MPI_COMM_WORLD);
+
+  for (s = 0; s < nranks; s ++) disp[s+1] = disp[s] + count[s];
+
+  std::vector<uint32_t> all (disp[nranks]);
+
+  MPI_Allgatherv (ptr (sam), nsam, MPI_UNSIGNED, ptr (all), &count[0], &disp[0], MPI_UNSIGNED, MPI_COMM_WORLD);
+
+  std::sort (all.begin(), all.end());
+
+  std::vector<uint32_t> split (nranks-1);
+
+  for (s = 1; s < nranks; s ++) split[s-1] = all[(long)s*all.size()/nranks];
+
+  std::vector<int> dest (parown), moved;
+
+  for (i = 0; i < parown; i ++)
+  {
+    dest[order[i]] = std::upper_bound (split.begin(), split.end(), code[i]) - split.begin();
+  }
+
+  /* update owners */
+  std::vector<int> oldowner (owner);
+
+  for (i = 0; i < parown; i ++)
+  {
+    if (dest[i] != myrank)
+    {
+      moved.push_back (parid[i]);
+      moved.push_back (dest[i]);
+    }
+  }
+
+  int nmoved = moved.size();
+
+  MPI_Allgather (&nmoved, 1, MPI_INT, &count[0], 1, MPI_INT, MPI_COMM_WORLD);
+
+  for (s = 0; s < nranks; s ++) disp[s+1] = disp[s] + count[s];
+
+  std::vector<int> allmoved (disp[nranks]);
+
+  MPI_Allgatherv (ptr (moved), nmoved, MPI_INT, ptr (allmoved), &count[0], &disp[0], MPI_INT, MPI_COMM_WORLD);
+
+  for (i = 0; i < disp[nranks]; i += 2) owner[allmoved[i]] = allmoved[i+1];
+
+  /* spring states are sent by the previous owner of their first particle to the new owners */
+  std::vector<std::vector<double> > send (nranks);
+  std::vector<double> sprrecv, recv, pend;
+
+  for (i = 0; i < sprlive; i ++)
+  {
+    int id = sprid[i], a = sprend[0][id], b = sprend[1][id];
+
+    if (oldowner[a] != myrank) continue;
+
+    int r0 = owner[a], r1 = b < 0 ? r0 : owner[b];
+
+    if (r0 != myrank) pack_spring (send[r0], i);
+    if (r1 != myrank && r1 != r0) pack_spring (send[r1], i);
+  }
+
+  alltoall (send, sprrecv, disp);
+
+  /* migrating particles take all their contact points along */
+  std::vector<int> slot (parnum, -1);
+  int nmig = 0;
+
+  for (i = 0; i < parown; i ++)
+  {
+    if (dest[i] != myrank) slot[i] = nmig ++;
+  }
+
+  std::vector<std::vector<double> > cons (nmig);
+
+  for (i = 0; i < parnum; i ++)
+  {
+    for (master_conpnt *con = &master[i]; con; con = con->next)
+    {
+      for (int k = 0; k < con->size; k ++)
+      {
+        int l = con->slave[0][k];
+
+        if (slot[i] >= 0) pack_contact (cons[slot[i]], con, k, i, 0);
+        if (l >= 0 && slot[l] >= 0) pack_contact (cons[slot[l]], con, k, i, 1);
+      }
+    }
+  }
+
+  for (s = 0; s < nranks; s ++) send[s].clear();
+
+  for (i = 0; i < parown; i ++)
+  {
+    if (slot[i] < 0) continue;
+
+    std::vector<double> &buf = send[dest[i]], &c = cons[slot[i]];
+
+    pack_particle (buf, i);
+
+    buf.push_back (c.size()/CONTACT_RECORD);
+
+    buf.insert (buf.end(), c.begin(), c.end());
+  }
+
+  alltoall (send, recv, disp);
+
+  for (size_t p = 0; p < recv.size();)
+  {
+    int gid = (int)recv[p];
+
+    p += unpack_particle (&recv[p], &i);
+
+    int m = (int)recv[p ++];
+
+    for (; m > 0; m --, p += CONTACT_RECORD)
+    {
+      pend.push_back (gid);
+
+      pend.insert (pend.end(), recv.begin()+p, recv.begin()+p+CONTACT_RECORD);
+    }
+  }
+
+  /* own particles in Morton order followed by ghosts */
+  std::vector<int> own;
+
+  for (i = 0; i < parnum; i ++)
+  {
+    if (owner[parid[i]] == myrank) own.push_back (i);
+  }
+
+  redistribute (ntasks, own);
+
+  resolve_contacts (pend);
+
+  for (size_t p = 0; p < sprrecv.size(); p += SPRING_RECORD) unpack_spring (&sprrecv[p]);
+
+  return 1;
+}
+
+/* refresh ghost particles; on one machine owners write the motion of published particles into node-local
+ * memory, indexed by particle numbers, and ghosts read it after a barrier; the two copies alternate, so
+ * that a rank writing the next step does not overwrite records another rank may still be reading */
+void domain_exchange ()
+{
+  static std::vector<std::vector<REAL> > sbuf, rbuf;
+  std::vector<MPI_Request> req;
+  int s;
+
+  if (nranks == 1 || !created) return;
+
+  if (shared)
+  {
+    REAL *base = shared + (size_t)parity*MOTION_RECORD*owner.size();
+
+    for (std::vector<int>::iterator it = published.begin(); it != published.end(); ++ it)
+    {
+      pack_motion (base + (size_t)MOTION_RECORD*parid[*it], *it);
+    }
+
+    __sync_synchronize ();
+
+    MPI_Barrier (MPI_COMM_WORLD);
+
+    __sync_synchronize ();
+
+    for (int i = parown; i < parnum; i ++) unpack_motion (base + (size_t)MOTION_RECORD*parid[i], i);
+
+    parity = !parity;
+
+    return;
+  }
+
+  sbuf.resize (nranks);
+  rbuf.resize (nranks);
+  req.reserve (2*nranks);
+
+  for (s = 0; s < nranks; s ++)
+  {
+    if (recvidx[s].empty()) continue;
+
+    rbuf[s].resize (MOTION_RECORD*recvidx[s].size());
+
+    req.push_back (MPI_Request());
+
+    MPI_Irecv (&rbuf[s][0], rbuf[s].size(), MPI_REAL, s, 0, MPI_COMM_WORLD, &req.back());
+  }
+
+  for (s = 0; s < nranks; s ++)
+  {
+    if (sendidx[s].empty()) continue;
+
+    std::vector<REAL> &b = sbuf[s];
+
+    b.resize (MOTION_RECORD*sendidx[s].size());
+
+    for (size_t n = 0; n < sendidx[s].size(); n ++) pack_motion (&b[MOTION_RECORD*n], sendidx[s][n]);
+
+    req.push_back (MPI_Request());
+
+    MPI_Isend (&b[0], b.size(), MPI_REAL, s, 0, MPI_COMM_WORLD, &req.back());
+  }
+
+  MPI_Waitall (req.size(), ptr (req), MPI_STATUSES_IGNORE);
+
+  for (s = 0; s < nranks; s ++)
+  {
+    for (size_t n = 0; n < recvidx[s].size(); n ++) unpack_motion (&rbuf[s][MOTION_RECORD*n], recvidx[s][n]);
+  }
+}
+
+/* minimum across ranks */
+REAL domain_min (REAL value)
+{
+  double v = value, g;
+
+  if (nranks == 1) return value;
+
+  MPI_Allreduce (&v, &g, 1, MPI_DOUBLE, MPI_MIN, MPI_COMM_WORLD);
+
+  return g;
+}
+
+/* number of springs to be computed */
+int domain_springs ()
+{
+  return created ? sprlive : sprnum;
+}
+
+/* write per rank output files */
+void domain_output ()
+{
+  if (!created)
+  {
+    output_files ();
+
+    return;
+  }
+
+  char *path = output_path;
+  int num[3] = {parnum, ellnum, sprnum};
+  std::vector<char> rpath (strlen (path) + 32);
+
+  sprintf (&rpath[0], "%s-rank%d-", path, myrank); /* e.g. out-rank1-1rb.h5 */
+
+  output_path = &rpath[0];
+  parnum = parown;
+  ellnum = ellown;
+  sprnum = sprown;
+
+  output_files ();
+
+  output_path = path;
+  parnum = num[0];
+  ellnum = num[1];
+  sprnum = num[2];
+}
+
+/* reset domain data */
+void domain_reset ()
+{
+  created = 0;
+  parown = ellown = sprown = sprlive = 0;
+  owner.clear();
+  local.clear();
+  pinned.clear();
+  sprend[0].clear();
+  sprend[1].clear();
+  sendidx.clear();
+  recvidx.clear();
+  anchor.clear();
+  published.clear();
+  shared_close ();
+}
+
+#else
+
+void domain_init (int *argc, char ***argv) {}
+
+void domain_finalize () {}
+
+int domain_rank () { return 0; }
+
+int domain_size () { return 1; }
+
+void domain_create (int ntasks) {}
+
+int domain_balance (int ntasks, int force) { return 0; }
+
+void domain_exchange () {}
+
+REAL domain_min (REAL value) { return value; }
+
+int domain_springs () { return sprnum; }
+
+void domain_output () { output_files (); }
+
+void domain_reset () {}
+
+#endif
+
+} /* namespace */
@@ -0,0 +1,77 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2015 Tomasz Koziara
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+ */
+
+/* Contributors: Tomasz Koziara */
+
+#ifndef __domain__
+#define __domain__
+
+namespace parmec { /* namespace */
+
+/* distributed memory runs (compiled with -DPARMEC_MPI, see Config.mak): every rank interprets
+ * the whole input file; at the first DEM call particles are split into contiguous pieces of the
+ * Morton curve, one per rank, and each rank keeps its own particles (first) followed by ghost
+ * copies of the particles owned by other ranks that are within reach of its own; when all ranks
+ * run on one machine, e.g. one rank per socket, ghost motion is read from POSIX shared memory
+ * rather than sent in messages (PARMEC_SHM=0 in the environment disables this); only ghost motion
+ * is shared: each rank still builds its own contact detection and obstacle trees; without MPI,
+ * or on a single rank, the calls below do nothing */
+
+/* initialise MPI */
+void domain_init (int *argc, char ***argv);
+
+/* finalise MPI */
+void domain_finalize ();
+
+/* this rank */
+int domain_rank ();
+
+/* number of ranks */
+int domain_size ();
+
+/* keep own particles and their ghosts; called at the start of DEM, before buffers are touched */
+void domain_create (int ntasks);
+
+/* migrate particles and rebuild ghosts when 'force' is set or when particles moved by more than
+ * half of the ghost skin since the last rebuild; return 1 when particles were renumbered */
+int domain_balance (int ntasks, int force);
+
+/* refresh ghost particles with the current motion of their owners; synchronises all ranks */
+void domain_exchange ();
+
+/* minimum of 'value' across ranks */
+REAL domain_min (REAL value);
+
+/* number of springs to be computed; springs whose particles are not on this rank are sorted last */
+int domain_springs ();
+
+/* write output files; each rank writes its own particles into files with a rank suffix */
+void domain_output ();
+
+/* reset domain data; called by RESET */
+void domain_reset ();
+
+} /* namespace */
+
+#endif
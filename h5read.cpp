@@ -0,0 +1,81 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2015 Tomasz Koziara
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+ */
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <hdf5.h>
+#include <hdf5_hl.h>
+#include "macros.h"
+#include "h5read.h"
+
+/* read .h5 dataset */
+double* h5read (hid_t h5_step, const char *name, int *size, int *width)
+{
+  double *values = NULL;
+
+  /* XXX
+   * if (H5LTfind_dataset(h5_step, name)) is unreliable as
+   * it passes for names being substrings of dataset names;
+   * hence the below workaround */
+
+  hsize_t cur, num;
+  char buf[128];
+  H5Gget_num_objs (h5_step, &num);
+  for (cur = 0; cur < num; cur ++)
+  {
+    H5Gget_objname_by_idx (h5_step, cur, buf, 128);
+    if (strcmp (buf, name) == 0) break;
+  }
+
+  if (cur < num)
+  {
+    int rank;
+    H5LTget_dataset_ndims (h5_step, name, &rank);
+    ASSERT (rank <= 2, "HDF5 file read error: rank > 2");
+    hsize_t dims[2] = {0, 1};
+    H5T_class_t class_id;
+    size_t type_size;
+    H5LTget_dataset_info (h5_step, name, dims, &class_id, &type_size);
+    ASSERT (class_id == H5T_FLOAT, "HDF5 file read error: expected floating point data");
+    ERRMEM (values = (double*)malloc (sizeof(double)*dims[0]*dims[1])); /* single precision is converted on read */
+    ASSERT (H5LTread_dataset_double (h5_step, name, values) >= 0, "HDF5 file read error");
+    if (size) *size = dims[0];
+    if (width) *width = dims[1];
+  }
+  else
+  {
+    if (size) *size = 0;
+    if (width) *width = 0;
+  }
+
+  return values;
+}
+
+/* read .h5 dataset */
+double* h5read (hid_t h5_step, const char *name, int *size)
+{
+  return h5read (h5_step, name, size, NULL);
+}
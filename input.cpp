@@ -37,6 +37,8 @@
 #include "macros.h"
 #include "parmec.h"
 #include "output.h"
+#include "couple.h"
+#include "domain.h"
 #include "timer.h"
 #include "mesh.h"
 #include "constants.h"
@@ -483,6 +485,46 @@ static int is_callable (PyObject *obj, const char *var)
   return 1;
 }
 
+/* test whether obj is a Python function pointer or a tuple of three time series numbers */
+static int is_callable_or_tms (PyObject *obj, const char *var)
+{
+  if (obj)
+  {
+    if (PyTuple_Check (obj))
+    {
+      if (PyTuple_Size (obj) != 3)
+      {
+        char buf [BUFLEN];
+        sprintf (buf, "'%s' tuple size != 3", var);
+        PyErr_SetString (PyExc_ValueError, buf);
+        return 0;
+      }
+
+      for (int i = 0; i < 3; i ++)
+      {
+        int j = PyLong_AsLong (PyTuple_GetItem (obj, i));
+
+        if (j < 0 || j >= tmsnum)
+        {
+          char buf [BUFLEN];
+          sprintf (buf, "'%s' time series number out of range", var);
+          PyErr_SetString (PyExc_ValueError, buf);
+          return 0;
+        }
+      }
+    }
+    else if (!PyCallable_Check (obj))
+    {
+      char buf [BUFLEN];
+      sprintf (buf, "'%s' is neither a tuple nor a callback", var);
+      PyErr_SetString (PyExc_TypeError, buf);
+      return 0;
+    }
+  }
+
+  return 1;
+}
+
 /* test whether an object is a list (details as above) or a number */
 static int is_list_or_number (PyObject *obj, const char *var, int len)
 {
@@ -584,6 +626,7 @@ static PyObject* ARGV (PyObject *self, PyObject *args, PyObject *kwds)
     {
       if (endswith (argv[i], "parmec4")) continue;
       else if (endswith (argv[i], "parmec8")) continue;
+      else if (endswith (argv[i], "parmec48")) continue;
       else if (strcmp (argv[i], "-ntasks") == 0)
       {
         i ++;
@@ -599,6 +642,7 @@ static PyObject* ARGV (PyObject *self, PyObject *args, PyObject *kwds)
     {
       if (endswith (argv[i], "parmec4")) continue;
       else if (endswith (argv[i], "parmec8")) continue;
+      else if (endswith (argv[i], "parmec48")) continue;
       else PyList_Append (list, PyUnicode_FromString (argv[i]));
     }
   }
@@ -622,6 +666,12 @@ static PyObject* RESET (PyObject *self, PyObject *args, PyObject *kwds)
   Py_RETURN_NONE;
 }
 
+/* MPI rank and number of ranks */
+static PyObject* RANK (PyObject *self, PyObject *args, PyObject *kwds)
+{
+  return Py_BuildValue ("(i, i)", domain_rank (), domain_size ());
+}
+
 /* create time series */
 static PyObject* TSERIES (PyObject *self, PyObject *args, PyObject *kwds)
 {
@@ -766,6 +816,8 @@ static PyObject* SPHERE (PyObject *self, PyObject *args, PyObject *kwds)
 
   int i = parnum ++;
 
+  parid[i] = parmap[i] = i;
+
   parmat[i] = material;
 
   part[j] = i;
@@ -836,6 +888,327 @@ static PyObject* SPHERE (PyObject *self, PyObject *args, PyObject *kwds)
   return PyLong_FromLong (i);
 }
 
+/* create ellipsoidal particle */
+static PyObject* ELLIPSOID (PyObject *self, PyObject *args, PyObject *kwds)
+{
+  KEYWORDS ("center", "radii", "material", "color", "orient");
+  PyObject *cen, *rad, *ori;
+  int material, color;
+  REAL r[3], o[9], J[9];
+
+  ori = NULL;
+
+  PARSEKEYS ("OOii|O", &cen, &rad, &material, &color, &ori);
+
+  TYPETEST (is_tuple (cen, kwl[0], 3) && is_tuple (rad, kwl[1], 3) && is_ge_lt (material, 0, matnum, kwl[2]) &&
+      is_positive (color, kwl[3]) && is_tuple (ori, kwl[4], 9));
+
+  for (int k = 0; k < 3; k ++)
+  {
+    r[k] = PyFloat_AsDouble (PyTuple_GetItem (rad, k));
+
+    if (r[k] <= 0.0)
+    {
+      PyErr_SetString (PyExc_ValueError, "'radii' must be positive");
+      return NULL;
+    }
+  }
+
+  if (ori) /* columns are directions of the radii[0], radii[1], radii[2] axes */
+  {
+    for (int k = 0; k < 9; k ++) o[k] = PyFloat_AsDouble (PyTuple_GetItem (ori, k));
+  }
+  else
+  {
+    o[0] = o[4] = o[8] = 1.0;
+    o[1] = o[2] = o[3] = o[5] = o[6] = o[7] = 0.0;
+  }
+
+  if (ellnum >= ellipsoid_buffer_size) ellipsoid_buffer_grow ();
+
+  int j = ellnum ++;
+
+  if (parnum >= particle_buffer_size) particle_buffer_grow ();
+
+  int i = parnum ++;
+
+  parid[i] = parmap[i] = i;
+
+  parmat[i] = material;
+
+  part[j] = i;
+
+  angular[0][i] = 0.0;
+  angular[1][i] = 0.0;
+  angular[2][i] = 0.0;
+
+  linear[0][i] = 0.0;
+  linear[1][i] = 0.0;
+  linear[2][i] = 0.0;
+
+  center[0][j] = position[0][i] = PyFloat_AsDouble (PyTuple_GetItem (cen, 0));
+  center[1][j] = position[1][i] = PyFloat_AsDouble (PyTuple_GetItem (cen, 1));
+  center[2][j] = position[2][i] = PyFloat_AsDouble (PyTuple_GetItem (cen, 2));
+
+  center[3][j] = center[0][j];
+  center[4][j] = center[1][j];
+  center[5][j] = center[2][j];
+
+  position[3][i] = position[0][i];
+  position[4][i] = position[1][i];
+  position[5][i] = position[2][i];
+
+  radii[0][j] = r[0];
+  radii[1][j] = r[1];
+  radii[2][j] = r[2];
+
+  for (int k = 0; k < 9; k ++) orient[k][j] = orient[9+k][j] = o[k];
+
+  ellcol[j] = color;
+
+  double volume = (4./3.)*M_PI*r[0]*r[1]*r[2];
+
+  mass[i] = volume*mparam[DENSITY][material];
+  invm[i] = 1.0/mass[i];
+
+  rotation[0][i] = rotation[4][i] = rotation[8][i] = 1.0;
+  rotation[1][i] = rotation[2][i] = rotation[3][i] =
+    rotation[5][i] = rotation[6][i] = rotation[7][i] = 0.0;
+
+  /* principal moments rotated into the global frame: J = O diag (j) O' */
+  REAL jp[3] = {(REAL)(0.2*mass[i]*(r[1]*r[1]+r[2]*r[2])),
+    (REAL)(0.2*mass[i]*(r[0]*r[0]+r[2]*r[2])), (REAL)(0.2*mass[i]*(r[0]*r[0]+r[1]*r[1]))};
+
+  for (int row = 0; row < 3; row ++)
+  {
+    for (int col = 0; col < 3; col ++)
+    {
+      J[3*col+row] = o[row]*jp[0]*o[col] + o[3+row]*jp[1]*o[3+col] + o[6+row]*jp[2]*o[6+col];
+    }
+  }
+
+  REAL Jiv[9], det;
+  INVERT (J, Jiv, det);
+  for (int k = 0; k < 9; k ++)
+  {
+    inertia[k][i] = J[k];
+    inverse[k][i] = Jiv[k];
+  }
+
+  /* return regular particle */
+  flags[i] = OUTREST;
+
+  return PyLong_FromLong (i);
+}
+
+/* mass properties of a union of overlapping spheres (density one) by voxel integration on
+ * a grid with res cells along the longest edge of the bounding box; overlaps are counted once */
+static void clump_char (int n, REAL *c, REAL *r, int res, REAL *mass, REAL *center, REAL *inertia)
+{
+  REAL lo[3], hi[3], h, dv, me, sx, sy, sz, x[3], d[3];
+  int dim[3], i, j, k, l;
+  char *vox;
+
+  lo[0] = lo[1] = lo[2] = REAL_MAX;
+  hi[0] = hi[1] = hi[2] = -REAL_MAX;
+
+  for (l = 0; l < n; l ++)
+  {
+    for (k = 0; k < 3; k ++)
+    {
+      lo[k] = MIN (lo[k], c[3*l+k]-r[l]);
+      hi[k] = MAX (hi[k], c[3*l+k]+r[l]);
+    }
+  }
+
+  h = MAX (hi[0]-lo[0], MAX (hi[1]-lo[1], hi[2]-lo[2])) / (REAL) res;
+  dv = h*h*h;
+
+  for (k = 0; k < 3; k ++) dim[k] = (int) ceil ((hi[k]-lo[k])/h);
+
+  ERRMEM (vox = (char*)calloc (dim[0]*dim[1]*dim[2], sizeof (char)));
+
+  for (l = 0; l < n; l ++) /* mark voxels whose centers are inside of any sphere */
+  {
+    REAL *p = &c[3*l], rr = r[l]*r[l];
+    int a[3], b[3];
+
+    for (k = 0; k < 3; k ++)
+    {
+      a[k] = MAX (0, (int) floor ((p[k]-r[l]-lo[k])/h));
+      b[k] = MIN (dim[k], (int) ceil ((p[k]+r[l]-lo[k])/h));
+    }
+
+    for (i = a[0]; i < b[0]; i ++)
+    for (j = a[1]; j < b[1]; j ++)
+    for (k = a[2]; k < b[2]; k ++)
+    {
+      x[0] = lo[0] + (i+0.5)*h;
+      x[1] = lo[1] + (j+0.5)*h;
+      x[2] = lo[2] + (k+0.5)*h;
+      SUB (x, p, d);
+      if (DOT (d, d) <= rr) vox[(i*dim[1]+j)*dim[2]+k] = 1;
+    }
+  }
+
+  me = sx = sy = sz = 0.0;
+
+  for (i = 0; i < dim[0]; i ++)
+  for (j = 0; j < dim[1]; j ++)
+  for (k = 0; k < dim[2]; k ++)
+  {
+    if (vox[(i*dim[1]+j)*dim[2]+k])
+    {
+      me += dv;
+      sx += dv*(lo[0] + (i+0.5)*h);
+      sy += dv*(lo[1] + (j+0.5)*h);
+      sz += dv*(lo[2] + (k+0.5)*h);
+    }
+  }
+
+  mass[0] = me;
+  center[0] = sx / me;
+  center[1] = sy / me;
+  center[2] = sz / me;
+
+  SET9 (inertia, 0.0);
+
+  for (i = 0; i < dim[0]; i ++)
+  for (j = 0; j < dim[1]; j ++)
+  for (k = 0; k < dim[2]; k ++)
+  {
+    if (vox[(i*dim[1]+j)*dim[2]+k])
+    {
+      d[0] = lo[0] + (i+0.5)*h - center[0];
+      d[1] = lo[1] + (j+0.5)*h - center[1];
+      d[2] = lo[2] + (k+0.5)*h - center[2];
+      inertia[0] += dv*(d[1]*d[1]+d[2]*d[2]);
+      inertia[4] += dv*(d[0]*d[0]+d[2]*d[2]);
+      inertia[8] += dv*(d[0]*d[0]+d[1]*d[1]);
+      inertia[3] -= dv*d[0]*d[1];
+      inertia[6] -= dv*d[0]*d[2];
+      inertia[7] -= dv*d[1]*d[2];
+    }
+  }
+
+  inertia[1] = inertia[3];
+  inertia[2] = inertia[6];
+  inertia[5] = inertia[7];
+
+  free (vox);
+}
+
+/* create rigid clump of spheres */
+static PyObject* CLUMP (PyObject *self, PyObject *args, PyObject *kwds)
+{
+  KEYWORDS ("centers", "radii", "material", "color", "resolution");
+  int material, color, resolution, n, i, j, k;
+  PyObject *centers, *radlist;
+  REAL *c, *r, mi, ci[3], ii[9];
+
+  resolution = 64;
+
+  PARSEKEYS ("OOii|i", &centers, &radlist, &material, &color, &resolution);
+
+  TYPETEST (is_list (centers, kwl[0], 0) && is_list (radlist, kwl[1], 0) && is_ge_lt (material, 0, matnum, kwl[2]) &&
+      is_positive (color, kwl[3]) && is_positive (resolution, kwl[4]));
+
+  n = PyList_Size (radlist);
+
+  if (n == 0 || PyList_Size (centers) != 3*n)
+  {
+    PyErr_SetString (PyExc_ValueError, "'centers' must hold three coordinates per each of the non-empty 'radii'");
+    return NULL;
+  }
+
+  ERRMEM (c = (REAL*)malloc (3*n * sizeof (REAL)));
+  ERRMEM (r = (REAL*)malloc (n * sizeof (REAL)));
+
+  for (k = 0; k < n; k ++)
+  {
+    c[3*k] = PyFloat_AsDouble (PyList_GetItem (centers, 3*k));
+    c[3*k+1] = PyFloat_AsDouble (PyList_GetItem (centers, 3*k+1));
+    c[3*k+2] = PyFloat_AsDouble (PyList_GetItem (centers, 3*k+2));
+    r[k] = PyFloat_AsDouble (PyList_GetItem (radlist, k));
+
+    if (r[k] <= 0.0)
+    {
+      PyErr_SetString (PyExc_ValueError, "'radii' must be positive");
+      free (c);
+      free (r);
+      return NULL;
+    }
+  }
+
+  clump_char (n, c, r, resolution, &mi, ci, ii);
+
+  if (parnum >= particle_buffer_size) particle_buffer_grow ();
+
+  i = parnum ++;
+
+  parid[i] = parmap[i] = i;
+
+  parmat[i] = material;
+
+  for (k = 0; k < n; k ++) /* spheres share particle i; their mutual contacts are skipped in condet */
+  {
+    if (ellnum >= ellipsoid_buffer_size) ellipsoid_buffer_grow ();
+
+    j = ellnum ++;
+
+    part[j] = i;
+
+    center[0][j] = center[3][j] = c[3*k];
+    center[1][j] = center[4][j] = c[3*k+1];
+    center[2][j] = center[5][j] = c[3*k+2];
+
+    radii[0][j] = r[k];
+    radii[1][j] = -1.0;
+    radii[2][j] = -1.0;
+
+    orient[0][j] = orient[4][j] = orient[8][j] =
+      orient[9][j] = orient[13][j] = orient[17][j] = 1.0;
+    orient[1][j] = orient[2][j] = orient[3][j] =
+      orient[5][j] = orient[6][j] = orient[7][j] =
+      orient[10][j] = orient[11][j] = orient[12][j] =
+      orient[14][j] = orient[15][j] = orient[16][j] = 0.0;
+
+    ellcol[j] = color;
+  }
+
+  angular[0][i] = 0.0;
+  angular[1][i] = 0.0;
+  angular[2][i] = 0.0;
+
+  linear[0][i] = 0.0;
+  linear[1][i] = 0.0;
+  linear[2][i] = 0.0;
+
+  position[0][i] = position[3][i] = ci[0];
+  position[1][i] = position[4][i] = ci[1];
+  position[2][i] = position[5][i] = ci[2];
+
+  mass[i] = mi*mparam[DENSITY][material];
+  invm[i] = 1.0/mass[i];
+
+  rotation[0][i] = rotation[4][i] = rotation[8][i] = 1.0;
+  rotation[1][i] = rotation[2][i] = rotation[3][i] =
+    rotation[5][i] = rotation[6][i] = rotation[7][i] = 0.0;
+
+  REAL J[9], Jiv[9], det;
+  for (k = 0; k < 9; k ++) J[k] = inertia[k][i] = ii[k]*mparam[DENSITY][material];
+  INVERT (J, Jiv, det);
+  for (k = 0; k < 9; k ++) inverse[k][i] = Jiv[k];
+
+  free (c);
+  free (r);
+
+  /* return regular particle */
+  flags[i] = OUTREST;
+
+  return PyLong_FromLong (i);
+}
+
 /* create meshed particle */
 static PyObject* MESH (PyObject *self, PyObject *args, PyObject *kwds)
 {
@@ -1092,6 +1465,8 @@ static PyObject* MESH (PyObject *self, PyObject *args, PyObject *kwds)
 
   i = parnum ++;
 
+  parid[i] = parmap[i] = i;
+
   parmat[i] = material;
 
   angular[0][i] = 0.0;
@@ -1240,6 +1615,8 @@ static PyObject* ANALYTICAL (PyObject *self, PyObject *args, PyObject *kwds)
 
     i = particle = parnum ++;
 
+    parid[i] = parmap[i] = i;
+
     parmat[i] = material;
 
     angular[0][i] = 0.0;
@@ -1377,8 +1754,8 @@ static PyObject* OBSTACLE (PyObject *self, PyObject *args, PyObject *kwds)
 
   TYPETEST (is_list_of_tuples (triangles, kwl[0], 1, 9) &&
       is_positive_or_list (color, kwl[1], PyList_Size(triangles)) &&
-      is_tuple (point, kwl[2], 3) && is_callable (lin, kwl[3]) &&
-      is_callable (ang, kwl[4]));
+      is_tuple (point, kwl[2], 3) && is_callable_or_tms (lin, kwl[3]) &&
+      is_callable_or_tms (ang, kwl[4]));
 
   int m = PyList_Size (triangles);
 
@@ -1397,8 +1774,14 @@ static PyObject* OBSTACLE (PyObject *self, PyObject *args, PyObject *kwds)
     obspnt[3*i+1] = PyFloat_AsDouble (PyTuple_GetItem (point, 1)); 
     obspnt[3*i+2] = PyFloat_AsDouble (PyTuple_GetItem (point, 2)); 
 
-    linhis[i] = lin;
-    anghis[i] = ang;
+    linhis[i] = lin && PyCallable_Check (lin) ? lin : NULL;
+    anghis[i] = ang && PyCallable_Check (ang) ? ang : NULL;
+
+    for (int k = 0; k < 3; k ++)
+    {
+      lintms[k][i] = lin && PyTuple_Check (lin) ? PyLong_AsLong (PyTuple_GetItem (lin, k)) : -1;
+      angtms[k][i] = ang && PyTuple_Check (ang) ? PyLong_AsLong (PyTuple_GetItem (ang, k)) : -1;
+    }
 
     haveobs = 1;
   }
@@ -1430,7 +1813,7 @@ static PyObject* OBSTACLE (PyObject *self, PyObject *args, PyObject *kwds)
       tricol[i] = PyLong_AsLong (color);
     }
 
-    triobs[i] = haveobs ? -obsnum-2 : -1; /* <0 - moving obstalce (-index-2), -1 - static obstacle, >= 0 - triangulated particle */
+    triobs[i] = haveobs ? -obsnum-1 : -1; /* <0 - moving obstalce (-index-2), -1 - static obstacle, >= 0 - triangulated particle */
   }
 
   Py_RETURN_NONE;
@@ -1538,9 +1921,9 @@ static PyObject* SPRING (PyObject *self, PyObject *args, PyObject *kwds)
     sprpnt[1][4][i] = sprpnt[1][1][i];
     sprpnt[1][5][i] = sprpnt[1][2][i];
 
-    REAL dir[3] = {PyFloat_AsDouble (PyTuple_GetItem (normal,0)),
-      PyFloat_AsDouble (PyTuple_GetItem (normal,1)),
-      PyFloat_AsDouble (PyTuple_GetItem (normal,2))};
+    REAL dir[3] = {(REAL) PyFloat_AsDouble (PyTuple_GetItem (normal,0)),
+      (REAL) PyFloat_AsDouble (PyTuple_GetItem (normal,1)),
+      (REAL) PyFloat_AsDouble (PyTuple_GetItem (normal,2))};
 
     NORMALIZE (dir);
 
@@ -1872,12 +2255,12 @@ static PyObject* TORSION_SPRING (PyObject *self, PyObject *args, PyObject *kwds)
   trqsprpart[0][i] = part1;
   trqsprpart[1][i] = part2;
 
-  REAL zdir0[3] = {PyFloat_AsDouble (PyTuple_GetItem (zdir,0)),
-    PyFloat_AsDouble (PyTuple_GetItem (zdir,1)),
-    PyFloat_AsDouble (PyTuple_GetItem (zdir,2))};
-  REAL xdir0[3] = {PyFloat_AsDouble (PyTuple_GetItem (xdir,0)),
-    PyFloat_AsDouble (PyTuple_GetItem (xdir,1)),
-    PyFloat_AsDouble (PyTuple_GetItem (xdir,2))};
+  REAL zdir0[3] = {(REAL) PyFloat_AsDouble (PyTuple_GetItem (zdir,0)),
+    (REAL) PyFloat_AsDouble (PyTuple_GetItem (zdir,1)),
+    (REAL) PyFloat_AsDouble (PyTuple_GetItem (zdir,2))};
+  REAL xdir0[3] = {(REAL) PyFloat_AsDouble (PyTuple_GetItem (xdir,0)),
+    (REAL) PyFloat_AsDouble (PyTuple_GetItem (xdir,1)),
+    (REAL) PyFloat_AsDouble (PyTuple_GetItem (xdir,2))};
   REAL ydir0[3];
 
   REAL zlen0 = LEN(zdir0), xlen0 = LEN(zdir0);
@@ -2327,6 +2710,8 @@ static PyObject* BALL_JOINT (PyObject *self, PyObject *args, PyObject *kwds)
   jpoint[1][i] = PyFloat_AsDouble(PyTuple_GetItem (point, 1));
   jpoint[2][i] = PyFloat_AsDouble(PyTuple_GetItem (point, 2));
 
+  jreac[0][i] = jreac[1][i] = jreac[2][i] = 0.0; /* iterative solver initial guess */
+
   joints_changed = 1;
 
   return PyLong_FromLong (i);
@@ -3559,18 +3944,140 @@ static PyObject* HISTORY (PyObject *self, PyObject *args, PyObject *kwds)
 /* declare output entities */
 static PyObject* OUTPUT (PyObject *self, PyObject *args, PyObject *kwds)
 {
-  KEYWORDS ("entities", "subset", "mode", "format");
-  PyObject *entities, *subset, *mode, *format;
+  KEYWORDS ("entities", "subset", "mode", "format", "region", "decimate", "precision", "stream");
+  PyObject *entities, *subset, *mode, *format, *region, *decimate, *precision, *stream;
+  REAL reg[6] = {0., 0., 0., 0., 0., 0.};
+  int roi = OUT_ROI_NONE, dec[2];
 
   subset = NULL;
   mode = NULL;
   format = NULL;
   entities = NULL;
+  region = NULL;
+  decimate = NULL;
+  precision = NULL;
+  stream = NULL;
 
-  PARSEKEYS ("|OOOO", &entities, &subset, &mode, &format);
+  PARSEKEYS ("|OOOOOOOO", &entities, &subset, &mode, &format, &region, &decimate, &precision, &stream);
 
   TYPETEST (is_list (entities, kwl[0], 0) && is_list_or_number (subset, kwl[1], 0) &&
-      is_string_or_list (mode, kwl[2]) && is_string_or_list (format, kwl[3]));
+      is_string_or_list (mode, kwl[2]) && is_string_or_list (format, kwl[3]) &&
+      is_tuple (region, kwl[4], 0) && is_string (stream, kwl[7]));
+
+  if (stream) output_stream_path (PyUnicode_AsUTF8 (stream));
+
+  if (precision)
+  {
+    if (!PyTuple_Check (precision) && !PyList_Check (precision))
+    {
+      PyErr_SetString (PyExc_TypeError, "'precision' must be a tuple or a list of tuples");
+      return NULL;
+    }
+
+    int n = PyTuple_Check (precision) ? 1 : PyList_Size (precision);
+
+    for (int j = 0; j < n; j ++)
+    {
+      PyObject *item = PyTuple_Check (precision) ? precision : PyList_GetItem (precision, j);
+      int size = PyTuple_Check (item) ? PyTuple_Size (item) : 0, kind;
+      double error = 0.0;
+
+      if (size < 2 || size > 3 || !PyUnicode_Check (PyTuple_GetItem (item, 0)) || !PyUnicode_Check (PyTuple_GetItem (item, 1)))
+      {
+        PyErr_SetString (PyExc_ValueError, "Invalid precision tuple: (dataset, kind) or (dataset, kind, error) expected");
+        return NULL;
+      }
+
+      PyObject *name = PyTuple_GetItem (item, 0), *what = PyTuple_GetItem (item, 1);
+
+      IFIS (what, "DOUBLE")
+      {
+        kind = OUT_PRECISION_DOUBLE;
+      }
+      ELIF (what, "FLOAT")
+      {
+        kind = OUT_PRECISION_FLOAT;
+      }
+      ELIF (what, "SCALED")
+      {
+        kind = OUT_PRECISION_SCALED;
+      }
+      ELIF (what, "DELTA")
+      {
+        kind = OUT_PRECISION_DELTA;
+      }
+      ELSE
+      {
+        PyErr_SetString (PyExc_ValueError, "Invalid precision kind");
+        return NULL;
+      }
+
+      if (size == 3) error = PyFloat_AsDouble (PyTuple_GetItem (item, 2));
+
+      if (kind == OUT_PRECISION_SCALED)
+      {
+        TYPETEST (is_positive (error, "precision error"));
+      }
+      else
+      {
+        TYPETEST (is_non_negative (error, "precision error"));
+      }
+
+      output_precision (PyUnicode_AsUTF8 (name), kind, error);
+    }
+  }
+
+  if (region)
+  {
+    if (PyTuple_Size (region) == 4)
+    {
+      for (int j = 0; j < 4; j ++) reg[j] = PyFloat_AsDouble (PyTuple_GetItem (region, j));
+      TYPETEST (is_positive (reg[3], "region radius"));
+      roi = OUT_ROI_SPHERE;
+    }
+    else if (PyTuple_Size (region) == 6)
+    {
+      for (int j = 0; j < 6; j ++) reg[j] = PyFloat_AsDouble (PyTuple_GetItem (region, j));
+      if (reg[0] > reg[3] || reg[1] > reg[4] || reg[2] > reg[5])
+      {
+        PyErr_SetString (PyExc_ValueError, "Invalid region box: minimum corner exceeds maximum corner");
+        return NULL;
+      }
+      roi = OUT_ROI_BOX;
+    }
+    else
+    {
+      PyErr_SetString (PyExc_ValueError, "Invalid region tuple size");
+      return NULL;
+    }
+  }
+
+  dec[0] = 1;
+  dec[1] = region ? 0 : 1; /* by default only the region of interest is output */
+
+  if (decimate)
+  {
+    if (PyTuple_Check (decimate) && PyTuple_Size (decimate) == 2)
+    {
+      dec[0] = PyLong_AsLong (PyTuple_GetItem (decimate, 0));
+      dec[1] = PyLong_AsLong (PyTuple_GetItem (decimate, 1));
+    }
+    else if (PyLong_Check (decimate))
+    {
+      dec[0] = dec[1] = PyLong_AsLong (decimate);
+    }
+    else
+    {
+      PyErr_SetString (PyExc_TypeError, "'decimate' must be an integer or a tuple of two integers");
+      return NULL;
+    }
+
+    if (dec[0] < 1 || dec[1] < 0)
+    {
+      PyErr_SetString (PyExc_ValueError, "Invalid decimation: inside level must be >= 1 and outside level >= 0");
+      return NULL;
+    }
+  }
 
   int list_size = 0;
 
@@ -3611,6 +4118,27 @@ static PyObject* OUTPUT (PyObject *self, PyObject *args, PyObject *kwds)
 
   outidx[i+1] = outidx[i];
 
+  if (subset)
+  {
+    outroi[i] = roi;
+    for (int j = 0; j < 6; j ++) outreg[j][i] = reg[j];
+    outdec[0][i] = dec[0];
+    outdec[1][i] = dec[1];
+  }
+  else
+  {
+    outroi[i] = OUT_ROI_NONE;
+    outdec[0][i] = outdec[1][i] = 1;
+
+    if (region || decimate)
+    {
+      outrestroi = roi;
+      for (int j = 0; j < 6; j ++) outrestreg[j] = reg[j];
+      outrestdec[0] = dec[0];
+      outrestdec[1] = dec[1];
+    }
+  }
+
   if (subset)
   {
     if (PyList_Check (subset))
@@ -3912,6 +4440,10 @@ static PyObject* OUTPUT (PyObject *self, PyObject *args, PyObject *kwds)
       {
         parmec::outformat = OUT_FORMAT_MED;
       }
+      ELIF (format, "STREAM")
+      {
+        parmec::outformat = OUT_FORMAT_STREAM;
+      }
       ELSE
       {
         PyErr_SetString (PyExc_ValueError, "Invalid format");
@@ -3942,6 +4474,10 @@ static PyObject* OUTPUT (PyObject *self, PyObject *args, PyObject *kwds)
         {
           parmec::outformat |= OUT_FORMAT_MED;
         }
+        ELIF (item, "STREAM")
+        {
+          parmec::outformat |= OUT_FORMAT_STREAM;
+        }
         ELSE
         {
           PyErr_SetString (PyExc_ValueError, "Invalid format");
@@ -3954,12 +4490,74 @@ static PyObject* OUTPUT (PyObject *self, PyObject *args, PyObject *kwds)
   Py_RETURN_NONE;
 }
 
+/* couple particles with an external solver through a shared memory channel */
+static PyObject* COUPLE (PyObject *self, PyObject *args, PyObject *kwds)
+{
+  KEYWORDS ("particles", "path", "interval", "timeout");
+  PyObject *particles, *path;
+  double timeout;
+  int interval, n, i, j;
+
+  interval = 1;
+  timeout = 60.0;
+
+  PARSEKEYS ("OO|id", &particles, &path, &interval, &timeout);
+
+  TYPETEST (is_list (particles, kwl[0], 0) && is_string (path, kwl[1]) &&
+      is_positive (interval, kwl[2]) && is_positive (timeout, kwl[3]));
+
+  n = PyList_Size (particles);
+
+  if (n == 0)
+  {
+    PyErr_SetString (PyExc_ValueError, "Empty particle list");
+    return NULL;
+  }
+
+  int *part = new int[n];
+
+  for (i = 0; i < n; i ++)
+  {
+    part[i] = PyLong_AsLong (PyList_GetItem (particles, i));
+
+    if (part[i] < 0 || part[i] >= parnum)
+    {
+      PyErr_SetString (PyExc_ValueError, "Particle index out of range");
+      delete [] part;
+      return NULL;
+    }
+  }
+
+  if (couple_open (PyUnicode_AsUTF8 (path), n, part) != 0)
+  {
+    PyErr_SetString (PyExc_ValueError, "Co-simulation channel open failed");
+    delete [] part;
+    return NULL;
+  }
+
+  delete [] cplpart;
+  cplpart = part;
+  cplnum = n;
+  cplevery = interval;
+  cpltimeout = timeout;
+
+  for (j = 0; j < 6; j ++)
+  {
+    delete [] cplouter[j];
+    cplouter[j] = new REAL[n];
+    for (i = 0; i < n; i ++) cplouter[j][i] = 0.0;
+  }
+
+  Py_RETURN_NONE;
+}
+
 /* run DEM simulation */
 static PyObject* DEM (PyObject *self, PyObject *args, PyObject *kwds)
 {
-  KEYWORDS ("duration", "step", "interval", "prefix", "adaptive");
-  double duration, step, adaptive;
-  PyObject *prefix, *interval;
+  KEYWORDS ("duration", "step", "interval", "prefix", "adaptive", "jtol", "multirate", "verbose", "trace", "reorder");
+  double duration, step, adaptive, tol;
+  int multirate, verbose, order;
+  PyObject *prefix, *interval, *trace;
   pointer_t dt_func[2];
   int dt_tms[2];
   REAL dt[2];
@@ -3968,11 +4566,28 @@ static PyObject* DEM (PyObject *self, PyObject *args, PyObject *kwds)
   prefix = NULL;
   interval = NULL;
   adaptive = 0.0;
+  tol = 0.0;
+  multirate = 0;
+  verbose = 1;
+  trace = NULL;
+  order = 0;
 
-  PARSEKEYS ("dd|OOd", &duration, &step, &interval, &prefix, &adaptive);
+  PARSEKEYS ("dd|OOddiiOi", &duration, &step, &interval, &prefix, &adaptive, &tol, &multirate, &verbose, &trace, &order);
 
   TYPETEST (is_positive (duration, kwl[0]) && is_positive (step, kwl[1]) &&
-      is_string (prefix, kwl[3]) && is_ge_le (adaptive, 0.0, 1.0, kwl[4]));
+      is_string (prefix, kwl[3]) && is_ge_le (adaptive, 0.0, 1.0, kwl[4]) &&
+      is_ge_lt (tol, 0.0, 1.0, kwl[5]) && is_ge_le (multirate, 0, 16, kwl[6]) &&
+      is_ge_le (verbose, 0, 2, kwl[7]) && is_string (trace, kwl[8]) && is_non_negative (order, kwl[9]));
+
+  if (multirate > 0 && adaptive > 0.0)
+  {
+    PyErr_SetString (PyExc_ValueError, "'multirate' and 'adaptive' stepping cannot be combined");
+    return NULL;
+  }
+
+  jtol = tol;
+  mrmax = multirate;
+  reorder = order;
 
   if (interval)
   {
@@ -4085,18 +4700,49 @@ static PyObject* DEM (PyObject *self, PyObject *args, PyObject *kwds)
   }
   else pre = NULL;
 
-  duration = dem (duration, step, dt, dt_func, dt_tms, pre, 1, adaptive);
+  trace_path = trace ? (char*)PyUnicode_AsUTF8 (trace) : NULL;
+
+  duration = dem (duration, step, dt, dt_func, dt_tms, pre, verbose, adaptive);
+
+  trace_path = NULL;
 
   return Py_BuildValue ("d", duration); /* PyFloat_FromDouble (dt) */
 }
 
+/* return cumulative phase timers and performance counters */
+static PyObject* TIMERS (PyObject *self, PyObject *args, PyObject *kwds)
+{
+  PyObject *dict, *item;
+
+  ERRMEM (dict = PyDict_New ());
+
+  for (int i = 0; i < NPHASE; i ++)
+  {
+    item = PyFloat_FromDouble (phase_time[i]);
+    PyDict_SetItemString (dict, phase_name[i], item);
+    Py_DECREF (item);
+  }
+
+  for (int i = 0; i < NCOUNT; i ++)
+  {
+    item = PyLong_FromLong (count_total[i]);
+    PyDict_SetItemString (dict, count_name[i], item);
+    Py_DECREF (item);
+  }
+
+  return dict;
+}
+
 static PyMethodDef methods [] =
 {
   {"ARGV", (PyCFunction)ARGV, METH_VARARGS|METH_KEYWORDS, "Command line arguments"},
   {"RESET", (PyCFunction)RESET, METH_NOARGS, "Reset simulation"},
+  {"RANK", (PyCFunction)RANK, METH_NOARGS, "MPI rank and number of ranks"},
   {"TSERIES", (PyCFunction)TSERIES, METH_VARARGS|METH_KEYWORDS, "Create time series"},
   {"MATERIAL", (PyCFunction)MATERIAL, METH_VARARGS|METH_KEYWORDS, "Create material"},
   {"SPHERE", (PyCFunction)SPHERE, METH_VARARGS|METH_KEYWORDS, "Create spherical particle"},
+  {"ELLIPSOID", (PyCFunction)ELLIPSOID, METH_VARARGS|METH_KEYWORDS, "Create ellipsoidal particle"},
+  {"CLUMP", (PyCFunction)CLUMP, METH_VARARGS|METH_KEYWORDS, "Create rigid clump of spheres"},
   {"MESH", (PyCFunction)MESH, METH_VARARGS|METH_KEYWORDS, "Create meshed particle"},
   {"ANALYTICAL", (PyCFunction)::ANALYTICAL, METH_VARARGS|METH_KEYWORDS, "Create analytical particle"},
   {"OBSTACLE", (PyCFunction)OBSTACLE, METH_VARARGS|METH_KEYWORDS, "Create obstacle"},
@@ -4114,7 +4760,9 @@ static PyMethodDef methods [] =
   {"CRITICAL", (PyCFunction)CRITICAL, METH_VARARGS|METH_KEYWORDS, "Estimate critical time step"},
   {"HISTORY", (PyCFunction)HISTORY, METH_VARARGS|METH_KEYWORDS, "Time history output"},
   {"OUTPUT", (PyCFunction)OUTPUT, METH_VARARGS|METH_KEYWORDS, "Declare output entities"},
+  {"COUPLE", (PyCFunction)COUPLE, METH_VARARGS|METH_KEYWORDS, "Couple particles with an external solver"},
   {"DEM", (PyCFunction)DEM, METH_VARARGS|METH_KEYWORDS, "Run DEM simulation"},
+  {"TIMERS", (PyCFunction)TIMERS, METH_NOARGS, "Phase timers and performance counters"},
   {NULL, 0, 0, NULL}
 };
 
@@ -4163,9 +4811,12 @@ namespace parmec
 
     PyRun_SimpleString ("from parmec import ARGV\n"
         "from parmec import RESET\n"
+        "from parmec import RANK\n"
         "from parmec import TSERIES\n"
         "from parmec import MATERIAL\n"
         "from parmec import SPHERE\n"
+        "from parmec import ELLIPSOID\n"
+        "from parmec import CLUMP\n"
         "from parmec import MESH\n"
         "from parmec import ANALYTICAL\n"
         "from parmec import OBSTACLE\n"
@@ -4183,7 +4834,9 @@ namespace parmec
         "from parmec import CRITICAL\n"
         "from parmec import HISTORY\n"
         "from parmec import OUTPUT\n"
-        "from parmec import DEM\n");
+        "from parmec import COUPLE\n"
+        "from parmec import DEM\n"
+        "from parmec import TIMERS\n");
 
     ERRMEM (line = new char [128 + strlen (path)]);
     sprintf (line, "exec(open('%s').read())", path);
@@ -4195,12 +4848,39 @@ namespace parmec
     return error;
   }
 
-  /* update obstacles time histories from callbacks */
-  void obstaclev (int obsnum, REAL *obsang, REAL *obslin, pointer_t anghis[], pointer_t linhis[], REAL time)
+  /* update obstacles time histories from callbacks and time series */
+  void obstaclev (int obsnum, REAL *obsang, REAL *obslin, pointer_t anghis[], pointer_t linhis[],
+                  int *angtms[3], int *lintms[3], REAL time)
   {
     PyObject *result, *args;
     int i;
 
+    /* time series lookups move series markers, hence each series is evaluated once */
+    std::vector<REAL> tmsval (tmsnum);
+    std::vector<char> tmsset (tmsnum, 0);
+    for (i = 0; i < obsnum; i ++)
+    {
+      for (int k = 0; k < 3; k ++)
+      {
+        if (angtms[k][i] >= 0) tmsset[angtms[k][i]] = 1;
+        if (lintms[k][i] >= 0) tmsset[lintms[k][i]] = 1;
+      }
+    }
+    for (i = 0; i < tmsnum; i ++)
+    {
+      if (tmsset[i]) tmsval[i] = TMS_Value ((TMS*)tms[i], time);
+    }
+
+    #pragma omp parallel for if (obsnum > 256)
+    for (i = 0; i < obsnum; i ++)
+    {
+      for (int k = 0; k < 3; k ++)
+      {
+        obsang[3*i+k] = angtms[k][i] >= 0 ? tmsval[angtms[k][i]] : 0.0;
+        obslin[3*i+k] = lintms[k][i] >= 0 ? tmsval[lintms[k][i]] : 0.0;
+      }
+    }
+
     args = Py_BuildValue ("(d)", time);
 
     for (i = 0; i < obsnum; i ++, obsang += 3, obslin += 3)
@@ -4217,10 +4897,6 @@ namespace parmec
 
         Py_DECREF (result);
       }
-      else
-      {
-        SET (obsang, 0.0);
-      }
 
       if (linhis[i])
       {
@@ -4234,10 +4910,6 @@ namespace parmec
 
         Py_DECREF (result);
       }
-      else
-      {
-        SET (obslin, 0.0);
-      }
     }
 
     Py_DECREF (args);
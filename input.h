@@ -28,7 +28,8 @@
 namespace parmec
 {
   /* update obstacles time histories from callbacks */
-  void obstaclev (int obsnum, REAL *obsang, REAL *obslin, pointer_t anghis[], pointer_t linhis[], REAL time);
+  void obstaclev (int obsnum, REAL *obsang, REAL *obslin, pointer_t anghis[], pointer_t linhis[],
+                  int *angtms[3], int *lintms[3], REAL time);
 
   /* prescribe particle velocity */
   void prescribe_velocity (int prsnum, pointer_t tms[], int prspart[], pointer_t prslin[], int *tmslin[3], int linkind[],
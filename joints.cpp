@@ -26,12 +26,7 @@
 
 #include <vector>
 #include <tuple>
-#include <map>
-#include <set>
-
-#if defined(_OPENMP)
-#include <omp.h>
-#endif
+#include <algorithm>
 
 #include "macros.h"
 #include "joints.h"
@@ -39,18 +34,183 @@
 
 #if SUITESPARSE
 #include "SuiteSparseQR.hpp"
-#else
-#include "amgcl.hpp"
 #endif
+#include "amgcl.hpp"
 
 namespace parmec {
 
 #if SUITESPARSE
-  typedef SuiteSparseQR_factorization <REAL> Solver; /* QR factorization */
   typedef SuiteSparse_long Long;
+
+  struct Solver /* QR factorization with reusable symbolic analysis */
+  {
+    cholmod_common cc;
+    SuiteSparseQR_factorization <REAL> *QR;
+
+    Solver (cholmod_sparse *A) /* symbolic analysis */
+    {
+      cholmod_l_start (&cc);
+      QR = SuiteSparseQR_symbolic <REAL> (SPQR_ORDERING_DEFAULT, 1, A, &cc); /* allow rank detection */
+      ASSERT (QR, "SuiteSparseQR symbolic analysis has failed");
+    }
+
+    ~Solver ()
+    {
+      SuiteSparseQR_free (&QR, &cc);
+      cholmod_l_finish (&cc);
+    }
+
+    void factorize (cholmod_sparse *A) /* numeric factorization */
+    {
+      ASSERT (SuiteSparseQR_numeric <REAL> (SPQR_DEFAULT_TOL, A, QR, &cc), "SuiteSparseQR numeric factorization has failed");
+    }
+  };
 #else 
-  typedef amgcl::solver::skyline_lu<REAL> Solver; /* LU factorization */
   typedef ptrdiff_t Long;
+
+  /* skyline LU factorization, after amgcl::solver::skyline_lu, with the ordering
+   * and the skyline profile computed once per sparsity pattern */
+  struct Solver
+  {
+    int n; /* system size */
+    std::vector<int> perm; /* Cuthill-McKee ordering */
+    std::vector<int> ptr; /* skyline row and column pointers */
+    std::vector<int> dst; /* CRS value index to skyline storage index */
+    std::vector<REAL> LUD; /* skyline storage: L, U and D */
+    REAL *L, *U, *D;
+    std::vector<REAL> y; /* solution work vector */
+
+    Solver (Long num, std::vector<Long> &rowptr, std::vector<Long> &col) /* symbolic analysis */
+      : n(num), perm(num), ptr(num+1, 0), dst(rowptr[num]), y(num)
+    {
+      std::vector<REAL> val(rowptr[n], 0.);
+      auto A = amgcl::adapter::zero_copy(n, rowptr.data(), col.data(), val.data());
+
+      amgcl::reorder::cuthill_mckee<false>::get(*A, perm);
+
+      std::vector<int> invperm(n);
+      for (int i = 0; i < n; i ++) invperm[perm[i]] = i;
+
+      /* row lengths of L and column heights of U */
+      for (int i = 0; i < n; i ++)
+      {
+        for (Long k = rowptr[i]; k < rowptr[i+1]; k ++)
+        {
+          int newi = invperm[i], newj = invperm[col[k]];
+
+          if (newi > newj && ptr[newi] < newi - newj) ptr[newi] = newi - newj;
+          else if (newi < newj && ptr[newj] < newj - newi) ptr[newj] = newj - newi;
+        }
+      }
+
+      for (int i = 1, last = 0; i <= n; i ++)
+      {
+        int tmp = ptr[i];
+        ptr[i] = ptr[i-1] + last;
+        last = tmp;
+      }
+
+      int size = ptr[n];
+      LUD.resize (2*size+n);
+      L = LUD.data();
+      U = L + size;
+      D = U + size;
+
+      /* value scatter indices */
+      for (int i = 0; i < n; i ++)
+      {
+        for (Long k = rowptr[i]; k < rowptr[i+1]; k ++)
+        {
+          int newi = invperm[i], newj = invperm[col[k]];
+
+          if (newi < newj) dst[k] = size + ptr[newj+1] + newi - newj;
+          else if (newi == newj) dst[k] = 2*size + newi;
+          else dst[k] = ptr[newi+1] + newj - newi;
+        }
+      }
+    }
+
+    void factorize (std::vector<REAL> &val) /* numeric factorization, Crout's algorithm */
+    {
+      for (size_t k = 0; k < LUD.size(); k ++) LUD[k] = 0.;
+
+      for (size_t k = 0; k < val.size(); k ++) LUD[dst[k]] = val[k];
+
+      ASSERT (D[0] != 0., "Zero diagonal in joints skyline LU");
+      D[0] = 1./D[0];
+
+      for (int k = 0; k < n - 1; k ++)
+      {
+        if (ptr[k+1] + k + 1 == ptr[k+2])
+        {
+          U[ptr[k+1]] = D[0] * U[ptr[k+1]];
+        }
+
+        /* column k+1 of U */
+        int indexEntry = ptr[k+1];
+        int iBeginCol = k + 1 - ptr[k+2] + ptr[k+1];
+        for (int i = iBeginCol; i <= k; indexEntry ++, i ++)
+        {
+          if (i == 0) continue;
+
+          REAL sum = U[indexEntry];
+
+          int jBeginRow = i - ptr[i+1] + ptr[i];
+          int jBeginMult = std::max(iBeginCol, jBeginRow);
+
+          int indexL = ptr[i] + jBeginMult - jBeginRow;
+          int indexU = ptr[k+1] + jBeginMult - iBeginCol;
+          for (int j = jBeginMult; j < i; j ++, indexL ++, indexU ++) sum -= L[indexL] * U[indexU];
+
+          U[indexEntry] = D[i] * sum;
+        }
+
+        /* row k+1 of L */
+        indexEntry = ptr[k+1];
+        int jBeginRow = k + 1 - ptr[k+2] + ptr[k+1];
+        for (int i = iBeginCol; i <= k; indexEntry ++, i ++)
+        {
+          if (i == 0) continue;
+
+          REAL sum = L[indexEntry];
+
+          int jBeginCol = i - ptr[i+1] + ptr[i];
+          int jBeginMult = std::max(jBeginCol, jBeginRow);
+
+          int indexL = ptr[k+1] + jBeginMult - jBeginRow;
+          int indexU = ptr[i] + jBeginMult - jBeginCol;
+          for (int j = jBeginMult; j < i; j ++, indexL ++, indexU ++) sum -= L[indexL] * U[indexU];
+
+          L[indexEntry] = sum;
+        }
+
+        /* diagonal */
+        REAL sum = D[k+1];
+        for (int j = ptr[k+1]; j < ptr[k+2]; j ++) sum -= L[j] * U[j];
+
+        ASSERT (sum != 0., "Zero pivot in joints skyline LU");
+
+        D[k+1] = 1./sum;
+      }
+    }
+
+    void operator() (std::vector<REAL> &rhs, std::vector<REAL> &x) /* solve */
+    {
+      for (int i = 0; i < n; i ++)
+      {
+        REAL sum = rhs[perm[i]];
+        for (int k = ptr[i], j = i - ptr[i+1] + k; k < ptr[i+1]; k ++, j ++) sum -= L[k] * y[j];
+        y[i] = D[i] * sum;
+      }
+
+      for (int j = n - 1; j >= 0; j --)
+      {
+        for (int k = ptr[j], i = j - ptr[j+1] + k; k < ptr[j+1]; k ++, i ++) y[i] -= U[k] * y[j];
+      }
+
+      for (int i = 0; i < n; i ++) x[perm[i]] = y[i];
+    }
+  };
 #endif
 
   typedef std::tuple<Long,
@@ -58,81 +218,156 @@ namespace parmec {
           std::vector<Long>,
           std::vector<REAL>> System;  /* System matrix */
 
-  std::map<int,std::set<int>> partadj; /* particle to joint mapping */
+  /* flat assembly structure of an independent joint set matrix; a 3x3 block
+   * row starts at a value index and its three columns follow consecutively */
+  struct Pattern
+  {
+    std::vector<int> diag; /* diag[3*i0+i1]: value index of row i1 of the diagonal block of local joint i0 */
+    std::vector<int> adjptr; /* adjptr[2*i0+k]: start of adjacency of local joint i0 through its particle k */
+    std::vector<int> adjjnt; /* adjacent joints sharing that particle */
+    std::vector<REAL> adjsgn; /* sign of the coupling block */
+    std::vector<int> adjblk; /* adjblk[3*a+i1]: value index of row i1 of the coupling block of adjacency a */
+  };
+
   std::vector<int> jmap; /* joint index to independent joint set index mapping */
   std::vector<std::vector<int>> isets; /* independent joint sets */
-  std::vector<std::vector<std::map<int,int>>> matadjs; /* matrix adjacency structures and value mappings */
+  std::vector<Pattern> patterns; /* matrix assembly patterns */
   std::vector<System*> systems; /* linear systems */
+  std::vector<Solver*> solvers; /* factorizations with symbolic analysis reused until the next reset */
+  typedef amgcl::solver::cg<Backend> PCG; /* conjugate gradients for the symmetric positive definite joints operator */
 
-  static void jmark (std::vector<std::set<int>> &jadj, std::set<int> &jall, int joint, std::vector<int> &iset)
-  {
-    if (jall.find(joint) != jall.end())
-    {
-      jall.erase (joint);
+  std::vector<Precond*> preconds; /* AMG preconditioners of the iterative solver */
+  std::vector<int> precits; /* iterations needed right after preconditioner update */
 
-      iset.push_back (joint);
+#if SUITESPARSE
+  /* cholmod view of a system matrix */
+  static cholmod_sparse system_matrix (System &system)
+  {
+    cholmod_sparse A;
+
+    A.nrow = std::get<0>(system);
+    A.ncol = std::get<0>(system);
+    A.nzmax = std::get<3>(system).size();
+    A.p = std::get<1>(system).data();
+    A.i = std::get<2>(system).data();
+    A.nz = NULL;
+    A.x = std::get<3>(system).data();
+    A.z = NULL;
+    A.stype = 0;
+    A.itype = CHOLMOD_LONG;
+    A.xtype = CHOLMOD_REAL;
+#if REAL_SIZE==4
+    A.dtype = CHOLMOD_SINGLE;
+#else
+    A.dtype = CHOLMOD_DOUBLE;
+#endif
+    A.sorted = 1;
+    A.packed = 1;
 
-      for (std::set<int>::iterator it = jadj[joint].begin(); it != jadj[joint].end(); it++)
-      {
-        jmark (jadj, jall, *it, iset);  
-      }
-    }
+    return A;
   }
+#endif
 
   /* reset joints symbolic information after change */
   void reset_joints_symbolic (int jnum, int *jpart[2])
   {
     /* clear symbolic data */
     for (int i = 0; i < systems.size(); i ++) delete systems[i];
+    for (int i = 0; i < solvers.size(); i ++) delete solvers[i];
+    for (int i = 0; i < preconds.size(); i ++) delete preconds[i];
     systems.clear();
-    partadj.clear();
-    matadjs.clear();
+    solvers.clear();
+    preconds.clear();
+    precits.clear();
+    patterns.clear();
     isets.clear();
     jmap.clear();
 
-    /* create joint to particle adjacency mapping */
+    /* create particle to joint adjacency in CRS format */
+    int pnum = 0;
+    for (int i = 0; i < jnum; i ++) pnum = std::max (pnum, std::max (jpart[0][i], jpart[1][i]) + 1);
+
+    std::vector<int> partptr(pnum+1, 0), partjnt;
     for (int i = 0; i < jnum; i ++)
     {
-      int part1 = jpart[0][i], part2 = jpart[1][i];
-
-      partadj[part1].insert(i);
-      if (part2 >= 0) partadj[part2].insert(i);
+      partptr[jpart[0][i]+1] ++;
+      if (jpart[1][i] >= 0) partptr[jpart[1][i]+1] ++;
+    }
+    for (int i = 0; i < pnum; i ++) partptr[i+1] += partptr[i];
+    partjnt.resize(partptr[pnum]);
+    std::vector<int> fill(partptr.begin(), partptr.end()-1);
+    for (int i = 0; i < jnum; i ++) /* joints are inserted in increasing order */
+    {
+      partjnt[fill[jpart[0][i]] ++] = i;
+      if (jpart[1][i] >= 0) partjnt[fill[jpart[1][i]] ++] = i;
     }
 
-    /* detect independent joint sets */
-    std::vector<std::set<int>> jadj(jnum); /* joint adjacency */
-    for (std::map<int,std::set<int>>::iterator it = partadj.begin(); it != partadj.end(); it ++)
+    /* detect independent joint sets (connected components) and create jmap */
+    jmap.assign(jnum, -1);
+    std::vector<char> marked(jnum, 0);
+    std::vector<int> stack;
+    for (int i = 0; i < jnum; i ++)
     {
-      std::set<int> &adj = it->second;
-      for (std::set<int>::iterator jt = adj.begin(); jt != adj.end(); jt ++)
+      if (marked[i]) continue;
+
+      std::vector<int> iset;
+
+      marked[i] = 1;
+      stack.push_back(i);
+
+      while (!stack.empty())
       {
-        for (std::set<int>::iterator kt = adj.begin(); kt != adj.end(); kt ++)
+        int joint = stack.back();
+        stack.pop_back();
+        iset.push_back(joint);
+
+        for (int k = 0; k < 2; k ++)
         {
-          if (*jt != *kt)
+          int part = jpart[k][joint];
+
+          if (part < 0) continue;
+
+          for (int a = partptr[part]; a < partptr[part+1]; a ++)
           {
-            jadj[*jt].insert (*kt);
+            if (!marked[partjnt[a]])
+            {
+              marked[partjnt[a]] = 1;
+              stack.push_back(partjnt[a]);
+            }
           }
         }
       }
-    }
-
-    /* create isets, jmap */
-    jmap.resize(jnum);
-    std::set<int> jall;
-    for (int i = 0; i < jnum; i ++) jall.insert(i);
-    while (jall.size() > 0)
-    {
-      std::vector<int> iset;
 
-      int joint = *jall.begin();
-
-      jmark (jadj, jall, joint, iset);
+      std::sort(iset.begin(), iset.end());
 
       for (int i = 0; i < iset.size(); i ++) jmap[iset[i]] = i;
 
       isets.push_back(iset);
     }
 
+    /* order sets by decreasing cost, estimated by the number of matrix blocks,
+     * so that dynamic scheduling starts the largest sets first */
+    std::vector<std::pair<long,int>> cost(isets.size());
+    for (int is = 0; is < isets.size(); is ++)
+    {
+      long blocks = 0;
+
+      for (int i = 0; i < isets[is].size(); i ++)
+      {
+        for (int k = 0; k < 2; k ++)
+        {
+          int part = jpart[k][isets[is][i]];
+          if (part >= 0) blocks += partptr[part+1] - partptr[part];
+        }
+      }
+
+      cost[is] = std::make_pair(-blocks, is);
+    }
+    std::sort(cost.begin(), cost.end());
+    std::vector<std::vector<int>> sorted(isets.size());
+    for (int is = 0; is < isets.size(); is ++) sorted[is].swap(isets[cost[is].second]);
+    isets.swap(sorted);
+
     for (int is = 0; is < isets.size(); is ++)
     {
       std::vector<Long> ptr; /* matrix in CRS format row pointers */
@@ -140,68 +375,115 @@ namespace parmec {
 
       std::vector<int> &iset = isets[is];
 
-      std::vector<std::map<int,int>> matadj(3*iset.size()); /* matrix adjacency structure and value mapping */
+      /* block columns of each block row: joints sharing a particle */
+      std::vector<std::vector<int>> blocks(iset.size());
+      for (int i0 = 0; i0 < iset.size(); i0 ++)
+      {
+        std::vector<int> &row = blocks[i0];
+
+        for (int k = 0; k < 2; k ++)
+        {
+          int part = jpart[k][iset[i0]];
+
+          if (part < 0) continue;
 
+          for (int a = partptr[part]; a < partptr[part+1]; a ++) row.push_back(jmap[partjnt[a]]);
+        }
+
+        std::sort(row.begin(), row.end());
+        row.erase(std::unique(row.begin(), row.end()), row.end());
+      }
+
+      /* create 'ptr' and 'col' structures */
+      ptr.push_back(0);
       for (int i0 = 0; i0 < iset.size(); i0 ++)
       {
-        for (int j0 = 0; j0 < iset.size(); j0 ++)
+        for (int i1 = 0; i1 < 3; i1 ++)
         {
-          for (int i1 = 0; i1 < 3; i1 ++)
+          for (int b = 0; b < blocks[i0].size(); b ++)
           {
-            for (int j1 = 0; j1 < 3; j1 ++)
-            {
-              matadj[i0*3+i1][j0*3+j1] = 0; /* first create adjacency with zero index value mapping */
-            }
+            for (int j1 = 0; j1 < 3; j1 ++) col.push_back(blocks[i0][b]*3+j1);
           }
+
+          ptr.push_back(col.size());
         }
       }
+      std::vector<REAL> val(col.size(), 0.); /* create zeroed matrix values */
 
-      /* next create 'ptr' and 'col' structures and set up value mapping */
-      int j = 0;
-      ptr.push_back(0);
-      for (int i = 0; i < 3*iset.size(); i ++)
+      int n = ptr.size() - 1; /* problem size */
+
+      /* create assembly pattern */
+      Pattern pattern;
+      for (int i0 = 0; i0 < iset.size(); i0 ++)
       {
-        std::map<int,int> &adj = matadj[i];
+        std::vector<int> &row = blocks[i0];
+        int i = iset[i0];
 
-        for (std::map<int,int>::iterator it = adj.begin(); it != adj.end(); it ++)
+        for (int i1 = 0; i1 < 3; i1 ++)
         {
-          col.push_back(it->first);
-          it->second = j ++;
+          int b = std::lower_bound(row.begin(), row.end(), i0) - row.begin();
+          pattern.diag.push_back(ptr[i0*3+i1] + 3*b);
         }
 
-        ptr.push_back(ptr.back()+adj.size());
+        for (int k = 0; k < 2; k ++)
+        {
+          pattern.adjptr.push_back(pattern.adjjnt.size());
+
+          int part = jpart[k][i];
+
+          if (part < 0) continue;
+
+          for (int a = partptr[part]; a < partptr[part+1]; a ++)
+          {
+            int j = partjnt[a];
+
+            if (i == j) continue;
+
+            pattern.adjjnt.push_back(j);
+
+            pattern.adjsgn.push_back((part == jpart[0][i] && part == jpart[1][j]) ||
+                                     (part == jpart[1][i] && part == jpart[0][j]) ? -1.0 : 1.0);
+
+            int b = std::lower_bound(row.begin(), row.end(), jmap[j]) - row.begin();
+            for (int i1 = 0; i1 < 3; i1 ++) pattern.adjblk.push_back(ptr[i0*3+i1] + 3*b);
+          }
+        }
       }
-      std::vector<REAL> val(j, 0.); /* create zeroed matrix values */
+      pattern.adjptr.push_back(pattern.adjjnt.size());
 
-      int n = ptr.size() - 1; /* problem size */
+      patterns.push_back(pattern);
+
+      System *system = new System (n, ptr, col, val);
 
-      matadjs.push_back(matadj);
+      systems.push_back(system);
 
-      systems.push_back(new System (n, ptr, col, val));
+      solvers.push_back(NULL); /* symbolic factorization is created on the first direct solve */
+
+      preconds.push_back(NULL); /* and the preconditioner on the first iterative solve */
+
+      precits.push_back(0);
     }
   }
 
   /* solve joints and update forces */
-  void solve_joints (int jnum, int *jpart[2], REAL *jpoint[3], REAL *jreac[3], int parnum,
+  int solve_joints (int jnum, int *jpart[2], REAL *jpoint[3], REAL *jreac[3], int parnum,
       REAL *position[6], REAL *rotation[9], REAL *inertia[9], REAL *inverse[9], REAL mass[], REAL invm[],
-      REAL damping[6], REAL *linear[3], REAL *angular[6], REAL *force[6], REAL *torque[6], REAL step0, REAL step1)
+      REAL damping[6], REAL *linear[3], REAL *angular[6], REAL *force[6], REAL *torque[6], REAL step0, REAL step1, REAL tol)
   {
     REAL half = 0.5*step0;
     REAL step = 0.5*(step0+step1);
+    int iters = 0;
 
-#if defined(_OPENMP)
-    std::vector<omp_lock_t> lock(parnum);
-    for (int i = 0; i < parnum; i ++) omp_init_lock (&lock[i]);
-
-#pragma omp parallel for
-#endif
+    /* independent sets are connected components of the particle to joint graph,
+     * hence each particle is owned by a single set and force updates need no locks */
+#pragma omp parallel for schedule(dynamic,1) if (tol <= 0.0) /* the iterative solver runs in parallel within each set */
     for (int is = 0; is < isets.size(); is ++)
     {
       int n = std::get<0>(*systems[is]); /* system size */
       std::vector<ptrdiff_t> &ptr = std::get<1>(*systems[is]); /* row pointers */
       std::vector<ptrdiff_t> &col = std::get<2>(*systems[is]); /* column indices */
       std::vector<REAL> &val = std::get<3>(*systems[is]); /* matrix values */
-      std::vector<std::map<int,int>> &matadj = matadjs[is]; /* matrix adjacency and value mapping */
+      Pattern &pattern = patterns[is]; /* matrix assembly pattern */
       std::vector<int> &iset = isets[is]; /* independent joint set */
 
       /* zero matrix values */
@@ -255,39 +537,30 @@ namespace parmec {
             Wii[4] += im;
             Wii[8] += im;
 
-            std::set<int> &adj = partadj[part];
-            for (std::set<int>::iterator it = adj.begin(); it != adj.end(); it ++)
+            for (int a = pattern.adjptr[2*i0+k]; a < pattern.adjptr[2*i0+k+1]; a ++) /* Wij */
             {
-              int j0 = jmap[*it];
-              int j = *it;
-              if (i != j) /* Wij */
+              int j = pattern.adjjnt[a];
+              REAL sgn = pattern.adjsgn[a];
+
+              A[0] = position[3][part] - jpoint[0][j];
+              A[1] = position[4][part] - jpoint[1][j];
+              A[2] = position[5][part] - jpoint[2][j];
+              VECSKEW (A, Ask);
+              NNMUL (Rot, Ask, Hj);
+              NTMUL (Jiv, Hj, C);
+              NNMUL (Hi, C, Wij);
+              Wij[0] += im;
+              Wij[4] += im;
+              Wij[8] += im;
+
+              /* accumulate Wij into (ptr, col, val) */
+              const int *blk = &pattern.adjblk[3*a];
+              for (int i1 = 0; i1 < 3; i1 ++)
               {
-                A[0] = position[3][part] - jpoint[0][j];
-                A[1] = position[4][part] - jpoint[1][j];
-                A[2] = position[5][part] - jpoint[2][j];
-                VECSKEW (A, Ask);
-                NNMUL (Rot, Ask, Hj);
-                NTMUL (Jiv, Hj, C);
-                NNMUL (Hi, C, Wij);
-                Wij[0] += im;
-                Wij[4] += im;
-                Wij[8] += im;
-
-                if ((part == jpart[0][i] && part == jpart[1][j]) ||
-                    (part == jpart[1][i] && part == jpart[0][j]))
-                {
-                  SCALE9(Wij, -1.0);
-                }
-
-                /* accumulate Wij into (ptr, col, val) */
-                for (int i1 = 0; i1 < 3; i1 ++)
-                {
-                  for (int j1 = 0; j1 < 3; j1 ++)
-                  {
-                    int k0 = matadj[i0*3+i1][j0*3+j1];
-                    val[k0] += Wij[i1*3+j1];
-                  }
-                }
+                REAL *row = &val[blk[i1]];
+                row[0] += sgn*Wij[i1*3+0];
+                row[1] += sgn*Wij[i1*3+1];
+                row[2] += sgn*Wij[i1*3+2];
               }
             }
           }
@@ -296,46 +569,13 @@ namespace parmec {
         /* accumulate Wii into (ptr, col, val) */
         for (int i1 = 0; i1 < 3; i1 ++)
         {
-          for (int j1 = 0; j1 < 3; j1 ++)
-          {
-            int k0 = matadj[i0*3+i1][i0*3+j1];
-            val[k0] += Wii[i1*3+j1];
-          }
+          REAL *row = &val[pattern.diag[3*i0+i1]];
+          row[0] += Wii[i1*3+0];
+          row[1] += Wii[i1*3+1];
+          row[2] += Wii[i1*3+2];
         }
       }
 
-      /* create linear solver */
-#if SUITESPARSE
-      cholmod_common cc;
-      cholmod_sparse A;
-
-      A.nrow = n;
-      A.ncol = n;
-      A.p = ptr.data();
-      A.i = col.data();
-      A.nz = NULL;
-      A.x = val.data();
-      A.z = NULL;
-      A.stype = 0;
-      A.itype = CHOLMOD_LONG;
-      A.xtype = CHOLMOD_REAL;
-#if REAL_SIZE==4
-      A.dtype = CHOLMOD_SINGLE;
-#else
-      A.dtype = CHOLMOD_DOUBLE;
-#endif
-      A.sorted = 1;
-      A.packed = 1;
-
-      cholmod_l_start (&cc);
-
-      Solver *solver = SuiteSparseQR_factorize <REAL> (SPQR_ORDERING_DEFAULT, SPQR_DEFAULT_TOL, &A, &cc) ;
-#else
-      auto A = amgcl::adapter::zero_copy(n, ptr.data(), col.data(), val.data());
-
-      Solver *solver = new Solver(*A);
-#endif
-
       /* assemble joints-free local velocity vector */
       std::vector<REAL> rhs(3*iset.size(), 0.);
       REAL *B = &rhs[0];
@@ -462,38 +702,92 @@ namespace parmec {
 
       /* solve for joint forces */
       std::vector<REAL> x(rhs.size());
+      int direct = tol <= 0.0;
+
+      if (!direct) /* iterative solution warm-started from the previous reactions: x = hR */
+      {
+        for (int i0 = 0; i0 < iset.size(); i0 ++)
+        {
+          x[3*i0+0] = step*jreac[0][iset[i0]];
+          x[3*i0+1] = step*jreac[1][iset[i0]];
+          x[3*i0+2] = step*jreac[2][iset[i0]];
+        }
+
+        if (!preconds[is]) preconds[is] = update_precond (systems[is], 1);
+
+        PCG::params prm;
+        prm.maxiter = std::max(100, n);
+        prm.tol = tol;
+        PCG pcg (n, prm);
+        size_t count;
+        REAL error;
+
+        std::tie(count, error) = pcg (*systems[is], *preconds[is], rhs, x);
+
+        if (precits[is] == 0) precits[is] = std::max((int)count, 1);
+        else if ((int)count > 2*precits[is]) /* the matrix has drifted away from the preconditioner */
+        {
+          delete preconds[is];
+          preconds[is] = NULL;
+          precits[is] = 0;
+        }
+
+        iters = std::max(iters, (int)count);
+
+        if (error > tol) /* not converged within maxiter: fall back to the direct solution */
+        {
+          fprintf (stderr, "WARNING: joint reaction CG stopped at error %g > %g after %d iterations; "
+                           "solving directly\n", (double)error, (double)tol, (int)count);
+          direct = 1;
+        }
+      }
+
+      if (direct)
+      {
+        if (!solvers[is]) /* symbolic factorization */
+        {
 #if SUITESPARSE
-      cholmod_dense *X, *Y, Z;
+          cholmod_sparse A = system_matrix (*systems[is]);
+          solvers[is] = new Solver (&A);
+#else
+          solvers[is] = new Solver (n, ptr, col);
+#endif
+        }
 
-      cholmod_l_start (&cc);
+        Solver *solver = solvers[is];
 
-      Z.nrow = rhs.size();
-      Z.ncol = 1;
-      Z.nzmax = Z.nrow;
-      Z.d = Z.nrow;
-      Z.x = rhs.data();
-      Z.z = NULL;
-      Z.xtype = CHOLMOD_REAL;
+#if SUITESPARSE
+        cholmod_sparse A = system_matrix (*systems[is]);
+        cholmod_dense *X, *Y, Z;
+
+        solver->factorize (&A); /* numeric factorization */
+
+        Z.nrow = rhs.size();
+        Z.ncol = 1;
+        Z.nzmax = Z.nrow;
+        Z.d = Z.nrow;
+        Z.x = rhs.data();
+        Z.z = NULL;
+        Z.xtype = CHOLMOD_REAL;
 #if REAL_SIZE==4
-      Z.dtype = CHOLMOD_SINGLE;
+        Z.dtype = CHOLMOD_SINGLE;
 #else
-      Z.dtype = CHOLMOD_DOUBLE;
+        Z.dtype = CHOLMOD_DOUBLE;
 #endif
 
-      Y = SuiteSparseQR_qmult (SPQR_QTX, solver, &Z, &cc);
-      X = SuiteSparseQR_solve (SPQR_RETX_EQUALS_B, solver, Y, &cc);
+        Y = SuiteSparseQR_qmult (SPQR_QTX, solver->QR, &Z, &solver->cc);
+        X = SuiteSparseQR_solve (SPQR_RETX_EQUALS_B, solver->QR, Y, &solver->cc);
 
-      x.assign((REAL*)X->x, (REAL*)X->x + X->nrow);
+        x.assign((REAL*)X->x, (REAL*)X->x + X->nrow);
 
-      cholmod_l_free_dense (&Y, &cc);
-      cholmod_l_free_dense (&X, &cc);
-
-      SuiteSparseQR_free (&solver, &cc);
+        cholmod_l_free_dense (&Y, &solver->cc);
+        cholmod_l_free_dense (&X, &solver->cc);
 #else
-      (*solver)(rhs, x);
+        solver->factorize (val); /* numeric factorization */
 
-      delete solver;
+        (*solver)(rhs, x);
 #endif
+      }
 
       /* accumulate joint forces into body force and torque vectors */
       REAL *R = &x[0];
@@ -531,10 +825,6 @@ namespace parmec {
             NVMUL (Rot, A, a);
             PRODUCT (R, a, t);
 
-#if defined(_OPENMP)
-            omp_set_lock (&lock[part]);
-#endif
-
             if (part == jpart[0][i])
             {
               torque[0][part] += t[0];
@@ -553,17 +843,12 @@ namespace parmec {
               force[1][part] -= R[1];
               force[2][part] -= R[2];
             }
-#if defined(_OPENMP)
-            omp_unset_lock (&lock[part]);
-#endif
           }
         }
       }
     }
 
-#if defined(_OPENMP)
-    for (int i = 0; i < parnum; i ++) omp_destroy_lock (&lock[i]);
-#endif
+    return iters;
   }
 
 } /* namespace */
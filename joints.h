@@ -34,10 +34,11 @@ namespace parmec { /* namespace */
   /* reset joints symbolic information after change */
   void reset_joints_symbolic (int jnum, int *jpart[2]);
 
-  /* solve joints and update forces */
-  void solve_joints (int jnum, int *jpart[2], REAL *jpoint[3], REAL *jreac[3], int parnum,
+  /* solve joints and update forces; with tol > 0 use warm-started iterative solver
+   * and return the largest number of iterations over independent joint sets */
+  int solve_joints (int jnum, int *jpart[2], REAL *jpoint[3], REAL *jreac[3], int parnum,
       REAL *position[6], REAL *rotation[9], REAL *inertia[9], REAL *inverse[9], REAL mass[], REAL invm[],
-      REAL damping[6], REAL *linear[3], REAL *angular[6], REAL *force[6], REAL *torque[6], REAL step0, REAL step1);
+      REAL damping[6], REAL *linear[3], REAL *angular[6], REAL *force[6], REAL *torque[6], REAL step0, REAL step1, REAL tol);
 
 #ifdef __cplusplus
 } /* namespace */
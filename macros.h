@@ -64,6 +64,18 @@
 #define REAL_EPS 1E-8
 #endif
 
+/* contact detection real type; GREAL=4 selects single precision leaf data and
+ * new contact tests in a double precision build (mixed precision parmec48) */
+#if GREAL==4
+#undef GREAL
+#define GREAL float
+#else
+#if defined GREAL
+#undef GREAL
+#endif
+#define GREAL REAL
+#endif
+
 /* textual assertion */
 #define ASSERT(__test__, ...)\
   do {\
@@ -28,25 +28,43 @@
 #include "macros.h"
 #include "parmec.h"
 #include "output.h"
+#include "couple.h"
+#include "domain.h"
 #include "parmec_ispc.h"
 #include "version.h"
 
 using namespace parmec;
-using namespace ispc; /* ispc_num_cores */
+using namespace ispc; /* ispc_num_cores, ispc_target */
+
+/* print version and the ISPC target dispatched on this CPU */
+static void version ()
+{
+  const char *isa[] = {"sse2", "sse4", "avx1", "avx2", "avx512skx"}; /* ispc --target names */
+  int width, target = ispc_target (&width);
+
+  printf ("VERSION: %s %s, ISPC TARGET: %s-i32x%d\n", VERSION_DATE, VERSION_HASH, isa[target], width);
+}
 
 int main (int argc, char *argv[])
 {
   if (argc == 1)
   {
-    printf ("VERSION: %s %s\n", VERSION_DATE, VERSION_HASH);
+    version ();
     printf ("SYNOPSIS: parmec [-ntasks n] path/to/file.py\n");
     printf ("         -ntasks n: number of tasks (default: hardware supported maximum)\n");
+    printf ("         PARMEC_PIN=1 environment variable pins task threads to cores\n");
+    printf ("         built with MPI=yes (see Config.mak) it runs as: mpirun -np ranks parmec ...\n");
+    printf ("         PARMEC_SHM=0 environment variable exchanges ghosts of ranks on one machine in messages\n");
     return 1;
   }
   else
   {
+    domain_init (&argc, &argv);
+
     init();
 
+    if (domain_rank () == 0) version ();
+
     if (strcmp (argv[1], "-ntasks") == 0 && argc > 2)
     {
       ntasks = atoi (argv[2]);
@@ -63,6 +81,10 @@ int main (int argc, char *argv[])
     }
 
     output_reset ();
+
+    couple_close ();
+
+    domain_finalize ();
   }
 
   return 0;
@@ -0,0 +1,184 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2015 Tomasz Koziara
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <vector>
+#include <algorithm>
+#include "macros.h"
+#include "obstree.h"
+
+using namespace ispc;
+
+namespace parmec { /* namespace */
+
+/* triangle extents */
+static void triangle_box (REAL *tri[3][3], int i, REAL box[6])
+{
+  for (int k = 0; k < 3; k ++)
+  {
+    box[k] = std::min (tri[0][k][i], std::min (tri[1][k][i], tri[2][k][i]));
+    box[3+k] = std::max (tri[0][k][i], std::max (tri[1][k][i], tri[2][k][i]));
+  }
+}
+
+/* union of two boxes */
+static void box_union (REAL *a, REAL *b, REAL *c)
+{
+  for (int k = 0; k < 3; k ++)
+  {
+    c[k] = std::min (a[k], b[k]);
+    c[3+k] = std::max (a[3+k], b[3+k]);
+  }
+}
+
+/* leaf extents */
+static void leaf_box (obstacle_tree *tree, int node, REAL *tri[3][3])
+{
+  int first = -tree->node[2*node]-1, count = tree->node[2*node+1];
+  REAL *box = &tree->box[6*node], tbox[6];
+
+  triangle_box (tri, tree->order[first], box);
+
+  for (int j = 1; j < count; j ++)
+  {
+    triangle_box (tri, tree->order[first+j], tbox);
+    box_union (box, tbox, box);
+  }
+}
+
+/* split triangles [first, first+count) of the order array; nodes are numbered
+ * so that children always follow their parents */
+static void split (std::vector<int> &node, std::vector<int> &order, std::vector<REAL> &center,
+                   int index, int first, int count)
+{
+  if (count <= OBSLEAF)
+  {
+    node[2*index] = -(first+1);
+    node[2*index+1] = count;
+    return;
+  }
+
+  REAL lo[3] = {REAL_MAX, REAL_MAX, REAL_MAX}, hi[3] = {-REAL_MAX, -REAL_MAX, -REAL_MAX};
+
+  for (int j = first; j < first+count; j ++)
+  {
+    for (int k = 0; k < 3; k ++)
+    {
+      lo[k] = std::min (lo[k], center[3*order[j]+k]);
+      hi[k] = std::max (hi[k], center[3*order[j]+k]);
+    }
+  }
+
+  int d = 0; /* split the longest extent of triangle centers at the median */
+  if (hi[1]-lo[1] > hi[d]-lo[d]) d = 1;
+  if (hi[2]-lo[2] > hi[d]-lo[d]) d = 2;
+
+  int half = count/2;
+
+  std::nth_element (order.begin()+first, order.begin()+first+half, order.begin()+first+count,
+    [&center, d] (int a, int b) { return center[3*a+d] < center[3*b+d]; });
+
+  int left = node.size()/2;
+  node.resize (node.size()+4);
+  node[2*index] = left;
+  node[2*index+1] = left+1;
+
+  split (node, order, center, left, first, half);
+  split (node, order, center, left+1, first+half, count-half);
+}
+
+/* create obstacle triangles tree; return NULL if there are no obstacle triangles */
+obstacle_tree* obstacle_tree_create (int trinum, int triobs[], REAL *tri[3][3])
+{
+  std::vector<int> order;
+  std::vector<REAL> center(3*trinum);
+  int moving = 0;
+
+  for (int i = 0; i < trinum; i ++)
+  {
+    if (triobs[i] < 0) /* static or moving obstacle */
+    {
+      order.push_back (i);
+
+      if (triobs[i] < -1) moving ++;
+
+      for (int k = 0; k < 3; k ++) center[3*i+k] = (tri[0][k][i] + tri[1][k][i] + tri[2][k][i])/3.0;
+    }
+  }
+
+  if (order.empty()) return NULL;
+
+  std::vector<int> node(2);
+
+  split (node, order, center, 0, 0, order.size());
+
+  obstacle_tree *tree;
+
+  ERRMEM (tree = new obstacle_tree);
+  tree->nodnum = node.size()/2;
+  ERRMEM (tree->node = new int [node.size()]);
+  std::copy (node.begin(), node.end(), tree->node);
+  ERRMEM (tree->box = new REAL [6*tree->nodnum]);
+  tree->trinum = order.size();
+  ERRMEM (tree->order = new int [order.size()]);
+  std::copy (order.begin(), order.end(), tree->order);
+  tree->moving = moving;
+
+  obstacle_tree_refit (tree, tri);
+
+  return tree;
+}
+
+/* refit tree extents after obstacle motion */
+void obstacle_tree_refit (obstacle_tree *tree, REAL *tri[3][3])
+{
+  #pragma omp parallel for
+  for (int i = 0; i < tree->nodnum; i ++)
+  {
+    if (tree->node[2*i] < 0) leaf_box (tree, i, tri);
+  }
+
+  for (int i = tree->nodnum-1; i >= 0; i --) /* children follow parents */
+  {
+    if (tree->node[2*i] >= 0)
+    {
+      box_union (&tree->box[6*tree->node[2*i]], &tree->box[6*tree->node[2*i+1]], &tree->box[6*i]);
+    }
+  }
+}
+
+/* destroy obstacle triangles tree */
+void obstacle_tree_destroy (obstacle_tree *tree)
+{
+  if (tree)
+  {
+    delete [] tree->node;
+    delete [] tree->box;
+    delete [] tree->order;
+    delete tree;
+  }
+}
+
+} /* namespace */
@@ -0,0 +1,45 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2015 Tomasz Koziara
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+ */
+
+#include "condet_ispc.h"
+
+#ifndef __obstree__
+#define __obstree__
+
+#define OBSLEAF 8 /* obstacle tree leaf size; not larger than condet.h:CONBUF */
+
+namespace parmec { /* namespace */
+
+/* create obstacle triangles tree; return NULL if there are no obstacle triangles */
+ispc::obstacle_tree* obstacle_tree_create (int trinum, int triobs[], REAL *tri[3][3]);
+
+/* refit tree extents after obstacle motion */
+void obstacle_tree_refit (ispc::obstacle_tree *tree, REAL *tri[3][3]);
+
+/* destroy obstacle triangles tree */
+void obstacle_tree_destroy (ispc::obstacle_tree *tree);
+
+} /* namespace */
+
+#endif
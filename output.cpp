@@ -31,10 +31,22 @@
 #include <fstream>
 #include <sstream>
 #include <vector>
+#include <set>
+#include <map>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
 #include "macros.h"
 #include "parmec.h"
 #include "mem.h"
 #include "map.h"
+#include "h5read.h"
 
 #if MED
 extern "C" {
@@ -50,6 +62,9 @@ static med_idt med_fid_cd = (med_idt)-1; /* contact data */
 using namespace parmec;
 using namespace std;
 
+#define OUTPUT_PARALLEL_SIZE 4096 /* minimal number of items for which dataset buffers are assembled in parallel */
+#define OUTPUT_CHUNK_BYTES 1048576 /* maximal chunk size of filtered datasets */
+
 /* output dump dataset of spheres and ellipsoids */
 static void output_dump_dataset (int num, int *set, int ent, ofstream &out)
 {
@@ -266,22 +281,137 @@ static void output_rb_dataset (int num, int *set, int ent, ofstream &out)
   }
 }
 
+/* output dataset precision */
+struct h5_precision
+{
+  int kind; /* OUT_PRECISION_DOUBLE, OUT_PRECISION_FLOAT, OUT_PRECISION_SCALED, OUT_PRECISION_DELTA */
+  double error; /* absolute error bound of scaled and delta kinds */
+};
+
+static std::map<string, h5_precision> h5_precision_map; /* dataset name to precision map */
+
+/* bytes per value of a written dataset; see the XDMF Precision attributes */
+static int h5_precision_bytes (const char *name)
+{
+  std::map<string, h5_precision>::iterator it = h5_precision_map.find (name);
+
+  return it != h5_precision_map.end() && it->second.kind == OUT_PRECISION_FLOAT ? 4 : 8;
+}
+
+/* chunk filtered datasets by whole rows of at most OUTPUT_CHUNK_BYTES; HDF5 chunks cannot exceed 4GB */
+static void h5_set_chunk (hid_t plist, int rank, const hsize_t *dims)
+{
+  hsize_t chunk[2], rows;
+
+  chunk[0] = dims[0];
+  chunk[1] = rank > 1 ? dims[1] : 1;
+  rows = OUTPUT_CHUNK_BYTES / (sizeof(double) * (chunk[1] > 0 ? chunk[1] : 1));
+  if (chunk[0] > rows) chunk[0] = rows;
+  if (chunk[0] < 1) chunk[0] = 1;
+  if (chunk[1] < 1) chunk[1] = 1;
+
+  H5Pset_chunk (plist, rank, chunk);
+}
+
+/* last written values of delta encoded datasets */
+struct h5_delta
+{
+  string path; /* path of the last written dataset */
+  vector<double> values; /* its values */
+};
+
+static std::map<string, h5_delta> h5_delta_map; /* file and dataset name to last written dataset map */
+
+/* write .h5 double dataset using precision declared for its name */
+static herr_t h5_make_dataset (hid_t h5_step, const char *name, int rank, const hsize_t *dims, const double *data)
+{
+  std::map<string, h5_precision>::iterator it = h5_precision_map.find (name);
+
+  if (it == h5_precision_map.end() || it->second.kind == OUT_PRECISION_DOUBLE)
+  {
+    return H5LTmake_dataset_double (h5_step, name, rank, dims, data);
+  }
+
+  hsize_t size = 1;
+  for (int i = 0; i < rank; i ++) size *= dims[i];
+
+  if (it->second.kind == OUT_PRECISION_DELTA) /* link unchanged datasets to their previous frame */
+  {
+    char file[1024], group[1024];
+    H5Fget_name (h5_step, file, 1024);
+    H5Iget_name (h5_step, group, 1024);
+    h5_delta &last = h5_delta_map[string(file) + ":" + name];
+
+    if (last.values.size() == size)
+    {
+      hsize_t i;
+      for (i = 0; i < size; i ++)
+      {
+        if (fabs (data[i] - last.values[i]) > it->second.error) break;
+      }
+
+      if (i == size)
+      {
+        return H5Lcreate_hard (h5_step, last.path.c_str(), h5_step, name, H5P_DEFAULT, H5P_DEFAULT);
+      }
+    }
+
+    last.path = string(group) + "/" + name;
+    last.values.assign (data, data + size);
+  }
+
+  hid_t space, plist, dset, type = H5T_IEEE_F64LE;
+  herr_t ret;
+
+  space = H5Screate_simple (rank, dims, NULL);
+  plist = H5Pcreate (H5P_DATASET_CREATE);
+
+  switch (it->second.kind)
+  {
+    case OUT_PRECISION_FLOAT:
+      type = H5T_IEEE_F32LE;
+      break;
+    case OUT_PRECISION_SCALED:
+      {
+        int digits = (int) ceil (-log10 (2.0 * it->second.error)); /* 0.5*10^-digits <= error */
+        h5_set_chunk (plist, rank, dims);
+        H5Pset_scaleoffset (plist, H5Z_SO_FLOAT_DSCALE, digits > 0 ? digits : 0);
+      }
+      break;
+    case OUT_PRECISION_DELTA:
+      h5_set_chunk (plist, rank, dims);
+      H5Pset_shuffle (plist);
+      H5Pset_deflate (plist, 1);
+      break;
+  }
+
+  dset = H5Dcreate (h5_step, name, type, space, H5P_DEFAULT, plist, H5P_DEFAULT);
+  ret = dset >= 0 ? H5Dwrite (dset, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, H5P_DEFAULT, data) : -1;
+
+  if (dset >= 0) H5Dclose (dset);
+  H5Pclose (plist);
+  H5Sclose (space);
+
+  return ret;
+}
+
 /* output hdf5 dataset of rigid body data */
 static void h5_rb_dataset (int num, int *set, int ent, hid_t h5_step)
 {
-  double *data, *pdata;
-  int i, j, *numb;
+  double *data;
+  int i, *numb;
 
   ERRMEM (data = new double [9*num]);
+#pragma omp parallel for if (num > OUTPUT_PARALLEL_SIZE)
   for (i = 0; i < num; i ++)
   {
-    j = set[i];
+    int j = set[i];
     data[3*i+0] = position[0][j];
     data[3*i+1] = position[1][j];
     data[3*i+2] = position[2][j];
   }
   hsize_t dims[2] = {num, 3};
-  ASSERT (H5LTmake_dataset_double (h5_step, "GEOM", 2, dims, data) >= 0, "HDF5 file write error");
+  ASSERT (h5_make_dataset (h5_step, "GEOM", 2, dims, data) >= 0, "HDF5 file write error");
 
   if (ent & OUT_NUMBER)
   {
@@ -300,122 +430,131 @@ static void h5_rb_dataset (int num, int *set, int ent, hid_t h5_step)
 
   if (ent & OUT_DISPL)
   {
-    pdata = data;
+#pragma omp parallel for if (num > OUTPUT_PARALLEL_SIZE)
     for (i = 0; i < num; i ++)
     {
-      j = set[i];
+      double *pdata = data + 3*i;
+      int j = set[i];
 
       REAL d[3] = {position[0][j]-position[3][j],
         position[1][j]-position[4][j],
         position[2][j]-position[5][j]};
 
-      pdata[0] = d[0]; pdata[1] = d[1]; pdata[2] = d[2]; pdata +=3;
+      pdata[0] = d[0]; pdata[1] = d[1]; pdata[2] = d[2];
     }
 
-    ASSERT (H5LTmake_dataset_double (h5_step, "DISPL", 2, dims, data) >= 0, "HDF5 file write error");
+    ASSERT (h5_make_dataset (h5_step, "DISPL", 2, dims, data) >= 0, "HDF5 file write error");
   }
 
   if (ent & OUT_LINVEL)
   {
-    pdata = data;
+#pragma omp parallel for if (num > OUTPUT_PARALLEL_SIZE)
     for (i = 0; i < num; i ++)
     {
-      j = set[i];
+      double *pdata = data + 3*i;
+      int j = set[i];
 
-      pdata[0] = linear[0][j]; pdata[1] = linear[1][j]; pdata[2] = linear[2][j]; pdata += 3;
+      pdata[0] = linear[0][j]; pdata[1] = linear[1][j]; pdata[2] = linear[2][j];
     }
 
-    ASSERT (H5LTmake_dataset_double (h5_step, "LINVEL", 2, dims, data) >= 0, "HDF5 file write error");
+    ASSERT (h5_make_dataset (h5_step, "LINVEL", 2, dims, data) >= 0, "HDF5 file write error");
   }
 
   if (ent & OUT_ANGVEL)
   {
-    pdata = data;
+#pragma omp parallel for if (num > OUTPUT_PARALLEL_SIZE)
     for (i = 0; i < num; i ++)
     {
-      j = set[i];
+      double *pdata = data + 3*i;
+      int j = set[i];
 
-      pdata[0] = angular[0][j]; pdata[1] = angular[1][j]; pdata[2] = angular[2][j]; pdata += 3;
+      pdata[0] = angular[0][j]; pdata[1] = angular[1][j]; pdata[2] = angular[2][j];
     }
 
-    ASSERT (H5LTmake_dataset_double (h5_step, "ANGVEL", 2, dims, data) >= 0, "HDF5 file write error");
+    ASSERT (h5_make_dataset (h5_step, "ANGVEL", 2, dims, data) >= 0, "HDF5 file write error");
   }
 
   if (ent & OUT_FORCE)
   {
-    pdata = data;
+#pragma omp parallel for if (num > OUTPUT_PARALLEL_SIZE)
     for (i = 0; i < num; i ++)
     {
-      j = set[i];
+      double *pdata = data + 3*i;
+      int j = set[i];
 
-      pdata[0] = force[0][j]; pdata[1] = force[1][j]; pdata[2] = force[2][j]; pdata += 3;
+      pdata[0] = force[0][j]; pdata[1] = force[1][j]; pdata[2] = force[2][j];
     }
 
-    ASSERT (H5LTmake_dataset_double (h5_step, "FORCE", 2, dims, data) >= 0, "HDF5 file write error");
+    ASSERT (h5_make_dataset (h5_step, "FORCE", 2, dims, data) >= 0, "HDF5 file write error");
   }
 
   if (ent & OUT_TORQUE)
   {
-    pdata = data;
+#pragma omp parallel for if (num > OUTPUT_PARALLEL_SIZE)
     for (i = 0; i < num; i ++)
     {
-      j = set[i];
+      double *pdata = data + 3*i;
+      int j = set[i];
 
-      pdata[0] = torque[0][j]; pdata[1] = torque[1][j]; pdata[2] = torque[2][j]; pdata += 3;
+      pdata[0] = torque[0][j]; pdata[1] = torque[1][j]; pdata[2] = torque[2][j];
     }
 
-    ASSERT (H5LTmake_dataset_double (h5_step, "TORQUE", 2, dims, data) >= 0, "HDF5 file write error");
+    ASSERT (h5_make_dataset (h5_step, "TORQUE", 2, dims, data) >= 0, "HDF5 file write error");
   }
 
   if (ent & OUT_ORIENT)
   {
-    pdata = data;
+#pragma omp parallel for if (num > OUTPUT_PARALLEL_SIZE)
     for (i = 0; i < num; i ++)
     {
-      j = set[i];
-      pdata[0] = rotation[0][j]; pdata[1] = rotation[1][j]; pdata[2] = rotation[2][j]; pdata += 3;
-      pdata[0] = rotation[3][j]; pdata[1] = rotation[4][j]; pdata[2] = rotation[5][j]; pdata += 3;
-      pdata[0] = rotation[6][j]; pdata[1] = rotation[7][j]; pdata[2] = rotation[8][j]; pdata += 3;
+      double *pdata = data + 9*i;
+      int j = set[i];
+      pdata[0] = rotation[0][j]; pdata[1] = rotation[1][j]; pdata[2] = rotation[2][j];
+      pdata[3] = rotation[3][j]; pdata[4] = rotation[4][j]; pdata[5] = rotation[5][j];
+      pdata[6] = rotation[6][j]; pdata[7] = rotation[7][j]; pdata[8] = rotation[8][j];
     }
 
     hsize_t dims[2] = {num, 9};
-    ASSERT (H5LTmake_dataset_double (h5_step, "ORIENT", 2, dims, data) >= 0, "HDF5 file write error");
+    ASSERT (h5_make_dataset (h5_step, "ORIENT", 2, dims, data) >= 0, "HDF5 file write error");
   }
 
   if (ent & OUT_ORIENT1)
   {
-    pdata = data;
+#pragma omp parallel for if (num > OUTPUT_PARALLEL_SIZE)
     for (i = 0; i < num; i ++)
     {
-      j = set[i];
-      pdata[0] = rotation[0][j]; pdata[1] = rotation[1][j]; pdata[2] = rotation[2][j]; pdata += 3;
+      double *pdata = data + 3*i;
+      int j = set[i];
+      pdata[0] = rotation[0][j]; pdata[1] = rotation[1][j]; pdata[2] = rotation[2][j];
     }
 
-    ASSERT (H5LTmake_dataset_double (h5_step, "ORIENT1", 2, dims, data) >= 0, "HDF5 file write error");
+    ASSERT (h5_make_dataset (h5_step, "ORIENT1", 2, dims, data) >= 0, "HDF5 file write error");
   }
 
   if (ent & OUT_ORIENT2)
   {
-    pdata = data;
+#pragma omp parallel for if (num > OUTPUT_PARALLEL_SIZE)
     for (i = 0; i < num; i ++)
     {
-      j = set[i];
-      pdata[0] = rotation[3][j]; pdata[1] = rotation[4][j]; pdata[2] = rotation[5][j]; pdata += 3;
+      double *pdata = data + 3*i;
+      int j = set[i];
+      pdata[0] = rotation[3][j]; pdata[1] = rotation[4][j]; pdata[2] = rotation[5][j];
     }
 
-    ASSERT (H5LTmake_dataset_double (h5_step, "ORIENT2", 2, dims, data) >= 0, "HDF5 file write error");
+    ASSERT (h5_make_dataset (h5_step, "ORIENT2", 2, dims, data) >= 0, "HDF5 file write error");
   }
 
   if (ent & OUT_ORIENT3)
   {
-    pdata = data;
+#pragma omp parallel for if (num > OUTPUT_PARALLEL_SIZE)
     for (i = 0; i < num; i ++)
     {
-      j = set[i];
-      pdata[0] = rotation[6][j]; pdata[1] = rotation[7][j]; pdata[2] = rotation[8][j]; pdata += 3;
+      double *pdata = data + 3*i;
+      int j = set[i];
+      pdata[0] = rotation[6][j]; pdata[1] = rotation[7][j]; pdata[2] = rotation[8][j];
     }
 
-    ASSERT (H5LTmake_dataset_double (h5_step, "ORIENT3", 2, dims, data) >= 0, "HDF5 file write error");
+    ASSERT (h5_make_dataset (h5_step, "ORIENT3", 2, dims, data) >= 0, "HDF5 file write error");
   }
 
   delete [] data;
@@ -1979,13 +2118,14 @@ static void vtk_triangle_dataset (int num, int *set, int ent, ofstream &out)
 /* output hdf5 dataset of triangles */
 static void h5_triangle_dataset (int num, int *set, int ent, hid_t h5_step)
 {
-  double *data, *pdata;
-  int i, j, *topo;
+  double *data;
+  int i, *topo;
 
   ERRMEM (data = new double [9*num]);
+#pragma omp parallel for if (num > OUTPUT_PARALLEL_SIZE)
   for (i = 0; i < num; i ++)
   {
-    j = set[i];
+    int j = set[i];
     data[9*i+0] = tri[0][0][j];
     data[9*i+1] = tri[0][1][j];
     data[9*i+2] = tri[0][2][j];
@@ -1997,7 +2137,7 @@ static void h5_triangle_dataset (int num, int *set, int ent, hid_t h5_step)
     data[9*i+8] = tri[2][2][j];
   }
   hsize_t dims[2] = {3*num, 3};
-  ASSERT (H5LTmake_dataset_double (h5_step, "GEOM", 2, dims, data) >= 0, "HDF5 file write error");
+  ASSERT (h5_make_dataset (h5_step, "GEOM", 2, dims, data) >= 0, "HDF5 file write error");
 
   ERRMEM (topo = new int[4*num]);
   for (i = 0; i < num; i ++)
@@ -2012,10 +2152,11 @@ static void h5_triangle_dataset (int num, int *set, int ent, hid_t h5_step)
 
   if (ent & OUT_DISPL)
   {
-    pdata = data;
+#pragma omp parallel for if (num > OUTPUT_PARALLEL_SIZE)
     for (i = 0; i < num; i ++)
     {
-      j = set[i];
+      double *pdata = data + 9*i;
+      int j = set[i];
 
       REAL p1[3] = {tri [0][0][j], tri[0][1][j], tri[0][2][j]};
       REAL p2[3] = {tri [1][0][j], tri[1][1][j], tri[1][2][j]};
@@ -2048,23 +2189,23 @@ static void h5_triangle_dataset (int num, int *set, int ent, hid_t h5_step)
         SUB (p1, x, d);
         TVADDMUL (X, L, d, P);
         SUB (p1, P, d);
-        pdata[0] = d[0]; pdata[1] = d[1]; pdata[2] = d[2]; pdata +=3;
+        pdata[0] = d[0]; pdata[1] = d[1]; pdata[2] = d[2];
 
         SUB (p2, x, d);
         TVADDMUL (X, L, d, P);
         SUB (p2, P, d);
-        pdata[0] = d[0]; pdata[1] = d[1]; pdata[2] = d[2]; pdata +=3;
+        pdata[3] = d[0]; pdata[4] = d[1]; pdata[5] = d[2];
 
         SUB (p3, x, d);
         TVADDMUL (X, L, d, P);
         SUB (p3, P, d);
-        pdata[0] = d[0]; pdata[1] = d[1]; pdata[2] = d[2]; pdata +=3;
+        pdata[6] = d[0]; pdata[7] = d[1]; pdata[8] = d[2];
       }
       else if (j == -1) /* static obstacle */
       {
-        pdata[0] = 0.0; pdata[1] = 0.0; pdata[2] = 0.0; pdata +=3;
-        pdata[0] = 0.0; pdata[1] = 0.0; pdata[2] = 0.0; pdata +=3;
-        pdata[0] = 0.0; pdata[1] = 0.0; pdata[2] = 0.0; pdata +=3;
+        pdata[0] = 0.0; pdata[1] = 0.0; pdata[2] = 0.0;
+        pdata[3] = 0.0; pdata[4] = 0.0; pdata[5] = 0.0;
+        pdata[6] = 0.0; pdata[7] = 0.0; pdata[8] = 0.0;
       }
       else /* moving obstacle */
       {
@@ -2073,23 +2214,24 @@ static void h5_triangle_dataset (int num, int *set, int ent, hid_t h5_step)
         REAL x[3] = {obspnt[3*j], obspnt[3*j+1], obspnt[3*j+2]}, d[3];
 
         SUB (p1, x, d);
-        pdata[0] = d[0]; pdata[1] = d[1]; pdata[2] = d[2]; pdata +=3;
+        pdata[0] = d[0]; pdata[1] = d[1]; pdata[2] = d[2];
         SUB (p2, x, d);
-        pdata[0] = d[0]; pdata[1] = d[1]; pdata[2] = d[2]; pdata +=3;
+        pdata[3] = d[0]; pdata[4] = d[1]; pdata[5] = d[2];
         SUB (p3, x, d);
-        pdata[0] = d[0]; pdata[1] = d[1]; pdata[2] = d[2]; pdata +=3;
+        pdata[6] = d[0]; pdata[7] = d[1]; pdata[8] = d[2];
       }
     }
 
-    ASSERT (H5LTmake_dataset_double (h5_step, "DISPL", 2, dims, data) >= 0, "HDF5 file write error");
+    ASSERT (h5_make_dataset (h5_step, "DISPL", 2, dims, data) >= 0, "HDF5 file write error");
   }
 
   if (ent & OUT_LINVEL)
   {
-    pdata = data;
+#pragma omp parallel for if (num > OUTPUT_PARALLEL_SIZE)
     for (i = 0; i < num; i ++)
     {
-      j = set[i];
+      double *pdata = data + 9*i;
+      int j = set[i];
 
       REAL p1[3] = {tri [0][0][j], tri[0][1][j], tri[0][2][j]};
       REAL p2[3] = {tri [1][0][j], tri[1][1][j], tri[1][2][j]};
@@ -2116,23 +2258,23 @@ static void h5_triangle_dataset (int num, int *set, int ent, hid_t h5_step)
         COPY (v, w);
         SUB (p1, x, a);
         PRODUCTADD (o, a, w);
-        pdata[0] = w[0]; pdata[1] = w[1]; pdata[2] = w[2]; pdata +=3;
+        pdata[0] = w[0]; pdata[1] = w[1]; pdata[2] = w[2];
 
         COPY (v, w);
         SUB (p2, x, a);
         PRODUCTADD (o, a, w);
-        pdata[0] = w[0]; pdata[1] = w[1]; pdata[2] = w[2]; pdata +=3;
+        pdata[3] = w[0]; pdata[4] = w[1]; pdata[5] = w[2];
 
         COPY (v, w);
         SUB (p3, x, a);
         PRODUCTADD (o, a, w);
-        pdata[0] = w[0]; pdata[1] = w[1]; pdata[2] = w[2]; pdata +=3;
+        pdata[6] = w[0]; pdata[7] = w[1]; pdata[8] = w[2];
       }
       else if (j == -1) /* static obstacle */
       {
-        pdata[0] = 0.0; pdata[1] = 0.0; pdata[2] = 0.0; pdata +=3;
-        pdata[0] = 0.0; pdata[1] = 0.0; pdata[2] = 0.0; pdata +=3;
-        pdata[0] = 0.0; pdata[1] = 0.0; pdata[2] = 0.0; pdata +=3;
+        pdata[0] = 0.0; pdata[1] = 0.0; pdata[2] = 0.0;
+        pdata[3] = 0.0; pdata[4] = 0.0; pdata[5] = 0.0;
+        pdata[6] = 0.0; pdata[7] = 0.0; pdata[8] = 0.0;
       }
       else /* moving obstacle */
       {
@@ -2146,21 +2288,21 @@ static void h5_triangle_dataset (int num, int *set, int ent, hid_t h5_step)
         COPY (v, w);
         SUB (p1, x, a);
         PRODUCTADD (o, a, w);
-        pdata[0] = w[0]; pdata[1] = w[1]; pdata[2] = w[2]; pdata +=3;
+        pdata[0] = w[0]; pdata[1] = w[1]; pdata[2] = w[2];
 
         COPY (v, w);
         SUB (p2, x, a);
         PRODUCTADD (o, a, w);
-        pdata[0] = w[0]; pdata[1] = w[1]; pdata[2] = w[2]; pdata +=3;
+        pdata[3] = w[0]; pdata[4] = w[1]; pdata[5] = w[2];
 
         COPY (v, w);
         SUB (p3, x, a);
         PRODUCTADD (o, a, w);
-        pdata[0] = w[0]; pdata[1] = w[1]; pdata[2] = w[2]; pdata +=3;
+        pdata[6] = w[0]; pdata[7] = w[1]; pdata[8] = w[2];
       }
     }
 
-    ASSERT (H5LTmake_dataset_double (h5_step, "LINVEL", 2, dims, data) >= 0, "HDF5 file write error");
+    ASSERT (h5_make_dataset (h5_step, "LINVEL", 2, dims, data) >= 0, "HDF5 file write error");
   }
 
   length = num;
@@ -2187,71 +2329,74 @@ static void h5_triangle_dataset (int num, int *set, int ent, hid_t h5_step)
 
   if (ent & OUT_ANGVEL)
   {
-    pdata = data;
+#pragma omp parallel for if (num > OUTPUT_PARALLEL_SIZE)
     for (i = 0; i < num; i ++)
     {
-      j = triobs[set[i]];
+      double *pdata = data + 3*i;
+      int j = triobs[set[i]];
 
       if (j >= 0) /* particle */
       {
-        pdata[0] = angular[3][j]; pdata[1] = angular[4][j]; pdata[2] = angular[5][j]; pdata += 3;
+        pdata[0] = angular[3][j]; pdata[1] = angular[4][j]; pdata[2] = angular[5][j];
       }
       else if (j == -1) /* static obstacle */
       {
-        pdata[0] = 0.0; pdata[1] = 0.0; pdata[2] = 0.0; pdata += 3;
+        pdata[0] = 0.0; pdata[1] = 0.0; pdata[2] = 0.0;
       }
       else /* moving obstacle */
       {
         j = -j-2;
 
-        pdata[0] = obsang[3*j]; pdata[1] = obsang[3*j+1]; pdata[2] =  obsang[3*j+2]; pdata += 3;
+        pdata[0] = obsang[3*j]; pdata[1] = obsang[3*j+1]; pdata[2] =  obsang[3*j+2];
       }
     }
 
     hsize_t dims[2] = {num, 3};
-    ASSERT (H5LTmake_dataset_double (h5_step, "ANGVEL", 2, dims, data) >= 0, "HDF5 file write error");
+    ASSERT (h5_make_dataset (h5_step, "ANGVEL", 2, dims, data) >= 0, "HDF5 file write error");
   }
 
   if (ent & OUT_FORCE)
   {
-    pdata = data;
+#pragma omp parallel for if (num > OUTPUT_PARALLEL_SIZE)
     for (i = 0; i < num; i ++)
     {
-      j = triobs[set[i]];
+      double *pdata = data + 3*i;
+      int j = triobs[set[i]];
 
       if (j >= 0)
       {
-        pdata[0] = force[0][j]; pdata[1] = force[1][j]; pdata[2] = force[2][j]; pdata += 3;
+        pdata[0] = force[0][j]; pdata[1] = force[1][j]; pdata[2] = force[2][j];
       }
       else
       {
-        pdata[0] = 0.0; pdata[1] = 0.0; pdata[2] = 0.0; pdata += 3;
+        pdata[0] = 0.0; pdata[1] = 0.0; pdata[2] = 0.0;
       }
     }
 
     hsize_t dims[2] = {num, 3};
-    ASSERT (H5LTmake_dataset_double (h5_step, "FORCE", 2, dims, data) >= 0, "HDF5 file write error");
+    ASSERT (h5_make_dataset (h5_step, "FORCE", 2, dims, data) >= 0, "HDF5 file write error");
   }
 
   if (ent & OUT_TORQUE)
   {
-    pdata = data;
+#pragma omp parallel for if (num > OUTPUT_PARALLEL_SIZE)
     for (i = 0; i < num; i ++)
     {
-      j = triobs[set[i]];
+      double *pdata = data + 3*i;
+      int j = triobs[set[i]];
 
       if (j >= 0)
       {
-        pdata[0] = torque[0][j]; pdata[1] = torque[1][j]; pdata[2] = torque[2][j]; pdata += 3;
+        pdata[0] = torque[0][j]; pdata[1] = torque[1][j]; pdata[2] = torque[2][j];
       }
       else
       {
-        pdata[0] = 0.0; pdata[1] = 0.0; pdata[2] = 0.0; pdata += 3;
+        pdata[0] = 0.0; pdata[1] = 0.0; pdata[2] = 0.0;
       }
     }
 
     hsize_t dims[2] = {num, 3};
-    ASSERT (H5LTmake_dataset_double (h5_step, "TORQUE", 2, dims, data) >= 0, "HDF5 file write error");
+    ASSERT (h5_make_dataset (h5_step, "TORQUE", 2, dims, data) >= 0, "HDF5 file write error");
   }
 
   delete [] data;
@@ -2779,6 +2924,108 @@ static void med_triangle_dataset (int num, int *set, int ent, med_idt fid)
 }
 #endif
 
+static set<string> output_paths; /* output files created during this run */
+
+/* test whether an output file has already been created during this run */
+static int output_created (const char *path)
+{
+  return output_paths.insert(path).second == false;
+}
+
+/* get region of interest and decimation of output set j (j < 0: unselected particles) */
+static void output_filter (int j, int *roi, REAL reg[6], int dec[2])
+{
+  if (j < 0)
+  {
+    *roi = outrestroi;
+    for (int i = 0; i < 6; i ++) reg[i] = outrestreg[i];
+    dec[0] = outrestdec[0];
+    dec[1] = outrestdec[1];
+  }
+  else
+  {
+    *roi = outroi[j];
+    for (int i = 0; i < 6; i ++) reg[i] = outreg[i][j];
+    dec[0] = outdec[0][j];
+    dec[1] = outdec[1][j];
+  }
+}
+
+/* test whether the current frame is output for decimation level n */
+inline static int output_level (int n)
+{
+  return n > 0 && output_frame % n == 0;
+}
+
+/* test whether any particle of output set j can be output at the current frame */
+static int output_active (int j)
+{
+  int roi, dec[2];
+  REAL reg[6];
+
+  output_filter (j, &roi, reg, dec);
+
+  return output_level (dec[0]) || (roi != OUT_ROI_NONE && output_level (dec[1]));
+}
+
+/* test whether particle k of output set j (j < 0: unselected particles) is output at the current frame */
+static int output_selected (int j, int k)
+{
+  int roi, dec[2], inside;
+  REAL reg[6];
+
+  if (j < 0 && !(flags[k] & OUTREST)) return 0;
+
+  output_filter (j, &roi, reg, dec);
+
+  switch (roi)
+  {
+    case OUT_ROI_SPHERE:
+      {
+        REAL d[3] = {position[0][k]-reg[0], position[1][k]-reg[1], position[2][k]-reg[2]};
+        inside = DOT(d,d) <= reg[3]*reg[3];
+      }
+      break;
+    case OUT_ROI_BOX:
+      inside = position[0][k] >= reg[0] && position[1][k] >= reg[1] && position[2][k] >= reg[2] &&
+               position[0][k] <= reg[3] && position[1][k] <= reg[4] && position[2][k] <= reg[5];
+      break;
+    default:
+      inside = 1;
+      break;
+  }
+
+  return output_level (dec[inside ? 0 : 1]);
+}
+
+/* select particles of output set j (j >= 0) output at the current frame;
+ * return their number and point *pset at the selection */
+static int output_particle_set (int j, int **pset)
+{
+  static thread_local vector<int> selection; /* output sets are selected in parallel */
+  int roi, dec[2];
+  REAL reg[6];
+
+  output_filter (j, &roi, reg, dec);
+
+  if (roi == OUT_ROI_NONE) /* decimation applies to the whole set */
+  {
+    *pset = &outpart[outidx[j]];
+    return output_level (dec[0]) ? outidx[j+1]-outidx[j] : 0;
+  }
+
+  selection.clear();
+
+  for (int i = outidx[j]; i < outidx[j+1]; i ++)
+  {
+    if (output_selected (j, outpart[i])) selection.push_back (outpart[i]);
+  }
+
+  *pset = selection.data();
+
+  return selection.size();
+}
+
 /* find ellipsoids belonging to a particle set [part0, part1) */
 static int find_ellipsoid_set (int *part0, int *part1, int *ellipsoids)
 {
@@ -3212,7 +3459,7 @@ static void h5_linear_spring_dataset (int num, int *set, int ent, hid_t h5_step)
     data[3*i+2] = 0.5*(sprpnt[0][2][j]+sprpnt[1][2][j]);
   }
   hsize_t dims[2] = {num, 3};
-  ASSERT (H5LTmake_dataset_double (h5_step, "GEOM", 2, dims, data) >= 0, "HDF5 file write error");
+  ASSERT (h5_make_dataset (h5_step, "GEOM", 2, dims, data) >= 0, "HDF5 file write error");
 
   if (ent & OUT_NUMBER)
   {
@@ -3239,7 +3486,7 @@ static void h5_linear_spring_dataset (int num, int *set, int ent, hid_t h5_step)
     }
 
     hsize_t length = num;
-    ASSERT (H5LTmake_dataset_double (h5_step, "DISPL", 1, &length, data) >= 0, "HDF5 file write error");
+    ASSERT (h5_make_dataset (h5_step, "DISPL", 1, &length, data) >= 0, "HDF5 file write error");
   }
 
   if (ent & OUT_LENGTH)
@@ -3254,7 +3501,7 @@ static void h5_linear_spring_dataset (int num, int *set, int ent, hid_t h5_step)
     }
 
     hsize_t length = num;
-    ASSERT (H5LTmake_dataset_double (h5_step, "LENGTH", 1, &length, data) >= 0, "HDF5 file write error");
+    ASSERT (h5_make_dataset (h5_step, "LENGTH", 1, &length, data) >= 0, "HDF5 file write error");
   }
 
   if (ent & OUT_ORIENT)
@@ -3267,7 +3514,7 @@ static void h5_linear_spring_dataset (int num, int *set, int ent, hid_t h5_step)
       pdata[2] = sprdir[2][j];
     }
 
-    ASSERT (H5LTmake_dataset_double (h5_step, "ORIENT", 2, dims, data) >= 0, "HDF5 file write error");
+    ASSERT (h5_make_dataset (h5_step, "ORIENT", 2, dims, data) >= 0, "HDF5 file write error");
   }
 
   if (ent & OUT_F)
@@ -3279,7 +3526,7 @@ static void h5_linear_spring_dataset (int num, int *set, int ent, hid_t h5_step)
     }
 
     hsize_t length = num;
-    ASSERT (H5LTmake_dataset_double (h5_step, "F", 1, &length, data) >= 0, "HDF5 file write error");
+    ASSERT (h5_make_dataset (h5_step, "F", 1, &length, data) >= 0, "HDF5 file write error");
   }
 
   if (ent & OUT_SF)
@@ -3291,7 +3538,7 @@ static void h5_linear_spring_dataset (int num, int *set, int ent, hid_t h5_step)
     }
 
     hsize_t length = num;
-    ASSERT (H5LTmake_dataset_double (h5_step, "SF", 1, &length, data) >= 0, "HDF5 file write error");
+    ASSERT (h5_make_dataset (h5_step, "SF", 1, &length, data) >= 0, "HDF5 file write error");
   }
 
   if (ent & OUT_FF)
@@ -3303,7 +3550,7 @@ static void h5_linear_spring_dataset (int num, int *set, int ent, hid_t h5_step)
     }
 
     hsize_t length = num;
-    ASSERT (H5LTmake_dataset_double (h5_step, "FF", 1, &length, data) >= 0, "HDF5 file write error");
+    ASSERT (h5_make_dataset (h5_step, "FF", 1, &length, data) >= 0, "HDF5 file write error");
   }
 
   if (ent & OUT_SS)
@@ -3315,7 +3562,7 @@ static void h5_linear_spring_dataset (int num, int *set, int ent, hid_t h5_step)
     }
 
     hsize_t length = num;
-    ASSERT (H5LTmake_dataset_double (h5_step, "SS", 1, &length, data) >= 0, "HDF5 file write error");
+    ASSERT (h5_make_dataset (h5_step, "SS", 1, &length, data) >= 0, "HDF5 file write error");
   }
 
   delete [] data;
@@ -3369,7 +3616,7 @@ static void h5_torsional_spring_dataset (int num, int *set, int ent, hid_t h5_st
     data[3*i+2] = refpnt[2];
   }
   hsize_t dims[2] = {num, 3};
-  ASSERT (H5LTmake_dataset_double (h5_step, "GEOM", 2, dims, data) >= 0, "HDF5 file write error");
+  ASSERT (h5_make_dataset (h5_step, "GEOM", 2, dims, data) >= 0, "HDF5 file write error");
 
   if (ent & OUT_NUMBER)
   {
@@ -3397,7 +3644,7 @@ static void h5_torsional_spring_dataset (int num, int *set, int ent, hid_t h5_st
       pdata[2] = trqzdir1[2][j];
     }
 
-    ASSERT (H5LTmake_dataset_double (h5_step, "ZDIR", 2, dims, data) >= 0, "HDF5 file write error");
+    ASSERT (h5_make_dataset (h5_step, "ZDIR", 2, dims, data) >= 0, "HDF5 file write error");
   }
 
   if (ent & OUT_XDIR)
@@ -3410,7 +3657,7 @@ static void h5_torsional_spring_dataset (int num, int *set, int ent, hid_t h5_st
       pdata[2] = trqxdir1[2][j];
     }
 
-    ASSERT (H5LTmake_dataset_double (h5_step, "XDIR", 2, dims, data) >= 0, "HDF5 file write error");
+    ASSERT (h5_make_dataset (h5_step, "XDIR", 2, dims, data) >= 0, "HDF5 file write error");
   }
 
   if (ent & OUT_YDIR)
@@ -3430,7 +3677,7 @@ static void h5_torsional_spring_dataset (int num, int *set, int ent, hid_t h5_st
       pdata[2] = ydir[2];
     }
 
-    ASSERT (H5LTmake_dataset_double (h5_step, "YDIR", 2, dims, data) >= 0, "HDF5 file write error");
+    ASSERT (h5_make_dataset (h5_step, "YDIR", 2, dims, data) >= 0, "HDF5 file write error");
   }
 
   if (ent & OUT_TRQROT)
@@ -3454,7 +3701,7 @@ static void h5_torsional_spring_dataset (int num, int *set, int ent, hid_t h5_st
       pdata[2] = trqrot[2];
     }
 
-    ASSERT (H5LTmake_dataset_double (h5_step, "TRQROT", 2, dims, data) >= 0, "HDF5 file write error");
+    ASSERT (h5_make_dataset (h5_step, "TRQROT", 2, dims, data) >= 0, "HDF5 file write error");
   }
 
   if (ent & OUT_TRQTOT)
@@ -3478,7 +3725,7 @@ static void h5_torsional_spring_dataset (int num, int *set, int ent, hid_t h5_st
       pdata[2] = trqtot[2];
     }
 
-    ASSERT (H5LTmake_dataset_double (h5_step, "TRQTOT", 2, dims, data) >= 0, "HDF5 file write error");
+    ASSERT (h5_make_dataset (h5_step, "TRQTOT", 2, dims, data) >= 0, "HDF5 file write error");
   }
 
   if (ent & OUT_TRQSPR)
@@ -3502,7 +3749,7 @@ static void h5_torsional_spring_dataset (int num, int *set, int ent, hid_t h5_st
       pdata[2] = trqspr[2];
     }
 
-    ASSERT (H5LTmake_dataset_double (h5_step, "TRQSPR", 2, dims, data) >= 0, "HDF5 file write error");
+    ASSERT (h5_make_dataset (h5_step, "TRQSPR", 2, dims, data) >= 0, "HDF5 file write error");
   }
 
   delete [] data;
@@ -3536,7 +3783,7 @@ static void h5_joints_dataset (int num, int *set, int ent, hid_t h5_step)
     data[3*i+2] = refpnt[2];
   }
   hsize_t dims[2] = {num, 3};
-  ASSERT (H5LTmake_dataset_double (h5_step, "GEOM", 2, dims, data) >= 0, "HDF5 file write error");
+  ASSERT (h5_make_dataset (h5_step, "GEOM", 2, dims, data) >= 0, "HDF5 file write error");
 
   if (ent & OUT_NUMBER)
   {
@@ -3564,18 +3811,43 @@ static void h5_joints_dataset (int num, int *set, int ent, hid_t h5_step)
       pdata[2] = jreac[2][j];
     }
 
-    ASSERT (H5LTmake_dataset_double (h5_step, "JREAC", 2, dims, data) >= 0, "HDF5 file write error");
+    ASSERT (h5_make_dataset (h5_step, "JREAC", 2, dims, data) >= 0, "HDF5 file write error");
   }
 
   delete [] data;
 }
 
+/* open .h5 output file (create it at its first use during this run) and create the next frame group in it;
+ * frame groups are numbered consecutively in each file, so that decimated output sets remain readable */
+static hid_t h5_open_frame (const char *h5_path, hid_t *h5_step, int *frame)
+{
+  hid_t h5_file;
+  hsize_t num;
+  char text[64];
+
+  if (output_created (h5_path))
+  {
+    ASSERT((h5_file = H5Fopen(h5_path, H5F_ACC_RDWR, H5P_DEFAULT)) >= 0, "HDF5 file open error");
+  }
+  else
+  {
+    ASSERT ((h5_file = H5Fcreate(h5_path, H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT)) >= 0, "HDF5 file open error");
+  }
+
+  H5Gget_num_objs (h5_file, &num);
+  *frame = num;
+  snprintf (text, 64, "%d", *frame);
+  ASSERT ((*h5_step = H5Gcreate (h5_file, text, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT)) >= 0, "HDF5 file write error");
+
+  return h5_file;
+}
+
 /* append an XMF file */
-static void append_xmf_file (const char *xmf_path, int mode, int elements, int nodes, int topo_size, const char *label, const char *h5file, int ent)
+static void append_xmf_file (const char *xmf_path, int mode, int elements, int nodes, int topo_size, const char *label, const char *h5file, int ent, int frame)
 {
   FILE *xmf_file;
 
-  if (curtime == 0.0)
+  if (!output_created (xmf_path))
   {
     ASSERT(xmf_file = fopen (xmf_path, "w"), "XMF markup file open failed");
 
@@ -3615,7 +3887,7 @@ static void append_xmf_file (const char *xmf_path, int mode, int elements, int n
     case OUT_MODE_MESH:
       fprintf (xmf_file, "<Topology Type=\"Mixed\" NumberOfElements=\"%d\">\n", elements);
       fprintf (xmf_file, "<DataStructure Dimensions=\"%d\" NumberType=\"Int\" Format=\"HDF\">\n", topo_size);
-      fprintf (xmf_file, "%s:/%d/TOPO\n", h5file, output_frame);
+      fprintf (xmf_file, "%s:/%d/TOPO\n", h5file, frame);
       fprintf (xmf_file, "</DataStructure>\n");
       fprintf (xmf_file, "</Topology>\n");
       break;
@@ -3628,8 +3900,8 @@ static void append_xmf_file (const char *xmf_path, int mode, int elements, int n
   }
 
   fprintf (xmf_file, "<Geometry GeometryType=\"XYZ\">\n");
-  fprintf (xmf_file, "<DataStructure Dimensions=\"%d 3\" NumberType=\"Float\" Presicion=\"8\" Format=\"HDF\">\n", nodes);
-  fprintf (xmf_file, "%s:/%d/GEOM\n", h5file, output_frame);
+  fprintf (xmf_file, "<DataStructure Dimensions=\"%d 3\" NumberType=\"Float\" Precision=\"%d\" Format=\"HDF\">\n", nodes, h5_precision_bytes ("GEOM"));
+  fprintf (xmf_file, "%s:/%d/GEOM\n", h5file, frame);
   fprintf (xmf_file, "</DataStructure>\n");
   fprintf (xmf_file, "</Geometry>\n");
 
@@ -3640,8 +3912,8 @@ static void append_xmf_file (const char *xmf_path, int mode, int elements, int n
       if (ent & OUT_DISPL)
       {
         fprintf (xmf_file, "<Attribute Name=\"DISPL\" Center=\"Node\" AttributeType=\"Vector\">\n");
-        fprintf (xmf_file, "<DataStructure Dimensions=\"%d 3\" NumberType=\"Float\" Presicion=\"8\" Format=\"HDF\">\n", nodes);
-        fprintf (xmf_file, "%s:/%d/DISPL\n", h5file, output_frame);
+        fprintf (xmf_file, "<DataStructure Dimensions=\"%d 3\" NumberType=\"Float\" Precision=\"%d\" Format=\"HDF\">\n", nodes, h5_precision_bytes ("DISPL"));
+        fprintf (xmf_file, "%s:/%d/DISPL\n", h5file, frame);
         fprintf (xmf_file, "</DataStructure>\n");
         fprintf (xmf_file, "</Attribute>\n");
       }
@@ -3649,8 +3921,8 @@ static void append_xmf_file (const char *xmf_path, int mode, int elements, int n
       if (ent & OUT_LINVEL)
       {
         fprintf (xmf_file, "<Attribute Name=\"LINVEL\" Center=\"Node\" AttributeType=\"Vector\">\n");
-        fprintf (xmf_file, "<DataStructure Dimensions=\"%d 3\" NumberType=\"Float\" Presicion=\"8\" Format=\"HDF\">\n", nodes);
-        fprintf (xmf_file, "%s:/%d/LINVEL\n", h5file, output_frame);
+        fprintf (xmf_file, "<DataStructure Dimensions=\"%d 3\" NumberType=\"Float\" Precision=\"%d\" Format=\"HDF\">\n", nodes, h5_precision_bytes ("LINVEL"));
+        fprintf (xmf_file, "%s:/%d/LINVEL\n", h5file, frame);
         fprintf (xmf_file, "</DataStructure>\n");
         fprintf (xmf_file, "</Attribute>\n");
       }
@@ -3659,7 +3931,7 @@ static void append_xmf_file (const char *xmf_path, int mode, int elements, int n
       {
         fprintf (xmf_file, "<Attribute Name=\"NUMBER\" Center=\"Cell\" AttributeType=\"Scalar\">\n");
         fprintf (xmf_file, "<DataStructure Dimensions=\"%d\" NumberType=\"Int\" Format=\"HDF\">\n", elements);
-        fprintf (xmf_file, "%s:/%d/NUMBER\n", h5file, output_frame);
+        fprintf (xmf_file, "%s:/%d/NUMBER\n", h5file, frame);
         fprintf (xmf_file, "</DataStructure>\n");
         fprintf (xmf_file, "</Attribute>\n");
       }
@@ -3668,7 +3940,7 @@ static void append_xmf_file (const char *xmf_path, int mode, int elements, int n
       {
         fprintf (xmf_file, "<Attribute Name=\"COLOR\" Center=\"Cell\" AttributeType=\"Scalar\">\n");
         fprintf (xmf_file, "<DataStructure Dimensions=\"%d\" NumberType=\"Int\" Format=\"HDF\">\n", elements);
-        fprintf (xmf_file, "%s:/%d/COLOR\n", h5file, output_frame);
+        fprintf (xmf_file, "%s:/%d/COLOR\n", h5file, frame);
         fprintf (xmf_file, "</DataStructure>\n");
         fprintf (xmf_file, "</Attribute>\n");
       }
@@ -3676,8 +3948,8 @@ static void append_xmf_file (const char *xmf_path, int mode, int elements, int n
       if (ent & OUT_ANGVEL)
       {
         fprintf (xmf_file, "<Attribute Name=\"ANGVEL\" Center=\"Cell\" AttributeType=\"Vector\">\n");
-        fprintf (xmf_file, "<DataStructure Dimensions=\"%d 3\" NumberType=\"Float\" Presicion=\"8\" Format=\"HDF\">\n", elements);
-        fprintf (xmf_file, "%s:/%d/ANGVEL\n", h5file, output_frame);
+        fprintf (xmf_file, "<DataStructure Dimensions=\"%d 3\" NumberType=\"Float\" Precision=\"%d\" Format=\"HDF\">\n", elements, h5_precision_bytes ("ANGVEL"));
+        fprintf (xmf_file, "%s:/%d/ANGVEL\n", h5file, frame);
         fprintf (xmf_file, "</DataStructure>\n");
         fprintf (xmf_file, "</Attribute>\n");
       }
@@ -3685,8 +3957,8 @@ static void append_xmf_file (const char *xmf_path, int mode, int elements, int n
       if (ent & OUT_FORCE)
       {
         fprintf (xmf_file, "<Attribute Name=\"FORCE\" Center=\"Cell\" AttributeType=\"Vector\">\n");
-        fprintf (xmf_file, "<DataStructure Dimensions=\"%d 3\" NumberType=\"Float\" Presicion=\"8\" Format=\"HDF\">\n", elements);
-        fprintf (xmf_file, "%s:/%d/FORCE\n", h5file, output_frame);
+        fprintf (xmf_file, "<DataStructure Dimensions=\"%d 3\" NumberType=\"Float\" Precision=\"%d\" Format=\"HDF\">\n", elements, h5_precision_bytes ("FORCE"));
+        fprintf (xmf_file, "%s:/%d/FORCE\n", h5file, frame);
         fprintf (xmf_file, "</DataStructure>\n");
         fprintf (xmf_file, "</Attribute>\n");
       }
@@ -3694,8 +3966,8 @@ static void append_xmf_file (const char *xmf_path, int mode, int elements, int n
       if (ent & OUT_TORQUE)
       {
         fprintf (xmf_file, "<Attribute Name=\"TORQUE\" Center=\"Cell\" AttributeType=\"Vector\">\n");
-        fprintf (xmf_file, "<DataStructure Dimensions=\"%d 3\" NumberType=\"Float\" Presicion=\"8\" Format=\"HDF\">\n", elements);
-        fprintf (xmf_file, "%s:/%d/TORQUE\n", h5file, output_frame);
+        fprintf (xmf_file, "<DataStructure Dimensions=\"%d 3\" NumberType=\"Float\" Precision=\"%d\" Format=\"HDF\">\n", elements, h5_precision_bytes ("TORQUE"));
+        fprintf (xmf_file, "%s:/%d/TORQUE\n", h5file, frame);
         fprintf (xmf_file, "</DataStructure>\n");
         fprintf (xmf_file, "</Attribute>\n");
       }
@@ -3706,8 +3978,8 @@ static void append_xmf_file (const char *xmf_path, int mode, int elements, int n
       if (ent & OUT_DISPL)
       {
         fprintf (xmf_file, "<Attribute Name=\"DISPL\" Center=\"Node\" AttributeType=\"Vector\">\n");
-        fprintf (xmf_file, "<DataStructure Dimensions=\"%d 3\" NumberType=\"Float\" Presicion=\"8\" Format=\"HDF\">\n", nodes);
-        fprintf (xmf_file, "%s:/%d/DISPL\n", h5file, output_frame);
+        fprintf (xmf_file, "<DataStructure Dimensions=\"%d 3\" NumberType=\"Float\" Precision=\"%d\" Format=\"HDF\">\n", nodes, h5_precision_bytes ("DISPL"));
+        fprintf (xmf_file, "%s:/%d/DISPL\n", h5file, frame);
         fprintf (xmf_file, "</DataStructure>\n");
         fprintf (xmf_file, "</Attribute>\n");
       }
@@ -3715,8 +3987,8 @@ static void append_xmf_file (const char *xmf_path, int mode, int elements, int n
       if (ent & OUT_LINVEL)
       {
         fprintf (xmf_file, "<Attribute Name=\"LINVEL\" Center=\"Node\" AttributeType=\"Vector\">\n");
-        fprintf (xmf_file, "<DataStructure Dimensions=\"%d 3\" NumberType=\"Float\" Presicion=\"8\" Format=\"HDF\">\n", nodes);
-        fprintf (xmf_file, "%s:/%d/LINVEL\n", h5file, output_frame);
+        fprintf (xmf_file, "<DataStructure Dimensions=\"%d 3\" NumberType=\"Float\" Precision=\"%d\" Format=\"HDF\">\n", nodes, h5_precision_bytes ("LINVEL"));
+        fprintf (xmf_file, "%s:/%d/LINVEL\n", h5file, frame);
         fprintf (xmf_file, "</DataStructure>\n");
         fprintf (xmf_file, "</Attribute>\n");
       }
@@ -3725,7 +3997,7 @@ static void append_xmf_file (const char *xmf_path, int mode, int elements, int n
       {
         fprintf (xmf_file, "<Attribute Name=\"NUMBER\" Center=\"Node\" AttributeType=\"Scalar\">\n");
         fprintf (xmf_file, "<DataStructure Dimensions=\"%d\" NumberType=\"Int\" Format=\"HDF\">\n", nodes);
-        fprintf (xmf_file, "%s:/%d/NUMBER\n", h5file, output_frame);
+        fprintf (xmf_file, "%s:/%d/NUMBER\n", h5file, frame);
         fprintf (xmf_file, "</DataStructure>\n");
         fprintf (xmf_file, "</Attribute>\n");
       }
@@ -3733,8 +4005,8 @@ static void append_xmf_file (const char *xmf_path, int mode, int elements, int n
       if (ent & OUT_ANGVEL)
       {
         fprintf (xmf_file, "<Attribute Name=\"ANGVEL\" Center=\"Node\" AttributeType=\"Vector\">\n");
-        fprintf (xmf_file, "<DataStructure Dimensions=\"%d 3\" NumberType=\"Float\" Presicion=\"8\" Format=\"HDF\">\n", nodes);
-        fprintf (xmf_file, "%s:/%d/ANGVEL\n", h5file, output_frame);
+        fprintf (xmf_file, "<DataStructure Dimensions=\"%d 3\" NumberType=\"Float\" Precision=\"%d\" Format=\"HDF\">\n", nodes, h5_precision_bytes ("ANGVEL"));
+        fprintf (xmf_file, "%s:/%d/ANGVEL\n", h5file, frame);
         fprintf (xmf_file, "</DataStructure>\n");
         fprintf (xmf_file, "</Attribute>\n");
       }
@@ -3742,8 +4014,8 @@ static void append_xmf_file (const char *xmf_path, int mode, int elements, int n
       if (ent & OUT_FORCE)
       {
         fprintf (xmf_file, "<Attribute Name=\"FORCE\" Center=\"Node\" AttributeType=\"Vector\">\n");
-        fprintf (xmf_file, "<DataStructure Dimensions=\"%d 3\" NumberType=\"Float\" Presicion=\"8\" Format=\"HDF\">\n", nodes);
-        fprintf (xmf_file, "%s:/%d/FORCE\n", h5file, output_frame);
+        fprintf (xmf_file, "<DataStructure Dimensions=\"%d 3\" NumberType=\"Float\" Precision=\"%d\" Format=\"HDF\">\n", nodes, h5_precision_bytes ("FORCE"));
+        fprintf (xmf_file, "%s:/%d/FORCE\n", h5file, frame);
         fprintf (xmf_file, "</DataStructure>\n");
         fprintf (xmf_file, "</Attribute>\n");
       }
@@ -3751,8 +4023,8 @@ static void append_xmf_file (const char *xmf_path, int mode, int elements, int n
       if (ent & OUT_TORQUE)
       {
         fprintf (xmf_file, "<Attribute Name=\"TORQUE\" Center=\"Node\" AttributeType=\"Vector\">\n");
-        fprintf (xmf_file, "<DataStructure Dimensions=\"%d 3\" NumberType=\"Float\" Presicion=\"8\" Format=\"HDF\">\n", nodes);
-        fprintf (xmf_file, "%s:/%d/TORQUE\n", h5file, output_frame);
+        fprintf (xmf_file, "<DataStructure Dimensions=\"%d 3\" NumberType=\"Float\" Precision=\"%d\" Format=\"HDF\">\n", nodes, h5_precision_bytes ("TORQUE"));
+        fprintf (xmf_file, "%s:/%d/TORQUE\n", h5file, frame);
         fprintf (xmf_file, "</DataStructure>\n");
         fprintf (xmf_file, "</Attribute>\n");
       }
@@ -3760,8 +4032,8 @@ static void append_xmf_file (const char *xmf_path, int mode, int elements, int n
       if (ent & OUT_ORIENT)
       {
         fprintf (xmf_file, "<Attribute Name=\"ORIENT\" Center=\"Node\" AttributeType=\"Tensor\">\n");
-        fprintf (xmf_file, "<DataStructure Dimensions=\"%d 9\" NumberType=\"Float\" Presicion=\"8\" Format=\"HDF\">\n", nodes);
-        fprintf (xmf_file, "%s:/%d/ORIENT\n", h5file, output_frame);
+        fprintf (xmf_file, "<DataStructure Dimensions=\"%d 9\" NumberType=\"Float\" Precision=\"%d\" Format=\"HDF\">\n", nodes, h5_precision_bytes ("ORIENT"));
+        fprintf (xmf_file, "%s:/%d/ORIENT\n", h5file, frame);
         fprintf (xmf_file, "</DataStructure>\n");
         fprintf (xmf_file, "</Attribute>\n");
       }
@@ -3769,8 +4041,8 @@ static void append_xmf_file (const char *xmf_path, int mode, int elements, int n
       if (ent & OUT_ORIENT1)
       {
         fprintf (xmf_file, "<Attribute Name=\"ORIENT1\" Center=\"Node\" AttributeType=\"Vector\">\n");
-        fprintf (xmf_file, "<DataStructure Dimensions=\"%d 3\" NumberType=\"Float\" Presicion=\"8\" Format=\"HDF\">\n", nodes);
-        fprintf (xmf_file, "%s:/%d/ORIENT1\n", h5file, output_frame);
+        fprintf (xmf_file, "<DataStructure Dimensions=\"%d 3\" NumberType=\"Float\" Precision=\"%d\" Format=\"HDF\">\n", nodes, h5_precision_bytes ("ORIENT1"));
+        fprintf (xmf_file, "%s:/%d/ORIENT1\n", h5file, frame);
         fprintf (xmf_file, "</DataStructure>\n");
         fprintf (xmf_file, "</Attribute>\n");
       }
@@ -3778,8 +4050,8 @@ static void append_xmf_file (const char *xmf_path, int mode, int elements, int n
       if (ent & OUT_ORIENT2)
       {
         fprintf (xmf_file, "<Attribute Name=\"ORIENT2\" Center=\"Node\" AttributeType=\"Vector\">\n");
-        fprintf (xmf_file, "<DataStructure Dimensions=\"%d 3\" NumberType=\"Float\" Presicion=\"8\" Format=\"HDF\">\n", nodes);
-        fprintf (xmf_file, "%s:/%d/ORIENT2\n", h5file, output_frame);
+        fprintf (xmf_file, "<DataStructure Dimensions=\"%d 3\" NumberType=\"Float\" Precision=\"%d\" Format=\"HDF\">\n", nodes, h5_precision_bytes ("ORIENT2"));
+        fprintf (xmf_file, "%s:/%d/ORIENT2\n", h5file, frame);
         fprintf (xmf_file, "</DataStructure>\n");
         fprintf (xmf_file, "</Attribute>\n");
       }
@@ -3787,8 +4059,8 @@ static void append_xmf_file (const char *xmf_path, int mode, int elements, int n
       if (ent & OUT_ORIENT3)
       {
         fprintf (xmf_file, "<Attribute Name=\"ORIENT3\" Center=\"Node\" AttributeType=\"Vector\">\n");
-        fprintf (xmf_file, "<DataStructure Dimensions=\"%d 3\" NumberType=\"Float\" Presicion=\"8\" Format=\"HDF\">\n", nodes);
-        fprintf (xmf_file, "%s:/%d/ORIENT3\n", h5file, output_frame);
+        fprintf (xmf_file, "<DataStructure Dimensions=\"%d 3\" NumberType=\"Float\" Precision=\"%d\" Format=\"HDF\">\n", nodes, h5_precision_bytes ("ORIENT3"));
+        fprintf (xmf_file, "%s:/%d/ORIENT3\n", h5file, frame);
         fprintf (xmf_file, "</DataStructure>\n");
         fprintf (xmf_file, "</Attribute>\n");
       }
@@ -3799,7 +4071,7 @@ static void append_xmf_file (const char *xmf_path, int mode, int elements, int n
       {
         fprintf (xmf_file, "<Attribute Name=\"NUMBER\" Center=\"Node\" AttributeType=\"Scalar\">\n");
         fprintf (xmf_file, "<DataStructure Dimensions=\"%d\" NumberType=\"Int\" Format=\"HDF\">\n", nodes);
-        fprintf (xmf_file, "%s:/%d/NUMBER\n", h5file, output_frame);
+        fprintf (xmf_file, "%s:/%d/NUMBER\n", h5file, frame);
         fprintf (xmf_file, "</DataStructure>\n");
         fprintf (xmf_file, "</Attribute>\n");
       }
@@ -3807,8 +4079,8 @@ static void append_xmf_file (const char *xmf_path, int mode, int elements, int n
       if (ent & OUT_DISPL)
       {
         fprintf (xmf_file, "<Attribute Name=\"DISPL\" Center=\"Node\" AttributeType=\"Scalar\">\n");
-        fprintf (xmf_file, "<DataStructure Dimensions=\"%d\" NumberType=\"Float\" Presicion=\"8\" Format=\"HDF\">\n", nodes);
-        fprintf (xmf_file, "%s:/%d/DISPL\n", h5file, output_frame);
+        fprintf (xmf_file, "<DataStructure Dimensions=\"%d\" NumberType=\"Float\" Precision=\"%d\" Format=\"HDF\">\n", nodes, h5_precision_bytes ("DISPL"));
+        fprintf (xmf_file, "%s:/%d/DISPL\n", h5file, frame);
         fprintf (xmf_file, "</DataStructure>\n");
         fprintf (xmf_file, "</Attribute>\n");
       }
@@ -3816,8 +4088,8 @@ static void append_xmf_file (const char *xmf_path, int mode, int elements, int n
       if (ent & OUT_LENGTH)
       {
         fprintf (xmf_file, "<Attribute Name=\"LENGTH\" Center=\"Node\" AttributeType=\"Scalar\">\n");
-        fprintf (xmf_file, "<DataStructure Dimensions=\"%d\" NumberType=\"Float\" Presicion=\"8\" Format=\"HDF\">\n", nodes);
-        fprintf (xmf_file, "%s:/%d/LENGTH\n", h5file, output_frame);
+        fprintf (xmf_file, "<DataStructure Dimensions=\"%d\" NumberType=\"Float\" Precision=\"%d\" Format=\"HDF\">\n", nodes, h5_precision_bytes ("LENGTH"));
+        fprintf (xmf_file, "%s:/%d/LENGTH\n", h5file, frame);
         fprintf (xmf_file, "</DataStructure>\n");
         fprintf (xmf_file, "</Attribute>\n");
       }
@@ -3825,8 +4097,8 @@ static void append_xmf_file (const char *xmf_path, int mode, int elements, int n
       if (ent & OUT_ORIENT)
       {
         fprintf (xmf_file, "<Attribute Name=\"ORIENT\" Center=\"Node\" AttributeType=\"Vector\">\n");
-        fprintf (xmf_file, "<DataStructure Dimensions=\"%d 3\" NumberType=\"Float\" Presicion=\"8\" Format=\"HDF\">\n", nodes);
-        fprintf (xmf_file, "%s:/%d/ORIENT\n", h5file, output_frame);
+        fprintf (xmf_file, "<DataStructure Dimensions=\"%d 3\" NumberType=\"Float\" Precision=\"%d\" Format=\"HDF\">\n", nodes, h5_precision_bytes ("ORIENT"));
+        fprintf (xmf_file, "%s:/%d/ORIENT\n", h5file, frame);
         fprintf (xmf_file, "</DataStructure>\n");
         fprintf (xmf_file, "</Attribute>\n");
       }
@@ -3834,8 +4106,8 @@ static void append_xmf_file (const char *xmf_path, int mode, int elements, int n
       if (ent & OUT_F)
       {
         fprintf (xmf_file, "<Attribute Name=\"F\" Center=\"Node\" AttributeType=\"Scalar\">\n");
-        fprintf (xmf_file, "<DataStructure Dimensions=\"%d\" NumberType=\"Float\" Presicion=\"8\" Format=\"HDF\">\n", nodes);
-        fprintf (xmf_file, "%s:/%d/F\n", h5file, output_frame);
+        fprintf (xmf_file, "<DataStructure Dimensions=\"%d\" NumberType=\"Float\" Precision=\"%d\" Format=\"HDF\">\n", nodes, h5_precision_bytes ("F"));
+        fprintf (xmf_file, "%s:/%d/F\n", h5file, frame);
         fprintf (xmf_file, "</DataStructure>\n");
         fprintf (xmf_file, "</Attribute>\n");
       }
@@ -3843,8 +4115,8 @@ static void append_xmf_file (const char *xmf_path, int mode, int elements, int n
       if (ent & OUT_SF)
       {
         fprintf (xmf_file, "<Attribute Name=\"SF\" Center=\"Node\" AttributeType=\"Scalar\">\n");
-        fprintf (xmf_file, "<DataStructure Dimensions=\"%d\" NumberType=\"Float\" Presicion=\"8\" Format=\"HDF\">\n", nodes);
-        fprintf (xmf_file, "%s:/%d/SF\n", h5file, output_frame);
+        fprintf (xmf_file, "<DataStructure Dimensions=\"%d\" NumberType=\"Float\" Precision=\"%d\" Format=\"HDF\">\n", nodes, h5_precision_bytes ("SF"));
+        fprintf (xmf_file, "%s:/%d/SF\n", h5file, frame);
         fprintf (xmf_file, "</DataStructure>\n");
         fprintf (xmf_file, "</Attribute>\n");
       }
@@ -3852,8 +4124,8 @@ static void append_xmf_file (const char *xmf_path, int mode, int elements, int n
       if (ent & OUT_FF)
       {
         fprintf (xmf_file, "<Attribute Name=\"FF\" Center=\"Node\" AttributeType=\"Scalar\">\n");
-        fprintf (xmf_file, "<DataStructure Dimensions=\"%d\" NumberType=\"Float\" Presicion=\"8\" Format=\"HDF\">\n", nodes);
-        fprintf (xmf_file, "%s:/%d/FF\n", h5file, output_frame);
+        fprintf (xmf_file, "<DataStructure Dimensions=\"%d\" NumberType=\"Float\" Precision=\"%d\" Format=\"HDF\">\n", nodes, h5_precision_bytes ("FF"));
+        fprintf (xmf_file, "%s:/%d/FF\n", h5file, frame);
         fprintf (xmf_file, "</DataStructure>\n");
         fprintf (xmf_file, "</Attribute>\n");
       }
@@ -3861,8 +4133,8 @@ static void append_xmf_file (const char *xmf_path, int mode, int elements, int n
       if (ent & OUT_SS)
       {
         fprintf (xmf_file, "<Attribute Name=\"SS\" Center=\"Node\" AttributeType=\"Scalar\">\n");
-        fprintf (xmf_file, "<DataStructure Dimensions=\"%d\" NumberType=\"Float\" Presicion=\"8\" Format=\"HDF\">\n", nodes);
-        fprintf (xmf_file, "%s:/%d/SS\n", h5file, output_frame);
+        fprintf (xmf_file, "<DataStructure Dimensions=\"%d\" NumberType=\"Float\" Precision=\"%d\" Format=\"HDF\">\n", nodes, h5_precision_bytes ("SS"));
+        fprintf (xmf_file, "%s:/%d/SS\n", h5file, frame);
         fprintf (xmf_file, "</DataStructure>\n");
         fprintf (xmf_file, "</Attribute>\n");
       }
@@ -3874,7 +4146,7 @@ static void append_xmf_file (const char *xmf_path, int mode, int elements, int n
       {
         fprintf (xmf_file, "<Attribute Name=\"NUMBER\" Center=\"Node\" AttributeType=\"Scalar\">\n");
         fprintf (xmf_file, "<DataStructure Dimensions=\"%d\" NumberType=\"Int\" Format=\"HDF\">\n", nodes);
-        fprintf (xmf_file, "%s:/%d/NUMBER\n", h5file, output_frame);
+        fprintf (xmf_file, "%s:/%d/NUMBER\n", h5file, frame);
         fprintf (xmf_file, "</DataStructure>\n");
         fprintf (xmf_file, "</Attribute>\n");
       }
@@ -3882,8 +4154,8 @@ static void append_xmf_file (const char *xmf_path, int mode, int elements, int n
       if (ent & OUT_ZDIR)
       {
         fprintf (xmf_file, "<Attribute Name=\"ZDIR\" Center=\"Node\" AttributeType=\"Vector\">\n");
-        fprintf (xmf_file, "<DataStructure Dimensions=\"%d 3\" NumberType=\"Float\" Presicion=\"8\" Format=\"HDF\">\n", nodes);
-        fprintf (xmf_file, "%s:/%d/ZDIR\n", h5file, output_frame);
+        fprintf (xmf_file, "<DataStructure Dimensions=\"%d 3\" NumberType=\"Float\" Precision=\"%d\" Format=\"HDF\">\n", nodes, h5_precision_bytes ("ZDIR"));
+        fprintf (xmf_file, "%s:/%d/ZDIR\n", h5file, frame);
         fprintf (xmf_file, "</DataStructure>\n");
         fprintf (xmf_file, "</Attribute>\n");
       }
@@ -3891,8 +4163,8 @@ static void append_xmf_file (const char *xmf_path, int mode, int elements, int n
       if (ent & OUT_XDIR)
       {
         fprintf (xmf_file, "<Attribute Name=\"XDIR\" Center=\"Node\" AttributeType=\"Vector\">\n");
-        fprintf (xmf_file, "<DataStructure Dimensions=\"%d 3\" NumberType=\"Float\" Presicion=\"8\" Format=\"HDF\">\n", nodes);
-        fprintf (xmf_file, "%s:/%d/XDIR\n", h5file, output_frame);
+        fprintf (xmf_file, "<DataStructure Dimensions=\"%d 3\" NumberType=\"Float\" Precision=\"%d\" Format=\"HDF\">\n", nodes, h5_precision_bytes ("XDIR"));
+        fprintf (xmf_file, "%s:/%d/XDIR\n", h5file, frame);
         fprintf (xmf_file, "</DataStructure>\n");
         fprintf (xmf_file, "</Attribute>\n");
       }
@@ -3900,8 +4172,8 @@ static void append_xmf_file (const char *xmf_path, int mode, int elements, int n
       if (ent & OUT_YDIR)
       {
         fprintf (xmf_file, "<Attribute Name=\"YDIR\" Center=\"Node\" AttributeType=\"Vector\">\n");
-        fprintf (xmf_file, "<DataStructure Dimensions=\"%d 3\" NumberType=\"Float\" Presicion=\"8\" Format=\"HDF\">\n", nodes);
-        fprintf (xmf_file, "%s:/%d/YDIR\n", h5file, output_frame);
+        fprintf (xmf_file, "<DataStructure Dimensions=\"%d 3\" NumberType=\"Float\" Precision=\"%d\" Format=\"HDF\">\n", nodes, h5_precision_bytes ("YDIR"));
+        fprintf (xmf_file, "%s:/%d/YDIR\n", h5file, frame);
         fprintf (xmf_file, "</DataStructure>\n");
         fprintf (xmf_file, "</Attribute>\n");
       }
@@ -3909,8 +4181,8 @@ static void append_xmf_file (const char *xmf_path, int mode, int elements, int n
       if (ent & OUT_TRQROT)
       {
         fprintf (xmf_file, "<Attribute Name=\"TRQROT\" Center=\"Node\" AttributeType=\"Vector\">\n");
-        fprintf (xmf_file, "<DataStructure Dimensions=\"%d 3\" NumberType=\"Float\" Presicion=\"8\" Format=\"HDF\">\n", nodes);
-        fprintf (xmf_file, "%s:/%d/TRQROT\n", h5file, output_frame);
+        fprintf (xmf_file, "<DataStructure Dimensions=\"%d 3\" NumberType=\"Float\" Precision=\"%d\" Format=\"HDF\">\n", nodes, h5_precision_bytes ("TRQROT"));
+        fprintf (xmf_file, "%s:/%d/TRQROT\n", h5file, frame);
         fprintf (xmf_file, "</DataStructure>\n");
         fprintf (xmf_file, "</Attribute>\n");
       }
@@ -3918,8 +4190,8 @@ static void append_xmf_file (const char *xmf_path, int mode, int elements, int n
       if (ent & OUT_TRQTOT)
       {
         fprintf (xmf_file, "<Attribute Name=\"TRQTOT\" Center=\"Node\" AttributeType=\"Vector\">\n");
-        fprintf (xmf_file, "<DataStructure Dimensions=\"%d 3\" NumberType=\"Float\" Presicion=\"8\" Format=\"HDF\">\n", nodes);
-        fprintf (xmf_file, "%s:/%d/TRQTOT\n", h5file, output_frame);
+        fprintf (xmf_file, "<DataStructure Dimensions=\"%d 3\" NumberType=\"Float\" Precision=\"%d\" Format=\"HDF\">\n", nodes, h5_precision_bytes ("TRQTOT"));
+        fprintf (xmf_file, "%s:/%d/TRQTOT\n", h5file, frame);
         fprintf (xmf_file, "</DataStructure>\n");
         fprintf (xmf_file, "</Attribute>\n");
       }
@@ -3927,8 +4199,8 @@ static void append_xmf_file (const char *xmf_path, int mode, int elements, int n
       if (ent & OUT_TRQSPR)
       {
         fprintf (xmf_file, "<Attribute Name=\"TRQSPR\" Center=\"Node\" AttributeType=\"Vector\">\n");
-        fprintf (xmf_file, "<DataStructure Dimensions=\"%d 3\" NumberType=\"Float\" Presicion=\"8\" Format=\"HDF\">\n", nodes);
-        fprintf (xmf_file, "%s:/%d/TRQSPR\n", h5file, output_frame);
+        fprintf (xmf_file, "<DataStructure Dimensions=\"%d 3\" NumberType=\"Float\" Precision=\"%d\" Format=\"HDF\">\n", nodes, h5_precision_bytes ("TRQSPR"));
+        fprintf (xmf_file, "%s:/%d/TRQSPR\n", h5file, frame);
         fprintf (xmf_file, "</DataStructure>\n");
         fprintf (xmf_file, "</Attribute>\n");
       }
@@ -3940,7 +4212,7 @@ static void append_xmf_file (const char *xmf_path, int mode, int elements, int n
       {
         fprintf (xmf_file, "<Attribute Name=\"NUMBER\" Center=\"Node\" AttributeType=\"Scalar\">\n");
         fprintf (xmf_file, "<DataStructure Dimensions=\"%d\" NumberType=\"Int\" Format=\"HDF\">\n", nodes);
-        fprintf (xmf_file, "%s:/%d/NUMBER\n", h5file, output_frame);
+        fprintf (xmf_file, "%s:/%d/NUMBER\n", h5file, frame);
         fprintf (xmf_file, "</DataStructure>\n");
         fprintf (xmf_file, "</Attribute>\n");
       }
@@ -3948,8 +4220,8 @@ static void append_xmf_file (const char *xmf_path, int mode, int elements, int n
       if (ent & OUT_JREAC)
       {
         fprintf (xmf_file, "<Attribute Name=\"JREAC\" Center=\"Node\" AttributeType=\"Vector\">\n");
-        fprintf (xmf_file, "<DataStructure Dimensions=\"%d 3\" NumberType=\"Float\" Presicion=\"8\" Format=\"HDF\">\n", nodes);
-        fprintf (xmf_file, "%s:/%d/JREAC\n", h5file, output_frame);
+        fprintf (xmf_file, "<DataStructure Dimensions=\"%d 3\" NumberType=\"Float\" Precision=\"%d\" Format=\"HDF\">\n", nodes, h5_precision_bytes ("JREAC"));
+        fprintf (xmf_file, "%s:/%d/JREAC\n", h5file, frame);
         fprintf (xmf_file, "</DataStructure>\n");
         fprintf (xmf_file, "</Attribute>\n");
       }
@@ -3967,63 +4239,57 @@ static void append_xmf_file (const char *xmf_path, int mode, int elements, int n
 /* output XDMF files */
 static void output_xdmf_files ()
 {
-  ostringstream h5_path, h5_text, xmf_path;
-  FILE *xmf_file;
+  ostringstream h5_path, xmf_path;
   hid_t h5_file;
   hid_t h5_step;
+  int h5_frame, i, j;
 
   if (trinum)
   {
-    int i, j, num, ent, *set; /* number of and the set of triangles */
+    vector<vector<int> > sets (outnum+1); /* sets[j+1]: selection of output set j */
 
-    ERRMEM (set = new int[trinum]);
-
-    for (j = -1; j < outnum; j ++) /* for each output set */
+#pragma omp parallel for schedule(dynamic)
+    for (int j = -1; j < outnum; j ++) /* output sets are selected in parallel */
     {
-      num = 0;
+      if (!output_active (j)) continue; /* decimated frame */
+
+      vector<int> &set = sets[j+1];
 
       if (j < 0 && (outrest[1] & OUT_MODE_MESH)) /* output unselected triangles */
       {
-        for (i = 0; i < trinum; i ++)
+        for (int i = 0; i < trinum; i ++)
         {
-          if (triobs[i] >= 0 && (flags[triobs[i]] & OUTREST)) /* triangles of unselected particles */
+          if (triobs[i] >= 0 && output_selected (-1, triobs[i])) /* triangles of unselected particles */
           {
-            set[num ++] = i;
+            set.push_back (i);
           }
           else if (triobs[i] < 0) /* triangles of obstacles */
           {
-            set[num ++] = i;
+            set.push_back (i);
           }
         }
-
-        ent = outrest[0];
       }
       else if (outmode[j] & OUT_MODE_MESH) /* output selected triangles */
       {
-        num = find_triangle_set (&outpart[outidx[j]], &outpart[outidx[j+1]], set);
+        int *pset, pnum = output_particle_set (j, &pset);
 
-        ent = outent[j];
+        set.resize (trinum);
+
+        set.resize (find_triangle_set (pset, pset+pnum, set.data()));
       }
+    }
+
+    for (j = -1; j < outnum; j ++) /* HDF5 writes are serial */
+    {
+      int num = sets[j+1].size(), *set = sets[j+1].data(), ent = j < 0 ? outrest[0] : outent[j];
 
       if (num)
-      { 
+      {
         h5_path.str("");
         h5_path.clear();
         h5_path << output_path << j+1 << ".h5";
 
-        if (curtime == 0.0)
-        {
-          ASSERT ((h5_file = H5Fcreate(h5_path.str().c_str(), H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT)) >= 0, "HDF5 file open error");
-        }
-        else
-        {
-          ASSERT((h5_file = H5Fopen(h5_path.str().c_str(), H5F_ACC_RDWR, H5P_DEFAULT)) >= 0, "HDF5 file open error");
-        }
-
-        h5_text.str("");
-        h5_text.clear();
-        h5_text << output_frame;
-        ASSERT ((h5_step = H5Gcreate (h5_file, h5_text.str().c_str(), H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT)) >= 0, "HDF5 file write error");
+        h5_file = h5_open_frame (h5_path.str().c_str(), &h5_step, &h5_frame);
         double time = curtime;
         ASSERT (H5LTset_attribute_double (h5_step, ".", "TIME", &time, 1) >= 0, "HDF5 file write error"); 
 
@@ -4039,45 +4305,46 @@ static void output_xdmf_files ()
         const char *label = "PARMEC triangles";
         string h5file = h5_path.str().substr(h5_path.str().find_last_of('/')+1);
 
-        append_xmf_file (xmf_path.str().c_str(), OUT_MODE_MESH, elements, nodes, topo_size, label, h5file.c_str(), ent);
+        append_xmf_file (xmf_path.str().c_str(), OUT_MODE_MESH, elements, nodes, topo_size, label, h5file.c_str(), ent, h5_frame);
 
         H5Gclose (h5_step);
         H5Fclose (h5_file);
       }
     }
-
-    delete [] set;
   }
 
   if (parnum)
   {
-    int i, j, num, ent, *set, *pset; /* number of and the set of unselected particles */
-
-    ERRMEM (set = new int[parnum]);
+    vector<vector<int> > sets (outnum+1); /* sets[j+1]: selection of output set j */
 
-    for (j = -1; j < outnum; j ++)
+#pragma omp parallel for schedule(dynamic)
+    for (int j = -1; j < outnum; j ++) /* output sets are selected in parallel */
     {
-      num = 0;
+      if (!output_active (j)) continue; /* decimated frame */
+
+      vector<int> &set = sets[j+1];
 
       if (j < 0 && (outrest[1] & OUT_MODE_RB)) /* output unselected particles */
       {
-        for (i = 0; i < parnum; i ++)
+        for (int i = 0; i < parnum; i ++)
         {
-          if (flags[i] & OUTREST)
+          if (output_selected (-1, i))
           {
-            set[num ++] = i;
+            set.push_back (i);
           }
         }
-
-        pset = set;
-        ent = outrest[0];
       }
       else if (outmode[j] & OUT_MODE_RB) /* output selected particles */
       {
-        num = outidx[j+1]-outidx[j];
-        pset = &outpart[outidx[j]];
-        ent = outent[j];
+        int *pset, pnum = output_particle_set (j, &pset);
+
+        set.assign (pset, pset+pnum);
       }
+    }
+
+    for (j = -1; j < outnum; j ++) /* HDF5 writes are serial */
+    {
+      int num = sets[j+1].size(), *set = sets[j+1].data(), ent = j < 0 ? outrest[0] : outent[j];
 
       if (num)
       {
@@ -4085,23 +4352,11 @@ static void output_xdmf_files ()
         h5_path.clear();
         h5_path << output_path << j+1 << "rb.h5";
 
-        if (curtime == 0.0)
-        {
-          ASSERT ((h5_file = H5Fcreate(h5_path.str().c_str(), H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT)) >= 0, "HDF5 file open error");
-        }
-        else
-        {
-          ASSERT((h5_file = H5Fopen(h5_path.str().c_str(), H5F_ACC_RDWR, H5P_DEFAULT)) >= 0, "HDF5 file open error");
-        }
-
-        h5_text.str("");
-        h5_text.clear();
-        h5_text << output_frame;
-        ASSERT ((h5_step = H5Gcreate (h5_file, h5_text.str().c_str(), H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT)) >= 0, "HDF5 file write error");
+        h5_file = h5_open_frame (h5_path.str().c_str(), &h5_step, &h5_frame);
         double time = curtime;
         ASSERT (H5LTset_attribute_double (h5_step, ".", "TIME", &time, 1) >= 0, "HDF5 file write error"); 
 
-        h5_rb_dataset (num, pset, ent, h5_step); /* append h5 file */
+        h5_rb_dataset (num, set, ent, h5_step); /* append h5 file */
 
         xmf_path.str("");
         xmf_path.clear();
@@ -4113,27 +4368,23 @@ static void output_xdmf_files ()
         const char *label = "PARMEC rigid bodies";
         string h5file = h5_path.str().substr(h5_path.str().find_last_of('/')+1);
 
-        append_xmf_file (xmf_path.str().c_str(), OUT_MODE_RB, elements, nodes, topo_size, label, h5file.c_str(), ent);
+        append_xmf_file (xmf_path.str().c_str(), OUT_MODE_RB, elements, nodes, topo_size, label, h5file.c_str(), ent, h5_frame);
 
         H5Gclose (h5_step);
         H5Fclose (h5_file);
       }
     }
-
-    delete [] set;
   }
 
   /* TODO --> *cd.h5 amd *cd.xmf contact data output */
 
   if (sprnum)
   {
-    int i, j, ent, num, *set; /* number of and the set of springs */
-    MAP **map, *item; /* map of springs attached to particles, and iterator */
+    MAP **map; /* map of springs attached to particles */
     MEM mem;
 
     MEM_Init (&mem, sizeof (MAP), 1024);
     ERRMEM (map = static_cast<MAP**>(MEM_CALLOC(parnum * sizeof(MAP*))));
-    ERRMEM (set = new int[sprnum]);
 
     for (i = 0; i < sprnum; i ++)
     {
@@ -4141,55 +4392,51 @@ static void output_xdmf_files ()
       if (sprpart[1][i] >= 0) MAP_Insert (&mem, &map[sprpart[1][i]], (void*)(long)i, NULL, NULL);
     }
 
-    for (j = -1; j < outnum; j ++)
+    vector<vector<int> > sets (outnum+1); /* sets[j+1]: selection of output set j */
+
+#pragma omp parallel for schedule(dynamic)
+    for (int j = -1; j < outnum; j ++) /* output sets are selected in parallel */
     {
-      num = 0;
+      if (!output_active (j)) continue; /* decimated frame */
+
+      vector<int> &set = sets[j+1];
 
       if (j < 0 && (outrest[1] & OUT_MODE_SL)) /* output springs attached to unselected particles */
       {
-        for (i = 0; i < sprnum; i ++)
+        for (int i = 0; i < sprnum; i ++)
         {
-          if (flags[sprpart[0][i]] && OUTREST || /* first or second particle is unselected */
-              (sprpart[1][i] >= 0 && (flags[sprpart[1][i]] & OUTREST)))
+          if (output_selected (-1, sprpart[0][i]) || /* first or second particle is unselected */
+              (sprpart[1][i] >= 0 && output_selected (-1, sprpart[1][i])))
           {
-            set[num ++] = i;
+            set.push_back (i);
           }
         }
-
-        ent = outrest[0];
       }
       else if (outmode[j] & OUT_MODE_SL) /* output springs attached to selected particles */
       {
-        for (num = 0, i = outidx[j]; i < outidx[j+1]; i ++)
+        for (int i = outidx[j]; i < outidx[j+1]; i ++)
         {
-          for (item = MAP_First (map[outpart[i]]); item; item = MAP_Next(item))
+          if (!output_selected (j, outpart[i])) continue;
+
+          for (MAP *item = MAP_First (map[outpart[i]]); item; item = MAP_Next(item))
           {
-            set[num ++] = (int)(long)item->key;
+            set.push_back ((int)(long)item->key);
           }
         }
-
-        ent = outent[j];
       }
+    }
 
-      if (num) 
+    for (j = -1; j < outnum; j ++) /* HDF5 writes are serial */
+    {
+      int num = sets[j+1].size(), *set = sets[j+1].data(), ent = j < 0 ? outrest[0] : outent[j];
+
+      if (num)
       {
         h5_path.str("");
         h5_path.clear();
         h5_path << output_path << j+1 << "sl.h5";
 
-        if (curtime == 0.0)
-        {
-          ASSERT ((h5_file = H5Fcreate(h5_path.str().c_str(), H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT)) >= 0, "HDF5 file open error");
-        }
-        else
-        {
-          ASSERT((h5_file = H5Fopen(h5_path.str().c_str(), H5F_ACC_RDWR, H5P_DEFAULT)) >= 0, "HDF5 file open error");
-        }
-
-        h5_text.str("");
-        h5_text.clear();
-        h5_text << output_frame;
-        ASSERT ((h5_step = H5Gcreate (h5_file, h5_text.str().c_str(), H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT)) >= 0, "HDF5 file write error");
+        h5_file = h5_open_frame (h5_path.str().c_str(), &h5_step, &h5_frame);
         double time = curtime;
         ASSERT (H5LTset_attribute_double (h5_step, ".", "TIME", &time, 1) >= 0, "HDF5 file write error"); 
 
@@ -4205,27 +4452,24 @@ static void output_xdmf_files ()
         const char *label = "PARMEC linear springs";
         string h5file = h5_path.str().substr(h5_path.str().find_last_of('/')+1);
 
-        append_xmf_file (xmf_path.str().c_str(), OUT_MODE_SL, elements, nodes, topo_size, label, h5file.c_str(), ent);
+        append_xmf_file (xmf_path.str().c_str(), OUT_MODE_SL, elements, nodes, topo_size, label, h5file.c_str(), ent, h5_frame);
 
         H5Gclose (h5_step);
         H5Fclose (h5_file);
       }
     }
 
-    delete [] set;
     free (map);
     MEM_Release (&mem);
   }
 
   if (trqsprnum)
   {
-    int i, j, ent, num, *set; /* number of and the set of springs */
-    MAP **map, *item; /* map of springs attached to particles, and iterator */
+    MAP **map; /* map of springs attached to particles */
     MEM mem;
 
     MEM_Init (&mem, sizeof (MAP), 1024);
     ERRMEM (map = static_cast<MAP**>(MEM_CALLOC(parnum * sizeof(MAP*))));
-    ERRMEM (set = new int[trqsprnum]);
 
     for (i = 0; i < trqsprnum; i ++)
     {
@@ -4233,55 +4477,51 @@ static void output_xdmf_files ()
       if (trqsprpart[1][i] >= 0) MAP_Insert (&mem, &map[trqsprpart[1][i]], (void*)(long)i, NULL, NULL);
     }
 
-    for (j = -1; j < outnum; j ++)
+    vector<vector<int> > sets (outnum+1); /* sets[j+1]: selection of output set j */
+
+#pragma omp parallel for schedule(dynamic)
+    for (int j = -1; j < outnum; j ++) /* output sets are selected in parallel */
     {
-      num = 0;
+      if (!output_active (j)) continue; /* decimated frame */
+
+      vector<int> &set = sets[j+1];
 
       if (j < 0 && (outrest[1] & OUT_MODE_ST)) /* output springs attached to unselected particles */
       {
-        for (i = 0; i < trqsprnum; i ++)
+        for (int i = 0; i < trqsprnum; i ++)
         {
-          if (flags[trqsprpart[0][i]] && OUTREST || /* first or second particle is unselected */
-              (trqsprpart[1][i] >= 0 && (flags[trqsprpart[1][i]] & OUTREST)))
+          if (output_selected (-1, trqsprpart[0][i]) || /* first or second particle is unselected */
+              (trqsprpart[1][i] >= 0 && output_selected (-1, trqsprpart[1][i])))
           {
-            set[num ++] = i;
+            set.push_back (i);
           }
         }
-
-        ent = outrest[0];
       }
       else if (outmode[j] & OUT_MODE_ST) /* output springs attached to selected particles */
       {
-        for (num = 0, i = outidx[j]; i < outidx[j+1]; i ++)
+        for (int i = outidx[j]; i < outidx[j+1]; i ++)
         {
-          for (item = MAP_First (map[outpart[i]]); item; item = MAP_Next(item))
+          if (!output_selected (j, outpart[i])) continue;
+
+          for (MAP *item = MAP_First (map[outpart[i]]); item; item = MAP_Next(item))
           {
-            set[num ++] = (int)(long)item->key;
+            set.push_back ((int)(long)item->key);
           }
         }
-
-        ent = outent[j];
       }
+    }
 
-      if (num) 
+    for (j = -1; j < outnum; j ++) /* HDF5 writes are serial */
+    {
+      int num = sets[j+1].size(), *set = sets[j+1].data(), ent = j < 0 ? outrest[0] : outent[j];
+
+      if (num)
       {
         h5_path.str("");
         h5_path.clear();
         h5_path << output_path << j+1 << "st.h5";
 
-        if (curtime == 0.0)
-        {
-          ASSERT ((h5_file = H5Fcreate(h5_path.str().c_str(), H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT)) >= 0, "HDF5 file open error");
-        }
-        else
-        {
-          ASSERT((h5_file = H5Fopen(h5_path.str().c_str(), H5F_ACC_RDWR, H5P_DEFAULT)) >= 0, "HDF5 file open error");
-        }
-
-        h5_text.str("");
-        h5_text.clear();
-        h5_text << output_frame;
-        ASSERT ((h5_step = H5Gcreate (h5_file, h5_text.str().c_str(), H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT)) >= 0, "HDF5 file write error");
+        h5_file = h5_open_frame (h5_path.str().c_str(), &h5_step, &h5_frame);
         double time = curtime;
         ASSERT (H5LTset_attribute_double (h5_step, ".", "TIME", &time, 1) >= 0, "HDF5 file write error"); 
 
@@ -4297,83 +4537,76 @@ static void output_xdmf_files ()
         const char *label = "PARMEC torsional springs";
         string h5file = h5_path.str().substr(h5_path.str().find_last_of('/')+1);
 
-        append_xmf_file (xmf_path.str().c_str(), OUT_MODE_ST, elements, nodes, topo_size, label, h5file.c_str(), ent);
+        append_xmf_file (xmf_path.str().c_str(), OUT_MODE_ST, elements, nodes, topo_size, label, h5file.c_str(), ent, h5_frame);
 
         H5Gclose (h5_step);
         H5Fclose (h5_file);
       }
     }
 
-    delete [] set;
     free (map);
     MEM_Release (&mem);
   }
 
   if (jnum)
   {
-    int i, j, ent, num, *set; /* number of and the set of joints */
-    MAP **map, *item; /* map of joints attached to particles, and iterator */
+    MAP **map; /* map of joints attached to particles */
     MEM mem;
 
     MEM_Init (&mem, sizeof (MAP), 1024);
     ERRMEM (map = static_cast<MAP**>(MEM_CALLOC(parnum * sizeof(MAP*))));
-    ERRMEM (set = new int[jnum]);
 
     for (i = 0; i < jnum; i ++)
     {
-      MAP_Insert (&mem, &map[jpart[0][i]], (void*)(long)i, NULL, NULL); /* map springs to particles */
+      MAP_Insert (&mem, &map[jpart[0][i]], (void*)(long)i, NULL, NULL); /* map joints to particles */
       if (jpart[1][i] >= 0) MAP_Insert (&mem, &map[jpart[1][i]], (void*)(long)i, NULL, NULL);
     }
 
-    for (j = -1; j < outnum; j ++)
+    vector<vector<int> > sets (outnum+1); /* sets[j+1]: selection of output set j */
+
+#pragma omp parallel for schedule(dynamic)
+    for (int j = -1; j < outnum; j ++) /* output sets are selected in parallel */
     {
-      num = 0;
+      if (!output_active (j)) continue; /* decimated frame */
 
-      if (j < 0 && (outrest[1] & OUT_MODE_JT)) /* output springs attached to unselected particles */
+      vector<int> &set = sets[j+1];
+
+      if (j < 0 && (outrest[1] & OUT_MODE_JT)) /* output joints attached to unselected particles */
       {
-        for (i = 0; i < jnum; i ++)
+        for (int i = 0; i < jnum; i ++)
         {
-          if (flags[jpart[0][i]] && OUTREST || /* first or second particle is unselected */
-              (jpart[1][i] >= 0 && (flags[jpart[1][i]] & OUTREST)))
+          if (output_selected (-1, jpart[0][i]) || /* first or second particle is unselected */
+              (jpart[1][i] >= 0 && output_selected (-1, jpart[1][i])))
           {
-            set[num ++] = i;
+            set.push_back (i);
           }
         }
-
-        ent = outrest[0];
       }
-      else if (outmode[j] & OUT_MODE_JT) /* output springs attached to selected particles */
+      else if (outmode[j] & OUT_MODE_JT) /* output joints attached to selected particles */
       {
-        for (num = 0, i = outidx[j]; i < outidx[j+1]; i ++)
+        for (int i = outidx[j]; i < outidx[j+1]; i ++)
         {
-          for (item = MAP_First (map[outpart[i]]); item; item = MAP_Next(item))
+          if (!output_selected (j, outpart[i])) continue;
+
+          for (MAP *item = MAP_First (map[outpart[i]]); item; item = MAP_Next(item))
           {
-            set[num ++] = (int)(long)item->key;
+            set.push_back ((int)(long)item->key);
           }
         }
-
-        ent = outent[j];
       }
+    }
 
-      if (num) 
+    for (j = -1; j < outnum; j ++) /* HDF5 writes are serial */
+    {
+      int num = sets[j+1].size(), *set = sets[j+1].data(), ent = j < 0 ? outrest[0] : outent[j];
+
+      if (num)
       {
         h5_path.str("");
         h5_path.clear();
         h5_path << output_path << j+1 << "jt.h5";
 
-        if (curtime == 0.0)
-        {
-          ASSERT ((h5_file = H5Fcreate(h5_path.str().c_str(), H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT)) >= 0, "HDF5 file open error");
-        }
-        else
-        {
-          ASSERT((h5_file = H5Fopen(h5_path.str().c_str(), H5F_ACC_RDWR, H5P_DEFAULT)) >= 0, "HDF5 file open error");
-        }
-
-        h5_text.str("");
-        h5_text.clear();
-        h5_text << output_frame;
-        ASSERT ((h5_step = H5Gcreate (h5_file, h5_text.str().c_str(), H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT)) >= 0, "HDF5 file write error");
+        h5_file = h5_open_frame (h5_path.str().c_str(), &h5_step, &h5_frame);
         double time = curtime;
         ASSERT (H5LTset_attribute_double (h5_step, ".", "TIME", &time, 1) >= 0, "HDF5 file write error"); 
 
@@ -4389,14 +4622,13 @@ static void output_xdmf_files ()
         const char *label = "PARMEC joints";
         string h5file = h5_path.str().substr(h5_path.str().find_last_of('/')+1);
 
-        append_xmf_file (xmf_path.str().c_str(), OUT_MODE_JT, elements, nodes, topo_size, label, h5file.c_str(), ent);
+        append_xmf_file (xmf_path.str().c_str(), OUT_MODE_JT, elements, nodes, topo_size, label, h5file.c_str(), ent, h5_frame);
 
         H5Gclose (h5_step);
         H5Fclose (h5_file);
       }
     }
 
-    delete [] set;
     free (map);
     MEM_Release (&mem);
   }
@@ -4405,18 +4637,20 @@ static void output_xdmf_files ()
 /* output VTK files */
 static void output_vtk_files ()
 {
-  ostringstream oss;
-  ofstream out;
-  int i, j;
+  int i;
 
   if (trinum)
   {
-    int num, *set; /* number of and the set of triangles */
+#pragma omp parallel for schedule(dynamic)
+    for (int j = -1; j < outnum; j ++) /* per set files are written in parallel */
+    {
+      if (!output_active (j)) continue; /* decimated frame */
 
-    ERRMEM (set = new int[trinum]);
+      vector<int> set (trinum);
+      ostringstream oss;
+      ofstream out;
+      int i, num;
 
-    for (j = -1; j < outnum; j ++)
-    {
       if (j < 0 && (outrest[1] & OUT_MODE_MESH)) /* output unselected triangles */
       {
         oss.str("");
@@ -4430,7 +4664,7 @@ static void output_vtk_files ()
 
         for (num = i = 0; i < trinum; i ++)
         {
-          if (triobs[i] >= 0 && (flags[triobs[i]] & OUTREST)) /* triangles of unselected particles */
+          if (triobs[i] >= 0 && output_selected (-1, triobs[i])) /* triangles of unselected particles */
           {
             set[num ++] = i;
           }
@@ -4440,7 +4674,7 @@ static void output_vtk_files ()
           }
         }
 
-        vtk_triangle_dataset (num, set, outrest[0], out);
+        vtk_triangle_dataset (num, set.data(), outrest[0], out);
 
         out.close();
       }
@@ -4455,25 +4689,29 @@ static void output_vtk_files ()
         out << "PARMEC triangles output at time " << curtime << "\n";
         out << "ASCII\n";
 
-        num = find_triangle_set (&outpart[outidx[j]], &outpart[outidx[j+1]], set);
+        int *pset, pnum = output_particle_set (j, &pset);
+
+        num = find_triangle_set (pset, pset+pnum, set.data());
 
-        if (num) vtk_triangle_dataset (num, set, outent[j], out);
+        if (num) vtk_triangle_dataset (num, set.data(), outent[j], out);
 
         out.close();
       }
     }
-
-    delete [] set;
   }
 
   if (parnum)
   {
-    int num, *set; /* number of and the set of unselected particles */
+#pragma omp parallel for schedule(dynamic)
+    for (int j = -1; j < outnum; j ++)
+    {
+      if (!output_active (j)) continue; /* decimated frame */
 
-    ERRMEM (set = new int[parnum]);
+      vector<int> set (parnum);
+      ostringstream oss;
+      ofstream out;
+      int i, num;
 
-    for (j = -1; j < outnum; j ++)
-    {
       if (j < 0 && (outrest[1] & OUT_MODE_RB)) /* output unselected particles */
       {
         oss.str("");
@@ -4487,13 +4725,13 @@ static void output_vtk_files ()
 
         for (num = i = 0; i < parnum; i ++)
         {
-          if (flags[i] & OUTREST)
+          if (output_selected (-1, i))
           {
             set[num ++] = i;
           }
         }
 
-        output_rb_dataset (num, set, outrest[0], out);
+        output_rb_dataset (num, set.data(), outrest[0], out);
 
         out.close();
       }
@@ -4508,35 +4746,42 @@ static void output_vtk_files ()
         out << "PARMEC rigid bodies output at time " << curtime << "\n";
         out << "ASCII\n";
 
-        output_rb_dataset (outidx[j+1]-outidx[j], &outpart[outidx[j]], outent[j], out);
+        int *pset, pnum = output_particle_set (j, &pset);
+
+        output_rb_dataset (pnum, pset, outent[j], out);
 
         out.close();
       }
     }
-
-    delete [] set;
   }
 
   /* TODO --> *cd.vtk.* contact data output */
 
   if (sprnum)
   {
-    int num, *set; /* number of and the set of springs */
-    MAP **map, *item; /* map of springs attached to particles, and iterator */
+    MAP **map; /* map of springs attached to particles */
     MEM mem;
 
     MEM_Init (&mem, sizeof (MAP), 1024);
     ERRMEM (map = static_cast<MAP**>(MEM_CALLOC(parnum * sizeof(MAP*))));
-    ERRMEM (set = new int[sprnum]);
 
-    for (num = i = 0; i < sprnum; i ++)
+    for (i = 0; i < sprnum; i ++)
     {
       MAP_Insert (&mem, &map[sprpart[0][i]], (void*)(long)i, NULL, NULL); /* map springs to particles */
       if (sprpart[1][i] >= 0) MAP_Insert (&mem, &map[sprpart[1][i]], (void*)(long)i, NULL, NULL);
     }
 
-    for (j = -1; j < outnum; j ++)
+#pragma omp parallel for schedule(dynamic)
+    for (int j = -1; j < outnum; j ++)
     {
+      if (!output_active (j)) continue; /* decimated frame */
+
+      vector<int> set (sprnum);
+      ostringstream oss;
+      ofstream out;
+      MAP *item;
+      int i, num;
+
       if (j < 0 && (outrest[1] & OUT_MODE_SL)) /* output springs attached to unselected particles */
       {
         oss.str("");
@@ -4550,14 +4795,14 @@ static void output_vtk_files ()
 
         for (num = i = 0; i < sprnum; i ++)
         {
-          if (flags[sprpart[0][i]] && OUTREST || /* first or second particle is unselected */
-              (sprpart[1][i] >= 0 && (flags[sprpart[1][i]] & OUTREST)))
+          if (output_selected (-1, sprpart[0][i]) || /* first or second particle is unselected */
+              (sprpart[1][i] >= 0 && output_selected (-1, sprpart[1][i])))
           {
             set[num ++] = i;
           }
         }
 
-        vtk_linear_spring_dataset (num, set, outrest[0], out);
+        vtk_linear_spring_dataset (num, set.data(), outrest[0], out);
 
         out.close();
       }
@@ -4574,41 +4819,49 @@ static void output_vtk_files ()
 
         for (num = 0, i = outidx[j]; i < outidx[j+1]; i ++)
         {
+          if (!output_selected (j, outpart[i])) continue;
+
           for (item = MAP_First (map[outpart[i]]); item; item = MAP_Next(item))
           {
             set[num ++] = (int)(long)item->key;
           }
         }
 
-        if (num) vtk_linear_spring_dataset (num, set, outent[j], out);
+        if (num) vtk_linear_spring_dataset (num, set.data(), outent[j], out);
 
         out.close();
       }
     }
 
-    delete [] set;
     free (map);
     MEM_Release (&mem);
   }
 
   if (trqsprnum)
   {
-    int num, *set; /* number of and the set of springs */
-    MAP **map, *item; /* map of springs attached to particles, and iterator */
+    MAP **map; /* map of springs attached to particles */
     MEM mem;
 
     MEM_Init (&mem, sizeof (MAP), 1024);
     ERRMEM (map = static_cast<MAP**>(MEM_CALLOC(parnum * sizeof(MAP*))));
-    ERRMEM (set = new int[trqsprnum]);
 
-    for (num = i = 0; i < trqsprnum; i ++)
+    for (i = 0; i < trqsprnum; i ++)
     {
       MAP_Insert (&mem, &map[trqsprpart[0][i]], (void*)(long)i, NULL, NULL); /* map springs to particles */
       if (trqsprpart[1][i] >= 0) MAP_Insert (&mem, &map[trqsprpart[1][i]], (void*)(long)i, NULL, NULL);
     }
 
-    for (j = -1; j < outnum; j ++)
+#pragma omp parallel for schedule(dynamic)
+    for (int j = -1; j < outnum; j ++)
     {
+      if (!output_active (j)) continue; /* decimated frame */
+
+      vector<int> set (trqsprnum);
+      ostringstream oss;
+      ofstream out;
+      MAP *item;
+      int i, num;
+
       if (j < 0 && (outrest[1] & OUT_MODE_ST)) /* output springs attached to unselected particles */
       {
         oss.str("");
@@ -4622,14 +4875,14 @@ static void output_vtk_files ()
 
         for (num = i = 0; i < trqsprnum; i ++)
         {
-          if (flags[trqsprpart[0][i]] && OUTREST || /* first or second particle is unselected */
-              (trqsprpart[1][i] >= 0 && (flags[trqsprpart[1][i]] & OUTREST)))
+          if (output_selected (-1, trqsprpart[0][i]) || /* first or second particle is unselected */
+              (trqsprpart[1][i] >= 0 && output_selected (-1, trqsprpart[1][i])))
           {
             set[num ++] = i;
           }
         }
 
-        vtk_torsional_spring_dataset (num, set, outrest[0], out);
+        vtk_torsional_spring_dataset (num, set.data(), outrest[0], out);
 
         out.close();
       }
@@ -4646,41 +4899,49 @@ static void output_vtk_files ()
 
         for (num = 0, i = outidx[j]; i < outidx[j+1]; i ++)
         {
+          if (!output_selected (j, outpart[i])) continue;
+
           for (item = MAP_First (map[outpart[i]]); item; item = MAP_Next(item))
           {
             set[num ++] = (int)(long)item->key;
           }
         }
 
-        if (num) vtk_torsional_spring_dataset (num, set, outent[j], out);
+        if (num) vtk_torsional_spring_dataset (num, set.data(), outent[j], out);
 
         out.close();
       }
     }
 
-    delete [] set;
     free (map);
     MEM_Release (&mem);
   }
 
   if (jnum)
   {
-    int num, *set; /* number of and the set of joints */
-    MAP **map, *item; /* map of joints attached to particles, and iterator */
+    MAP **map; /* map of joints attached to particles */
     MEM mem;
 
     MEM_Init (&mem, sizeof (MAP), 1024);
     ERRMEM (map = static_cast<MAP**>(MEM_CALLOC(parnum * sizeof(MAP*))));
-    ERRMEM (set = new int[jnum]);
 
-    for (num = i = 0; i < jnum; i ++)
+    for (i = 0; i < jnum; i ++)
     {
       MAP_Insert (&mem, &map[jpart[0][i]], (void*)(long)i, NULL, NULL); /* map springs to particles */
       if (jpart[1][i] >= 0) MAP_Insert (&mem, &map[jpart[1][i]], (void*)(long)i, NULL, NULL);
     }
 
-    for (j = -1; j < outnum; j ++)
+#pragma omp parallel for schedule(dynamic)
+    for (int j = -1; j < outnum; j ++)
     {
+      if (!output_active (j)) continue; /* decimated frame */
+
+      vector<int> set (jnum);
+      ostringstream oss;
+      ofstream out;
+      MAP *item;
+      int i, num;
+
       if (j < 0 && (outrest[1] & OUT_MODE_JT)) /* output springs attached to unselected particles */
       {
         oss.str("");
@@ -4694,14 +4955,14 @@ static void output_vtk_files ()
 
         for (num = i = 0; i < jnum; i ++)
         {
-          if (flags[jpart[0][i]] && OUTREST || /* first or second particle is unselected */
-              (jpart[1][i] >= 0 && (flags[jpart[1][i]] & OUTREST)))
+          if (output_selected (-1, jpart[0][i]) || /* first or second particle is unselected */
+              (jpart[1][i] >= 0 && output_selected (-1, jpart[1][i])))
           {
             set[num ++] = i;
           }
         }
 
-        vtk_joints_dataset (num, set, outrest[0], out);
+        vtk_joints_dataset (num, set.data(), outrest[0], out);
 
         out.close();
       }
@@ -4718,19 +4979,20 @@ static void output_vtk_files ()
 
         for (num = 0, i = outidx[j]; i < outidx[j+1]; i ++)
         {
+          if (!output_selected (j, outpart[i])) continue;
+
           for (item = MAP_First (map[outpart[i]]); item; item = MAP_Next(item))
           {
             set[num ++] = (int)(long)item->key;
           }
         }
 
-        if (num) vtk_joints_dataset (num, set, outent[j], out);
+        if (num) vtk_joints_dataset (num, set.data(), outent[j], out);
 
         out.close();
       }
     }
 
-    delete [] set;
     free (map);
     MEM_Release (&mem);
   }
@@ -5082,17 +5344,19 @@ static void output_dump_files ()
 
     for (j = -1; j < outnum; j ++)
     {
+      if (!output_active (j)) continue; /* decimated frame */
+
       if (j < 0 && (outrest[1] & OUT_MODE_SPH)) /* output unselected particles */
       {
         oss.str("");
         oss.clear();
         oss << output_path << j+1 << ".dump";
-        if (output_frame) out.open (oss.str().c_str(), ios::app);
+        if (output_created (oss.str().c_str())) out.open (oss.str().c_str(), ios::app);
         else out.open (oss.str().c_str());
 
         for (num = i = 0; i < ellnum; i ++)
         {
-          if (flags[part[i]] & OUTREST)
+          if (output_selected (-1, part[i]))
           {
             set[num ++] = i;
           }
@@ -5107,10 +5371,12 @@ static void output_dump_files ()
         oss.str("");
         oss.clear();
         oss << output_path << j+1 << ".dump";
-        if (output_frame) out.open (oss.str().c_str(), ios::app);
+        if (output_created (oss.str().c_str())) out.open (oss.str().c_str(), ios::app);
         else out.open (oss.str().c_str());
 
-        num = find_ellipsoid_set (&outpart[outidx[j]], &outpart[outidx[j+1]], set);
+        int *pset, pnum = output_particle_set (j, &pset);
+
+        num = find_ellipsoid_set (pset, pset+pnum, set);
 
         output_dump_dataset (num, set, outent[j], out);
 
@@ -5123,9 +5389,250 @@ static void output_dump_files ()
   }
 }
 
+static string stream_path; /* streaming output path: a Unix domain socket or a named pipe */
+static int stream_fd = -1; /* streaming output descriptor */
+static int stream_failed = 0; /* streaming has been disabled after a failure */
+
+/* open streaming output; return 0 if the consumer is not available */
+static int stream_open ()
+{
+  struct stat st;
+  string path = stream_path.empty() ? string(output_path) + ".stream" : stream_path;
+
+  if (stat (path.c_str(), &st) != 0)
+  {
+    fprintf (stderr, "WARNING: stream output path %s does not exist; streaming disabled\n", path.c_str());
+    return 0;
+  }
+
+  signal (SIGPIPE, SIG_IGN); /* a vanished consumer is reported via EPIPE */
+
+  if (S_ISSOCK (st.st_mode))
+  {
+    struct sockaddr_un addr;
+
+    if (path.size() >= sizeof(addr.sun_path))
+    {
+      fprintf (stderr, "WARNING: stream socket path %s is too long; streaming disabled\n", path.c_str());
+      return 0;
+    }
+
+    memset (&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy (addr.sun_path, path.c_str());
+
+    if ((stream_fd = socket (AF_UNIX, SOCK_STREAM, 0)) < 0 ||
+        connect (stream_fd, (struct sockaddr*)&addr, sizeof(addr)) != 0)
+    {
+      fprintf (stderr, "WARNING: could not connect to stream socket %s (%s); streaming disabled\n", path.c_str(), strerror(errno));
+      if (stream_fd >= 0) close (stream_fd);
+      stream_fd = -1;
+      return 0;
+    }
+  }
+  else if (S_ISFIFO (st.st_mode))
+  {
+    if ((stream_fd = open (path.c_str(), O_WRONLY|O_NONBLOCK)) < 0) /* fails at once if nobody reads */
+    {
+      fprintf (stderr, "WARNING: could not open stream pipe %s (%s); streaming disabled\n", path.c_str(), strerror(errno));
+      return 0;
+    }
+
+    fcntl (stream_fd, F_SETFL, fcntl (stream_fd, F_GETFL) & ~O_NONBLOCK); /* whole frames are written */
+  }
+  else
+  {
+    fprintf (stderr, "WARNING: stream output path %s is neither a socket nor a named pipe; streaming disabled\n", path.c_str());
+    return 0;
+  }
+
+  return 1;
+}
+
+/* close streaming output */
+static void stream_close ()
+{
+  if (stream_fd >= 0) close (stream_fd);
+  stream_fd = -1;
+}
+
+/* append a named field of count x width values to a stream frame */
+static void stream_field (vector<char> &frame, const char *name, int count, int width, const double *data)
+{
+  char label[16];
+  int size[2] = {count, width};
+
+  memset (label, 0, 16);
+  strncpy (label, name, 15);
+  frame.insert (frame.end(), label, label+16);
+  frame.insert (frame.end(), (char*)size, (char*)(size+2));
+  frame.insert (frame.end(), (char*)data, (char*)(data+count*width));
+}
+
+/* stream one frame of particle data and the latest history samples */
+static void output_stream ()
+{
+  if (stream_failed) return;
+
+  if (stream_fd < 0 && !stream_open())
+  {
+    stream_failed = 1;
+    return;
+  }
+
+  vector<int> pset;
+  vector<char> mark (parnum, 0);
+  int i, j, k, ent = 0, nfields = 0;
+
+  for (j = -1; j < outnum; j ++) /* union of output sets and their entities */
+  {
+    if (!output_active (j)) continue; /* decimated frame */
+
+    if (j < 0)
+    {
+      for (k = 0; k < parnum; k ++)
+      {
+        if (output_selected (-1, k) && !mark[k]) { mark[k] = 1; pset.push_back (k); }
+      }
+
+      ent |= outrest[0];
+    }
+    else
+    {
+      int *part, num = output_particle_set (j, &part);
+
+      for (i = 0; i < num; i ++)
+      {
+        if (!mark[part[i]]) { mark[part[i]] = 1; pset.push_back (part[i]); }
+      }
+
+      ent |= outent[j];
+    }
+  }
+
+  sort (pset.begin(), pset.end());
+
+  int num = pset.size();
+  vector<double> data (9*(num > hisnum ? num : hisnum));
+  vector<char> frame;
+  double *pdata;
+
+  frame.resize (24); /* header is filled in at the end */
+
+  for (i = 0; i < num; i ++) data[i] = pset[i];
+  stream_field (frame, "NUMBER", num, 1, data.data()); nfields ++;
+
+  for (i = 0, pdata = data.data(); i < num; i ++, pdata += 3)
+  {
+    k = pset[i];
+    pdata[0] = position[0][k]; pdata[1] = position[1][k]; pdata[2] = position[2][k];
+  }
+  stream_field (frame, "GEOM", num, 3, data.data()); nfields ++;
+
+  if (ent & OUT_DISPL)
+  {
+    for (i = 0, pdata = data.data(); i < num; i ++, pdata += 3)
+    {
+      k = pset[i];
+      pdata[0] = position[0][k]-position[3][k]; pdata[1] = position[1][k]-position[4][k]; pdata[2] = position[2][k]-position[5][k];
+    }
+    stream_field (frame, "DISPL", num, 3, data.data()); nfields ++;
+  }
+
+  if (ent & OUT_LINVEL)
+  {
+    for (i = 0, pdata = data.data(); i < num; i ++, pdata += 3)
+    {
+      k = pset[i];
+      pdata[0] = linear[0][k]; pdata[1] = linear[1][k]; pdata[2] = linear[2][k];
+    }
+    stream_field (frame, "LINVEL", num, 3, data.data()); nfields ++;
+  }
+
+  if (ent & OUT_ANGVEL)
+  {
+    for (i = 0, pdata = data.data(); i < num; i ++, pdata += 3)
+    {
+      k = pset[i];
+      pdata[0] = angular[0][k]; pdata[1] = angular[1][k]; pdata[2] = angular[2][k];
+    }
+    stream_field (frame, "ANGVEL", num, 3, data.data()); nfields ++;
+  }
+
+  if (ent & OUT_FORCE)
+  {
+    for (i = 0, pdata = data.data(); i < num; i ++, pdata += 3)
+    {
+      k = pset[i];
+      pdata[0] = force[0][k]; pdata[1] = force[1][k]; pdata[2] = force[2][k];
+    }
+    stream_field (frame, "FORCE", num, 3, data.data()); nfields ++;
+  }
+
+  if (ent & OUT_TORQUE)
+  {
+    for (i = 0, pdata = data.data(); i < num; i ++, pdata += 3)
+    {
+      k = pset[i];
+      pdata[0] = torque[0][k]; pdata[1] = torque[1][k]; pdata[2] = torque[2][k];
+    }
+    stream_field (frame, "TORQUE", num, 3, data.data()); nfields ++;
+  }
+
+  if (ent & OUT_ORIENT)
+  {
+    for (i = 0, pdata = data.data(); i < num; i ++, pdata += 9)
+    {
+      k = pset[i];
+      for (j = 0; j < 9; j ++) pdata[j] = rotation[j][k];
+    }
+    stream_field (frame, "ORIENT", num, 9, data.data()); nfields ++;
+  }
+
+  if (hisnum)
+  {
+    for (i = 0; i < hisnum; i ++) /* latest history samples */
+    {
+      Py_ssize_t size = PyList_Size ((PyObject*)history[i]);
+      data[i] = size > 0 ? PyFloat_AsDouble (PyList_GetItem ((PyObject*)history[i], size-1)) : NAN;
+    }
+    stream_field (frame, "HISTORY", hisnum, 1, data.data()); nfields ++;
+  }
+
+  /* header: magic, version, frame number, number of fields, time */
+  int header[4] = {0, 1, output_frame, nfields};
+  double time = curtime;
+  memcpy (header, "PMST", 4);
+  memcpy (&frame[0], header, 16);
+  memcpy (&frame[16], &time, 8);
+
+  for (size_t done = 0; done < frame.size(); )
+  {
+    ssize_t ret = write (stream_fd, &frame[done], frame.size()-done);
+
+    if (ret < 0 && errno == EINTR) continue;
+
+    if (ret <= 0)
+    {
+      fprintf (stderr, "WARNING: stream consumer has gone away (%s); streaming disabled\n", strerror(errno));
+      stream_close ();
+      stream_failed = 1;
+      return;
+    }
+
+    done += ret;
+  }
+}
+
 /* runtime file output */
 void output_files ()
 {
+  if (output_frame == 0) /* new run */
+  {
+    output_paths.clear();
+    h5_delta_map.clear();
+  }
+
   if (outformat & OUT_FORMAT_DUMP) output_dump_files();
 
   if (outformat & OUT_FORMAT_VTK) output_vtk_files();
@@ -5136,6 +5643,8 @@ void output_files ()
   if (outformat & OUT_FORMAT_MED) output_med_files ();
 #endif
 
+  if (outformat & OUT_FORMAT_STREAM) output_stream ();
+
   output_frame ++; 
 }
 
@@ -5531,44 +6040,6 @@ void output_history ()
   }
 }
 
-/* read .h5 dataset */
-static double* h5read (hid_t h5_step, const char *name, int *size)
-{
-  double *values = NULL;
-
-  /* XXX
-   * if (H5LTfind_dataset(h5_step, name)) is unreliable as
-   * it passes for names being substrings of dataset names;
-   * hence the below workaround */
-
-  hsize_t cur, num;
-  char buf[128];
-  H5Gget_num_objs (h5_step, &num);
-  for (cur = 0; cur < num; cur ++)
-  {
-    H5Gget_objname_by_idx (h5_step, cur, buf, 128);
-    if (strcmp (buf, name) == 0) break;
-  }
-
-  if (cur < num)
-  {
-    int rank;
-    H5LTget_dataset_ndims (h5_step, name, &rank);
-    ASSERT (rank <= 2, "HDF5 file read error: rank > 2");
-    hsize_t dims[2] = {0, 1};
-    H5T_class_t class_id;
-    size_t type_size;
-    H5LTget_dataset_info (h5_step, name, dims, &class_id, &type_size);
-    ASSERT (type_size == 8, "HDF5 file read error: expected double precision float");
-    ERRMEM (values = (double*)malloc (type_size*dims[0]*dims[1]));
-    ASSERT (H5LTread_dataset_double (h5_step, name, values) >= 0, "HDF5 file read error");
-    if (size) *size = dims[0];
-  }
-  else if (size) *size = 0;
-
-  return values;
-}
-
 /* output history from existing .h5 files */
 void output_h5history ()
 {
@@ -5658,7 +6129,7 @@ void output_h5history ()
               if (hiskind[i] & HIS_POINT) /* one particle point based */
               {
                 int k = hislst[hisidx[i]];
-                REAL value;
+                double value;
 
                 switch(hisent[i])
                 {
@@ -5673,13 +6144,13 @@ void output_h5history ()
                     {
                       ASSERT (GEOM0 && GEOM, "HDF5 file read error: GEOM dataset missing");
                       ASSERT (ORIENT, "HDF5 file read error: ORIENT dataset missing");
-                      REAL x[3] = {GEOM[k*3], GEOM[k*3+1], GEOM[k*3+2]};
-                      REAL X[3] = {GEOM0[k*3], GEOM0[k*3+1], GEOM0[k*3+2]};
-                      REAL L[9] = {ORIENT[k*9], ORIENT[k*9+1], ORIENT[k*9+2],
+                      double x[3] = {GEOM[k*3], GEOM[k*3+1], GEOM[k*3+2]};
+                      double X[3] = {GEOM0[k*3], GEOM0[k*3+1], GEOM0[k*3+2]};
+                      double L[9] = {ORIENT[k*9], ORIENT[k*9+1], ORIENT[k*9+2],
                         ORIENT[k*9+3], ORIENT[k*9+4], ORIENT[k*9+5],
                         ORIENT[k*9+6], ORIENT[k*9+7], ORIENT[k*9+8]};
-                      REAL P[3] = {source[0][i], source[1][i], source[2][i]};
-                      REAL Q[3], p[3];
+                      double P[3] = {source[0][i], source[1][i], source[2][i]};
+                      double Q[3], p[3];
 
                       SUB (P, X, Q);
                       NVADDMUL (x, L, Q, p);
@@ -5709,7 +6180,7 @@ void output_h5history ()
                           break;
                         case HIS_DL:
                           {
-                            REAL q[3] = {p[0]-P[0], p[1]-P[1], p[2]-P[2]};
+                            double q[3] = {p[0]-P[0], p[1]-P[1], p[2]-P[2]};
                             value = LEN(q);
                           }
                           break;
@@ -5725,15 +6196,15 @@ void output_h5history ()
                       ASSERT (ORIENT, "HDF5 file read error: ORIENT dataset missing");
                       ASSERT (LINVEL, "HDF5 file read error: LINVEL dataset missing");
                       ASSERT (ANGVEL, "HDF5 file read error: ANGVEL dataset missing");
-                      REAL x[3] = {GEOM[k*3], GEOM[k*3+1], GEOM[k*3+2]};
-                      REAL X[3] = {GEOM0[k*3], GEOM0[k*3+1], GEOM0[k*3+2]};
-                      REAL v[3] = {LINVEL[k*3], LINVEL[k*3+1], LINVEL[k*3+2]};
-                      REAL o[3] = {ANGVEL[k*3], ANGVEL[k*3+1], ANGVEL[k*3+2]};
-                      REAL L[9] = {ORIENT[k*9], ORIENT[k*9+1], ORIENT[k*9+2],
+                      double x[3] = {GEOM[k*3], GEOM[k*3+1], GEOM[k*3+2]};
+                      double X[3] = {GEOM0[k*3], GEOM0[k*3+1], GEOM0[k*3+2]};
+                      double v[3] = {LINVEL[k*3], LINVEL[k*3+1], LINVEL[k*3+2]};
+                      double o[3] = {ANGVEL[k*3], ANGVEL[k*3+1], ANGVEL[k*3+2]};
+                      double L[9] = {ORIENT[k*9], ORIENT[k*9+1], ORIENT[k*9+2],
                         ORIENT[k*9+3], ORIENT[k*9+4], ORIENT[k*9+5],
                         ORIENT[k*9+6], ORIENT[k*9+7], ORIENT[k*9+8]};
-                      REAL P[3] = {source[0][i], source[1][i], source[2][i]};
-                      REAL Q[3], p[3], a[3];
+                      double P[3] = {source[0][i], source[1][i], source[2][i]};
+                      double Q[3], p[3], a[3];
 
                       SUB (P, X, Q);
                       NVADDMUL (x, L, Q, p);
@@ -5752,7 +6223,7 @@ void output_h5history ()
                           break;
                         case HIS_VL:
                           {
-                            REAL q[3] = {v[0] + a[1]*o[2] - a[2]*o[1], v[1] + a[2]*o[0] - a[0]*o[2], v[2] + a[0]*o[1] - a[1]*o[0]};
+                            double q[3] = {v[0] + a[1]*o[2] - a[2]*o[1], v[1] + a[2]*o[0] - a[0]*o[2], v[2] + a[0]*o[1] - a[1]*o[0]};
                             value = LEN(q);
                           }
                           break;
@@ -5765,7 +6236,7 @@ void output_h5history ()
                   case HIS_OL:
                     {
                       ASSERT (ANGVEL, "HDF5 file read error: ANGVEL dataset missing");
-                      REAL o[3] = {ANGVEL[k*3], ANGVEL[k*3+1], ANGVEL[k*3+2]};
+                      double o[3] = {ANGVEL[k*3], ANGVEL[k*3+1], ANGVEL[k*3+2]};
 
                       switch (hisent[i])
                       {
@@ -5792,7 +6263,7 @@ void output_h5history ()
                   case HIS_FL:
                     {
                       ASSERT (FORCE, "HDF5 file read error: FORCE dataset missing");
-                      REAL f[3] = {FORCE[k*3], FORCE[k*3+1], FORCE[k*3+2]};
+                      double f[3] = {FORCE[k*3], FORCE[k*3+1], FORCE[k*3+2]};
 
                       switch (hisent[i])
                       {
@@ -5819,7 +6290,7 @@ void output_h5history ()
                   case HIS_TL:
                     {
                       ASSERT (TORQUE, "HDF5 file read error: TORQUE dataset missing");
-                      REAL t[3] = {TORQUE[k*3], TORQUE[k*3+1], TORQUE[k*3+2]};
+                      double t[3] = {TORQUE[k*3], TORQUE[k*3+1], TORQUE[k*3+2]};
 
                       switch (hisent[i])
                       {
@@ -5846,7 +6317,7 @@ void output_h5history ()
               }
               else /* particle or spring list based */
               {
-                REAL value = 0.0;
+                double value = 0.0;
 
                 for (int j = hisidx[i]; j < hisidx[i+1]; j ++)
                 {
@@ -5873,7 +6344,7 @@ void output_h5history ()
                     case HIS_PL:
                       {
                         ASSERT (GEOM, "HDF5 file read error: GEOM dataset missing");
-                        REAL q[3] = {GEOM[3*k], GEOM[3*k+1], GEOM[3*k+2]};
+                        double q[3] = {GEOM[3*k], GEOM[3*k+1], GEOM[3*k+2]};
                         value += LEN(q);
                       }
                       break;
@@ -5892,7 +6363,7 @@ void output_h5history ()
                     case HIS_DL:
                       {
                         ASSERT (GEOM0 && GEOM, "HDF5 file read error: GEOM dataset missing");
-                        REAL q[3] = {GEOM[3*k]-GEOM0[3*k], GEOM[3*k+1]-GEOM0[3*k+1], GEOM[3*k+2]-GEOM[3*k+2]};
+                        double q[3] = {GEOM[3*k]-GEOM0[3*k], GEOM[3*k+1]-GEOM0[3*k+1], GEOM[3*k+2]-GEOM[3*k+2]};
                         value += LEN(q);
                       }
                       break;
@@ -5911,7 +6382,7 @@ void output_h5history ()
                     case HIS_VL:
                       {
                         ASSERT (LINVEL, "HDF5 file read error: LINVEL dataset missing");
-                        REAL q[3] = {LINVEL[3*k], LINVEL[3*k+1], LINVEL[3*k+2]};
+                        double q[3] = {LINVEL[3*k], LINVEL[3*k+1], LINVEL[3*k+2]};
                         value += LEN(q);
                       }
                       break;
@@ -5930,7 +6401,7 @@ void output_h5history ()
                     case HIS_OL:
                       {
                         ASSERT (ANGVEL, "HDF5 file read error: ANGVEL dataset missing");
-                        REAL q[3] = {ANGVEL[3*k], ANGVEL[3*k+1], ANGVEL[3*k+2]};
+                        double q[3] = {ANGVEL[3*k], ANGVEL[3*k+1], ANGVEL[3*k+2]};
                         value += LEN(q);
                       }
                       break;
@@ -5949,7 +6420,7 @@ void output_h5history ()
                     case HIS_FL:
                       {
                         ASSERT (FORCE, "HDF5 file read error: FORCE dataset missing");
-                        REAL q[3] = {FORCE[3*k], FORCE[3*k+1], FORCE[3*k+2]};
+                        double q[3] = {FORCE[3*k], FORCE[3*k+1], FORCE[3*k+2]};
                         value += LEN(q);
                       }
                       break;
@@ -5968,7 +6439,7 @@ void output_h5history ()
                     case HIS_TL:
                       {
                         ASSERT (TORQUE, "HDF5 file read error: TORQUE dataset missing");
-                        REAL q[3] = {TORQUE[3*k], TORQUE[3*k+1], TORQUE[3*k+2]};
+                        double q[3] = {TORQUE[3*k], TORQUE[3*k+1], TORQUE[3*k+2]};
                         value += LEN(q);
                       }
                       break;
@@ -6166,7 +6637,7 @@ void output_h5history ()
                     case HIS_JREAC_L:
                       {
                         ASSERT (JREAC, "HDF5 file read error: JREAC dataset missing");
-                        REAL q[3] = {JREAC[3*k], JREAC[3*k+1], JREAC[3*k+2]};
+                        double q[3] = {JREAC[3*k], JREAC[3*k+1], JREAC[3*k+2]};
                         value += LEN(q);
                       }
                       break;
@@ -6175,7 +6646,7 @@ void output_h5history ()
 
                 int j = hisidx[i+1]-hisidx[i];
 
-                PyList_Append ((PyObject*)history[i], PyFloat_FromDouble(value/(REAL)j));
+                PyList_Append ((PyObject*)history[i], PyFloat_FromDouble(value/(double)j));
               }
             }
             break;
@@ -6211,9 +6682,36 @@ void output_h5history ()
   }
 }
 
+/* set output dataset precision */
+void output_precision (const char *dataset, int kind, double error)
+{
+  h5_precision &prec = h5_precision_map[dataset];
+  prec.kind = kind;
+  prec.error = error;
+}
+
+/* restore default output precision */
+void output_precision_reset ()
+{
+  h5_precision_map.clear();
+  h5_delta_map.clear();
+}
+
+/* set streaming output path */
+void output_stream_path (const char *path)
+{
+  if (stream_path != path) stream_close ();
+  stream_path = path;
+  stream_failed = 0;
+}
+
 /* close files and reset global output variables */
 void output_reset ()
 {
+  stream_close ();
+  stream_path.clear();
+  stream_failed = 0;
+
 #if MED
   if (med_fid_md >= 0)
   {
@@ -31,6 +31,12 @@ void output_history (); /* runtime history output */
 
 void output_h5history (); /* output history from existing .h5 files */
 
+void output_precision (const char *dataset, int kind, double error); /* set output dataset precision */
+
+void output_precision_reset (); /* restore default output precision */
+
+void output_stream_path (const char *path); /* set streaming output path */
+
 void output_reset (); /* close files and reset global output variables */
 
 #endif
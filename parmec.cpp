@@ -42,6 +42,9 @@
 #include "input.h"
 #include "output.h"
 #include "joints.h"
+#include "obstree.h"
+#include "couple.h"
+#include "domain.h"
 #include "constants.h"
 #include "parmec_ispc.h"
 #include "partition_ispc.h"
@@ -54,6 +57,8 @@
 using namespace parmec;
 using namespace ispc; /* ISPC calls are used below */
 
+#define MRSAFETY 0.5 /* fraction of the per-particle critical step bounding multi-rate substeps */
+
 #ifdef __cplusplus
 namespace parmec { /* namespace */
 #endif
@@ -109,6 +114,8 @@ namespace parmec { /* namespace */
   REAL *emax; /* time step control --> maximum damper coefficient per particle */
   REAL *krot[6]; /* time step control --> symmetric rotational unit stiffness matrix per particle */
   int *flags; /* particle flags */
+  int *parid; /* particle id --> number returned to user */
+  int *parmap; /* map of particle ids to particle indices */
   ispc::master_conpnt *master; /* master contact points */
   ispc::slave_conpnt *slave; /* slave contact points */
   int particle_buffer_size; /* size of the buffer */
@@ -146,6 +153,8 @@ namespace parmec { /* namespace */
   REAL *obslin; /* obstacle linear velocities at t and t+h */
   pointer_t *anghis; /* angular velocity history */
   pointer_t *linhis; /* linear velocity history */
+  int *angtms[3]; /* angular velocity time series */
+  int *lintms[3]; /* linear velocity time series */
   int obstacle_buffer_size; /* size of the buffer */
 
   int sprnum; /* number of spring constraints */
@@ -229,8 +238,21 @@ namespace parmec { /* namespace */
   REAL *jpoint[3]; /* joint points */
   REAL *jreac[3]; /* joint reactions */
   int joints_changed; /* joints changed flag */
+  REAL jtol; /* joints iterative solver relative tolerance; zero selects the direct solver */
   int joints_buffer_size; /* size of joints buffer */
 
+  int mrmax; /* maximum multi-rate level of sub-cycled springs; zero disables multi-rate stepping */
+
+  int reorder; /* number of time steps between Morton reordering of particles; zero disables reordering */
+
+  const char *phase_name[NPHASE] = {"partitioning_store", "partitioning_create", "condet", "forces_contacts",
+    "forces_accumulate", "forces_springs", "forces_torsion_springs", "forces_unsprings", "multirate",
+    "solve_joints", "dynamics", "shapes", "obstacles", "callbacks", "reorder", "domain", "output", "total"}; /* timed phase names */
+  const char *count_name[NCOUNT] = {"steps", "contacts", "chain_blocks", "repartitions", "lock_spins"}; /* performance counter names */
+  double phase_time[NPHASE]; /* cumulative wall time per phase */
+  long count_total[NCOUNT]; /* cumulative performance counters */
+  char *trace_path; /* per-step CSV trace of phase times and counters; NULL disables tracing */
+
   int tmsnum; /* number of time series */
   pointer_t *tms; /* time series */
   int time_series_buffer_size; /* size of time series buffer */
@@ -269,6 +291,12 @@ namespace parmec { /* namespace */
   int *outent; /* output entities per output mode */
   int outrest[2]; /* 0: default output entities for unlisted particles and, 1: default output mode */
   int outformat; /* output format */
+  int *outroi; /* output region of interest kind */
+  REAL *outreg[6]; /* output region of interest: sphere (center, radius) or box (min, max corners) */
+  int *outdec[2]; /* output decimation: every n-th frame 0: inside and 1: outside of the region of interest */
+  int outrestroi; /* region of interest kind for unlisted particles */
+  REAL outrestreg[6]; /* region of interest for unlisted particles */
+  int outrestdec[2]; /* output decimation for unlisted particles */
   int output_buffer_size; /* size of output buffer */
   int output_list_size; /* size of output particle lists buffer */
 
@@ -284,6 +312,12 @@ namespace parmec { /* namespace */
 
   MAP *prescribed_body_forces; /* particle index based map of prescibed body forces */
 
+  int cplnum; /* number of particles coupled with an external solver */
+  int *cplpart; /* coupled particle numbers indexed by coupling slot */
+  REAL *cplouter[6]; /* outer force and torque per coupling slot */
+  int cplevery; /* number of time steps between co-simulation exchanges */
+  double cpltimeout; /* seconds to wait for the coupled solver */
+
   /* grow integer buffer */
   void integer_buffer_grow (int* &src, int num, int size)
   {
@@ -529,6 +563,8 @@ namespace parmec { /* namespace */
     krot[4] = aligned_real_alloc (particle_buffer_size);
     krot[5] = aligned_real_alloc (particle_buffer_size);
     flags = aligned_int_alloc (particle_buffer_size);
+    parid = aligned_int_alloc (particle_buffer_size);
+    parmap = aligned_int_alloc (particle_buffer_size);
     master = master_alloc (NULL, 0, particle_buffer_size);
     slave = slave_alloc (NULL, 0, particle_buffer_size);
 
@@ -603,6 +639,8 @@ namespace parmec { /* namespace */
     real_buffer_grow (krot[4], parnum, particle_buffer_size);
     real_buffer_grow (krot[5], parnum, particle_buffer_size);
     integer_buffer_grow (flags, parnum, particle_buffer_size);
+    integer_buffer_grow (parid, parnum, particle_buffer_size);
+    integer_buffer_grow (parmap, parnum, particle_buffer_size);
     master = master_alloc (master, parnum, particle_buffer_size);
     slave = slave_alloc (slave, parnum, particle_buffer_size);
 
@@ -735,6 +773,11 @@ namespace parmec { /* namespace */
     obslin = aligned_real_alloc (3*obstacle_buffer_size);
     anghis = new pointer_t [obstacle_buffer_size];
     linhis = new pointer_t [obstacle_buffer_size];
+    for (int k = 0; k < 3; k ++)
+    {
+      angtms[k] = aligned_int_alloc (obstacle_buffer_size);
+      lintms[k] = aligned_int_alloc (obstacle_buffer_size);
+    }
 
     obsnum = 0;
   }
@@ -750,6 +793,11 @@ namespace parmec { /* namespace */
     real_buffer_grow (obslin, 3*obsnum, 3*obstacle_buffer_size);
     pointer_buffer_grow (anghis, obsnum, obstacle_buffer_size);
     pointer_buffer_grow (linhis, obsnum, obstacle_buffer_size);
+    for (int k = 0; k < 3; k ++)
+    {
+      integer_buffer_grow (angtms[k], obsnum, obstacle_buffer_size);
+      integer_buffer_grow (lintms[k], obsnum, obstacle_buffer_size);
+    }
 
     return obstacle_buffer_size;
   }
@@ -1164,6 +1212,7 @@ namespace parmec { /* namespace */
 
     jnum = 0;
     joints_changed = 0;
+    jtol = 0.0;
   }
 
   /* grow joints buffer */
@@ -1368,11 +1417,17 @@ namespace parmec { /* namespace */
     outpart = aligned_int_alloc (output_list_size);
     outidx = aligned_int_alloc (output_buffer_size+1);
     outent = aligned_int_alloc (output_buffer_size);
+    outroi = aligned_int_alloc (output_buffer_size);
+    for (int i = 0; i < 6; i ++) outreg[i] = aligned_real_alloc (output_buffer_size);
+    outdec[0] = aligned_int_alloc (output_buffer_size);
+    outdec[1] = aligned_int_alloc (output_buffer_size);
     outrest[0] = OUT_NUMBER|OUT_COLOR|OUT_DISPL|OUT_LENGTH|OUT_ORIENT|OUT_ORIENT1|OUT_ORIENT2|OUT_ORIENT3|
       OUT_LINVEL|OUT_ANGVEL|OUT_FORCE|OUT_TORQUE|OUT_F|OUT_FN|OUT_FT|OUT_SF|OUT_AREA|OUT_PAIR|OUT_SS|OUT_FF|
       OUT_XDIR|OUT_YDIR|OUT_ZDIR|OUT_TRQROT|OUT_TRQTOT|OUT_TRQSPR|OUT_JREAC;
     outrest[1] = OUT_MODE_SPH|OUT_MODE_MESH|OUT_MODE_RB|OUT_MODE_CD|OUT_MODE_SL|OUT_MODE_ST|OUT_MODE_JT;
     outformat = OUT_FORMAT_XDMF;
+    outrestroi = OUT_ROI_NONE;
+    outrestdec[0] = outrestdec[1] = 1;
 
     outnum = 0;
     outidx[outnum] = 0;
@@ -1388,6 +1443,10 @@ namespace parmec { /* namespace */
       integer_buffer_grow (outmode, outnum, output_buffer_size);
       integer_buffer_grow (outidx, outnum, output_buffer_size+1);
       integer_buffer_grow (outent, outnum, output_buffer_size);
+      integer_buffer_grow (outroi, outnum, output_buffer_size);
+      for (int i = 0; i < 6; i ++) real_buffer_grow (outreg[i], outnum, output_buffer_size);
+      integer_buffer_grow (outdec[0], outnum, output_buffer_size);
+      integer_buffer_grow (outdec[1], outnum, output_buffer_size);
     }
 
     if (output_list_size < outidx[outnum] + list_size)
@@ -1680,7 +1739,7 @@ namespace parmec { /* namespace */
   };
 
   /* sort springs according to particle indices */
-  static void sort_springs ()
+  void sort_springs ()
   {
     std::vector<spring_data> v;
 
@@ -2198,6 +2257,291 @@ namespace parmec { /* namespace */
     parmec::trqrefpnt[2] = trqrefpnt[2];
   }
 
+  /* permute n items so that a[i] = a[perm[i]] on exit; done to completion cycle by cycle */
+  template <class T> static void permute (T *a, const int *perm, int n, std::vector<char> &done)
+  {
+    std::fill (done.begin(), done.begin()+n, 0);
+
+    for (int i = 0; i < n; i ++)
+    {
+      if (done[i]) continue;
+
+      T t = a[i];
+      int j = i;
+
+      for (int k = perm[j]; k != i; j = k, k = perm[k])
+      {
+        a[j] = a[k];
+        done[j] = 1;
+      }
+
+      a[j] = t;
+      done[j] = 1;
+    }
+  }
+
+  /* map non-negative indices through the inverse permutation */
+  static void remap (int *a, int n, const int *inv)
+  {
+    for (int i = 0; i < n; i ++)
+    {
+      if (a[i] >= 0) a[i] = inv[a[i]];
+    }
+  }
+
+  /* drop particle-particle contact points whose slave particle is gone (index >= parnum) and move those stored
+   * under the larger particle index to the master list of the smaller one (condet.ispc:drop_ellipsoid looks
+   * them up there), swapping the roles of their particles and ellipsoids */
+  void tidy_contacts ()
+  {
+    const int nstate = sizeof (master->state) / sizeof (master->state[0]); /* see condet.h:NSTATE */
+
+    for (int i = 0; i < parnum; i ++)
+    {
+      for (master_conpnt *con = &master[i]; con; con = con->next)
+      {
+        for (int j = 0; j < con->size; j ++)
+        {
+          int l = con->slave[0][j], k;
+
+          if (l < 0 || (l > i && l < parnum)) continue; /* obstacle contact or stored under the smaller index */
+
+          if (l < parnum) /* otherwise the slave particle is gone */
+          {
+            master_conpnt *dst = master_append (&master[l], &k);
+
+            dst->master[k] = con->slave[1][j];
+            dst->slave[0][k] = i;
+            dst->slave[1][k] = con->master[j];
+            dst->color[0][k] = con->color[1][j];
+            dst->color[1][k] = con->color[0][j];
+            dst->depth[k] = con->depth[j];
+            dst->kcur[k] = con->kcur[j];
+            dst->ecur[k] = con->ecur[j];
+            dst->feature[k] = con->feature[j];
+            for (int m = 0; m < 3; m ++)
+            {
+              dst->point[m][k] = con->point[m][j];
+              dst->normal[m][k] = -con->normal[m][j];
+              dst->force[m][k] = -con->force[m][j];
+            }
+            for (int m = 0; m < nstate; m ++)
+            {
+              dst->state[m][k] = m < 3 ? -con->state[m][j] : con->state[m][j]; /* tangential displacement, see forces.ispc:granural_force */
+            }
+          }
+
+          int last = -- con->size; /* fill the gap with the last item */
+
+          if (j < last)
+          {
+            con->master[j] = con->master[last];
+            con->slave[0][j] = con->slave[0][last];
+            con->slave[1][j] = con->slave[1][last];
+            con->color[0][j] = con->color[0][last];
+            con->color[1][j] = con->color[1][last];
+            con->depth[j] = con->depth[last];
+            con->kcur[j] = con->kcur[last];
+            con->ecur[j] = con->ecur[last];
+            con->feature[j] = con->feature[last];
+            for (int m = 0; m < 3; m ++)
+            {
+              con->point[m][j] = con->point[m][last];
+              con->normal[m][j] = con->normal[m][last];
+              con->force[m][j] = con->force[m][last];
+            }
+            for (int m = 0; m < nstate; m ++) con->state[m][j] = con->state[m][last];
+          }
+
+          j --;
+        }
+      }
+    }
+  }
+
+  struct cmp_ellipsoid
+  {
+    const int *inv; /* particle inverse permutation */
+
+    bool operator() (const int a, const int b)
+    {
+      return inv[part[a]] < inv[part[b]];
+    }
+  };
+
+  /* reorder particles so that particle perm[i] becomes particle i; contact detection ellipsoids
+   * follow their particles (analytical ones stay in place); particle and ellipsoid indices stored
+   * in contacts, shapes, springs, joints, restraints, prescriptions and histories are remapped,
+   * while parid and parmap keep track of particle numbers returned to the user; when num < parnum
+   * only the particles listed in perm[0...num-1] are kept, together with their ellipsoids and the
+   * contact points between them (see domain.cpp; other references to dropped particles must not exist) */
+  void reorder_particles (const int *perm, int num, int *level)
+  {
+    std::vector<int> inv (parnum, -1), eperm (ellnum-ellcon), einv (ellnum-ellcon);
+    std::vector<char> done (std::max (parnum, ellnum));
+    int i, j, k;
+
+    for (i = 0; i < num; i ++) inv[perm[i]] = i;
+
+    if (num < parnum) /* dropped particles follow in their current order */
+    {
+      std::vector<int> full (perm, perm+num);
+
+      for (i = 0; i < parnum; i ++)
+      {
+        if (inv[i] < 0)
+        {
+          inv[i] = full.size();
+          full.push_back (i);
+        }
+      }
+
+      reorder_particles (&full[0], parnum, level);
+
+      conpnt_reset (master, slave, num, parnum);
+
+      ellnum = std::lower_bound (part+ellcon, part+ellnum, num) - part; /* ellipsoids of dropped particles are last */
+
+      parnum = num;
+
+      tidy_contacts ();
+
+      return;
+    }
+
+    cmp_ellipsoid cmp = {&inv[0]};
+
+    for (i = ellcon; i < ellnum; i ++) eperm[i-ellcon] = i;
+
+    std::stable_sort (eperm.begin(), eperm.end(), cmp); /* keep [ellcon, ellnum) sorted by particle, see shuffle_ellipsoids */
+
+    for (i = 0; i < ellnum-ellcon; i ++)
+    {
+      eperm[i] -= ellcon;
+      einv[eperm[i]] = i;
+    }
+
+    /* ellipsoids */
+    int *ep = eperm.empty() ? NULL : &eperm[0], en = ellnum-ellcon;
+    permute (ellcol+ellcon, ep, en, done);
+    permute (part+ellcon, ep, en, done);
+    for (k = 0; k < 6; k ++) permute (center[k]+ellcon, ep, en, done);
+    for (k = 0; k < 3; k ++) permute (radii[k]+ellcon, ep, en, done);
+    for (k = 0; k < 18; k ++) permute (orient[k]+ellcon, ep, en, done);
+    remap (part, ellnum, &inv[0]);
+
+    /* particles */
+    permute (parmat, perm, parnum, done);
+    for (k = 0; k < 6; k ++) permute (angular[k], perm, parnum, done);
+    for (k = 0; k < 3; k ++) permute (linear[k], perm, parnum, done);
+    for (k = 0; k < 9; k ++) permute (rotation[k], perm, parnum, done);
+    for (k = 0; k < 6; k ++) permute (position[k], perm, parnum, done);
+    for (k = 0; k < 9; k ++) permute (inertia[k], perm, parnum, done);
+    for (k = 0; k < 9; k ++) permute (inverse[k], perm, parnum, done);
+    permute (mass, perm, parnum, done);
+    permute (invm, perm, parnum, done);
+    for (k = 0; k < 3; k ++) permute (force[k], perm, parnum, done);
+    for (k = 0; k < 3; k ++) permute (torque[k], perm, parnum, done);
+    for (k = 0; k < 3; k ++) permute (kact[k], perm, parnum, done);
+    permute (kmax, perm, parnum, done);
+    permute (emax, perm, parnum, done);
+    for (k = 0; k < 6; k ++) permute (krot[k], perm, parnum, done);
+    permute (flags, perm, parnum, done);
+    permute (parid, perm, parnum, done);
+    permute (master, perm, parnum, done);
+    permute (slave, perm, parnum, done);
+    if (level) permute (level, perm, parnum, done);
+
+    if (domain_size () == 1) /* distributed runs map particle numbers in domain.cpp */
+    {
+      for (i = 0; i < parnum; i ++) parmap[parid[i]] = i;
+    }
+
+    /* contact points; ellipsoid indices are relative to ellcon */
+    for (i = 0; i < parnum; i ++)
+    {
+      for (master_conpnt *con = &master[i]; con; con = con->next)
+      {
+        for (j = 0; j < con->size; j ++)
+        {
+          con->master[j] = einv[con->master[j]];
+          if (con->slave[0][j] >= 0) con->slave[0][j] = inv[con->slave[0][j]];
+          if (con->slave[1][j] >= 0) con->slave[1][j] = einv[con->slave[1][j]];
+        }
+      }
+
+      for (slave_conpnt *con = &slave[i]; con; con = con->next)
+      {
+        for (j = 0; j < con->size; j ++)
+        {
+          con->master[0][j] = inv[con->master[0][j]];
+          con->master[1][j] = einv[con->master[1][j]];
+        }
+      }
+    }
+
+    tidy_contacts ();
+
+    /* particle references */
+    remap (nodpart, nodnum, &inv[0]);
+    remap (elepart, elenum, &inv[0]);
+    remap (facpart, facnum, &inv[0]);
+    remap (triobs, trinum, &inv[0]);
+    remap (sprpart[0], sprnum, &inv[0]);
+    remap (sprpart[1], sprnum, &inv[0]);
+    remap (trqsprpart[0], trqsprnum, &inv[0]);
+    remap (trqsprpart[1], trqsprnum, &inv[0]);
+    remap (jpart[0], jnum, &inv[0]);
+    remap (jpart[1], jnum, &inv[0]);
+    remap (rstpart, rstnum, &inv[0]);
+    remap (prspart, prsnum, &inv[0]);
+    remap (cplpart, cplnum, &inv[0]);
+
+    for (i = 0; i < hisnum; i ++)
+    {
+      if ((hiskind[i] & HIS_LIST) && hisent[i] < HIS_LENGTH && !h5file[i])
+      {
+        remap (hislst+hisidx[i], hisidx[i+1]-hisidx[i], &inv[0]);
+      }
+    }
+
+    for (MAP *item = MAP_First (prescribed_body_forces); item; item = MAP_Next (item))
+    {
+      struct prescribed_body_force *p = (struct prescribed_body_force*) item->data;
+
+      p->particle = inv[p->particle]; /* map keys remain user numbers */
+    }
+
+    /* springs are sorted by particle indices and joints have particle based symbolic data */
+    if (sprnum) sort_springs ();
+
+    if (trqsprnum) sort_trqspr ();
+
+    if (jnum) reset_joints_symbolic (jnum, jpart);
+  }
+
+  /* reorder particles along the Morton curve of their current positions */
+  static void morton_particles (int ntasks, int *level)
+  {
+    std::vector<int> order (parnum);
+
+    if (parnum == 0) return;
+
+    morton_order (ntasks, parnum, position[0], position[1], position[2], &order[0]);
+
+    reorder_particles (&order[0], parnum, level);
+  }
+
+  /* restore the input order of particles */
+  static void restore_particles (int *level)
+  {
+    std::vector<int> order (parmap, parmap+parnum);
+
+    if (parnum == 0) return;
+
+    reorder_particles (&order[0], parnum, level);
+  }
+
   /* add up prescribed body forces */
   static void prescribe_body_forces (MAP *prescribed_body_forces, REAL *force[3], REAL *toruqe[3])
   {
@@ -2284,6 +2628,13 @@ namespace parmec { /* namespace */
     springs_changed = 0; /* unset linear springs changed flag */
     trqspr_changed = 0; /* unset torsion springs changed flag */
     joints_changed = 0; /* unset joints changed flag */
+    jtol = 0.0; /* direct joints solver by default */
+    mrmax = 0; /* single rate stepping by default */
+    reorder = 0; /* input order of particles by default */
+
+    /* zero phase timers and counters */
+    for (int i = 0; i < NPHASE; i ++) phase_time[i] = 0.0;
+    for (int i = 0; i < NCOUNT; i ++) count_total[i] = 0;
 
     /* unselected particles default output flags */
     outrest[0] = OUT_NUMBER|OUT_COLOR|OUT_DISPL|OUT_LENGTH|OUT_ORIENT|OUT_ORIENT1|OUT_ORIENT2|OUT_ORIENT3|
@@ -2291,6 +2642,9 @@ namespace parmec { /* namespace */
       OUT_XDIR|OUT_YDIR|OUT_ZDIR|OUT_TRQROT|OUT_TRQTOT|OUT_TRQSPR|OUT_JREAC;
     outrest[1] = OUT_MODE_SPH|OUT_MODE_MESH|OUT_MODE_RB|OUT_MODE_CD|OUT_MODE_SL|OUT_MODE_ST|OUT_MODE_JT;
     outformat = OUT_FORMAT_XDMF;
+    outrestroi = OUT_ROI_NONE;
+    outrestdec[0] = outrestdec[1] = 1;
+    output_precision_reset ();
 
     /* zero global damping by default */
     damping[0] = damping[1] = damping[2] = damping[3] = damping[4] = damping[5] = 0.0;
@@ -2306,9 +2660,215 @@ namespace parmec { /* namespace */
     /* no prescribed body forces by default */
     prescribed_body_forces = NULL;
 
+    /* no co-simulation by default */
+    couple_close ();
+    delete [] cplpart;
+    for (int k = 0; k < 6; k ++) delete [] cplouter[k];
+    cplpart = NULL;
+    for (int k = 0; k < 6; k ++) cplouter[k] = NULL;
+    cplnum = 0;
+
     pair_reset();
 
     output_reset();
+
+    domain_reset ();
+  }
+
+  /* assign multi-rate levels: a particle is sub-cycled 2^level times per coarse step so that its
+   * substep is within MRSAFETY of its critical step; restrained, prescribed, jointed and analytical
+   * particles stay at level zero; returns the maximum assigned level */
+  static int multirate_levels (int ntasks, REAL step, int *level)
+  {
+    REAL *hcri = new REAL[parnum];
+    REAL *ocri = new REAL[parnum];
+    REAL *rcri = new REAL[parnum];
+    int i, l, lmax;
+
+    critical_perparticle (ntasks, master, slave, parnum, mass, inertia, invm, inverse,
+        rotation, position, sprnum, sprflg, sprpart, sprpnt, sprdir,
+        spring, spridx, dashpot, dashidx, kact, kmax, emax, krot, hcri,
+        ocri, rcri);
+
+    for (i = 0; i < parnum; i ++)
+    {
+      for (l = 0; l < mrmax && step > MRSAFETY*hcri[i]*(REAL)(1 << l); l ++);
+
+      level[i] = flags[i] & ANALYTICAL ? 0 : l;
+    }
+
+    for (i = 0; i < rstnum; i ++) level[rstpart[i]] = 0;
+
+    for (i = 0; i < prsnum; i ++) level[prspart[i]] = 0;
+
+    for (i = 0; i < jnum; i ++) level[jpart[0][i]] = level[jpart[1][i]] = 0;
+
+    for (lmax = i = 0; i < parnum; i ++) lmax = MAX (lmax, level[i]);
+
+    delete [] hcri;
+    delete [] ocri;
+    delete [] rcri;
+
+    return lmax;
+  }
+
+  /* sub-cycle springs and stiff particles within one coarse step; on entry force and torque hold
+   * the spring-free forces; on exit level zero particles hold total forces for the coarse dynamics */
+  static void multirate_step (int ntasks, int *level, int lmax, REAL *buf[18], REAL step, REAL time)
+  {
+    REAL **slow = buf, **acc = buf+6, **spr = buf+12;
+    int nsub = 1 << lmax;
+    REAL h = step / (REAL) nsub;
+
+    for (int k = 0; k < 3; k ++)
+    {
+      memcpy (slow[k], force[k], parnum * sizeof (REAL));
+      memcpy (slow[3+k], torque[k], parnum * sizeof (REAL));
+    }
+
+    for (int s = 0; s < nsub; s ++)
+    {
+      springs (ntasks, parnum, sprnum, sprtype, unspring, sprpart, sprpnt, spring, spridx, dashpot, dashidx,
+        unload, unidx, yield, sprdir, sprflg, sproffset, sprfric, sprkskn, sprsdsp, stroke0, stroke, sprfrc,
+        lcurve, lcidx, angular, linear, rotation, position, inverse, invm, spr, spr+3, kact, kmax, emax, krot,
+        h, time + s*h);
+
+      multirate (ntasks, parnum, level, lmax, s, slow, acc, spr, angular, linear, rotation, position,
+        inertia, inverse, mass, invm, damping, force, torque, flags, step);
+    }
+  }
+
+  /* split forces wall time between its subphases in proportion to their clock ticks */
+  static void forces_phases (double sec, int64_t perf[NPERF])
+  {
+    int64_t ticks = 0;
+
+    for (int i = PERF_CONTACTS; i < PERF_SPINS; i ++) ticks += perf[i];
+
+    for (int i = PERF_CONTACTS; i < PERF_SPINS; i ++)
+    {
+      phase_time[PHASE_CONTACTS+i] += ticks > 0 ? sec*(double)perf[i]/(double)ticks : (i == PERF_CONTACTS ? sec : 0.0);
+    }
+
+    count_total[COUNT_SPINS] += perf[PERF_SPINS];
+    count_total[COUNT_CONTACTS] += perf[PERF_POINTS]; /* counted by forces while visiting contact chains */
+    count_total[COUNT_BLOCKS] += perf[PERF_BLOCKS];
+  }
+
+  /* append one time step row to the trace file */
+  static void trace_step (FILE *trace, REAL time, REAL step, double time0[NPHASE], long count0[NCOUNT])
+  {
+    if (ftell (trace) == 0)
+    {
+      fprintf (trace, "time,step");
+      for (int i = 0; i < NPHASE; i ++) fprintf (trace, ",%s", phase_name[i]);
+      for (int i = 0; i < NCOUNT; i ++) fprintf (trace, ",%s", count_name[i]);
+      fprintf (trace, "\n");
+    }
+
+    fprintf (trace, "%g,%g", (double)time, (double)step);
+    for (int i = 0; i < NPHASE; i ++) fprintf (trace, ",%g", phase_time[i]-time0[i]);
+    for (int i = 0; i < NCOUNT; i ++) fprintf (trace, ",%ld", count_total[i]-count0[i]);
+    fprintf (trace, "\n");
+  }
+
+  /* print cumulative phase timers and counters */
+  static void print_timers ()
+  {
+    double total = phase_time[PHASE_TOTAL], other = total;
+    long steps = MAX (count_total[COUNT_STEPS], 1);
+
+    printf ("Phase timers (cumulative):\n");
+
+    for (int i = 0; i < PHASE_TOTAL; i ++)
+    {
+      if (phase_time[i] > 0.0) printf ("  %-24s %10.3f sec %6.2f %%\n", phase_name[i], phase_time[i], total > 0.0 ? 100.0*phase_time[i]/total : 0.0);
+      other -= phase_time[i];
+    }
+
+    printf ("  %-24s %10.3f sec %6.2f %%\n", "other", MAX (other, 0.0), total > 0.0 ? 100.0*MAX (other, 0.0)/total : 0.0);
+    printf ("  %-24s %10.3f sec\n", phase_name[PHASE_TOTAL], total);
+    printf ("Counters: %ld steps, %.1f contacts and %.1f chain blocks per step, %ld repartitions, %ld lock spins\n",
+      count_total[COUNT_STEPS], (double)count_total[COUNT_CONTACTS]/(double)steps, (double)count_total[COUNT_BLOCKS]/(double)steps,
+      count_total[COUNT_REPART], count_total[COUNT_SPINS]);
+  }
+
+  /* reallocate particle, ellipsoid and spring buffers so that their pages are first touched by task i
+   * within the equal n/ntasks span i; with pinned threads (see tasksys.cpp) this keeps them local to
+   * NUMA nodes only as long as the balanced kernel spans (see schedule.h) stay close to these equal
+   * spans, which holds for uniform loads but not for strongly clustered contacts;
+   * buffers already touched since their last reallocation are skipped */
+  static void numa_touch (int ntasks)
+  {
+    static void *touched[3] = {NULL, NULL, NULL};
+    int n, size, k;
+
+    if (touched[0] != master)
+    {
+      n = parnum;
+      size = particle_buffer_size;
+
+      parmat = touch_int (ntasks, parmat, n, size);
+      for (k = 0; k < 6; k ++) angular[k] = touch_real (ntasks, angular[k], n, size);
+      for (k = 0; k < 3; k ++) linear[k] = touch_real (ntasks, linear[k], n, size);
+      for (k = 0; k < 9; k ++) rotation[k] = touch_real (ntasks, rotation[k], n, size);
+      for (k = 0; k < 6; k ++) position[k] = touch_real (ntasks, position[k], n, size);
+      for (k = 0; k < 9; k ++) inertia[k] = touch_real (ntasks, inertia[k], n, size);
+      for (k = 0; k < 9; k ++) inverse[k] = touch_real (ntasks, inverse[k], n, size);
+      mass = touch_real (ntasks, mass, n, size);
+      invm = touch_real (ntasks, invm, n, size);
+      for (k = 0; k < 3; k ++) force[k] = touch_real (ntasks, force[k], n, size);
+      for (k = 0; k < 3; k ++) torque[k] = touch_real (ntasks, torque[k], n, size);
+      for (k = 0; k < 3; k ++) kact[k] = touch_real (ntasks, kact[k], n, size);
+      kmax = touch_real (ntasks, kmax, n, size);
+      emax = touch_real (ntasks, emax, n, size);
+      for (k = 0; k < 6; k ++) krot[k] = touch_real (ntasks, krot[k], n, size);
+      flags = touch_int (ntasks, flags, n, size);
+      parid = touch_int (ntasks, parid, n, size);
+      parmap = touch_int (ntasks, parmap, n, size);
+      master = master_touch (ntasks, master, n, size);
+      slave = slave_touch (ntasks, slave, n, size);
+
+      touched[0] = master;
+    }
+
+    if (touched[1] != center[0])
+    {
+      n = ellnum;
+      size = ellipsoid_buffer_size;
+
+      part = touch_int (ntasks, part, n, size);
+      ellcol = touch_int (ntasks, ellcol, n, size);
+      for (k = 0; k < 6; k ++) center[k] = touch_real (ntasks, center[k], n, size);
+      for (k = 0; k < 3; k ++) radii[k] = touch_real (ntasks, radii[k], n, size);
+      for (k = 0; k < 18; k ++) orient[k] = touch_real (ntasks, orient[k], n, size);
+
+      touched[1] = center[0];
+    }
+
+    if (touched[2] != sprpnt[0][0])
+    {
+      n = sprnum;
+      size = spring_buffer_size;
+
+      sprtype = touch_int (ntasks, sprtype, n, size);
+      unspring = touch_int (ntasks, unspring, n, size);
+      for (k = 0; k < 2; k ++) sprpart[k] = touch_int (ntasks, sprpart[k], n, size);
+      for (k = 0; k < 6; k ++) sprpnt[0][k] = touch_real (ntasks, sprpnt[0][k], n, size);
+      for (k = 0; k < 6; k ++) sprpnt[1][k] = touch_real (ntasks, sprpnt[1][k], n, size);
+      for (k = 0; k < 2; k ++) yield[k] = touch_real (ntasks, yield[k], n, size);
+      for (k = 0; k < 6; k ++) sprdir[k] = touch_real (ntasks, sprdir[k], n, size);
+      sprflg = touch_int (ntasks, sprflg, n, size);
+      sproffset = touch_int (ntasks, sproffset, n, size);
+      sprfric = touch_real (ntasks, sprfric, n, size);
+      sprkskn = touch_real (ntasks, sprkskn, n, size);
+      for (k = 0; k < 3; k ++) sprsdsp[k] = touch_real (ntasks, sprsdsp[k], n, size);
+      stroke0 = touch_real (ntasks, stroke0, n, size);
+      for (k = 0; k < 3; k ++) stroke[k] = touch_real (ntasks, stroke[k], n, size);
+      for (k = 0; k < 3; k ++) sprfrc[k] = touch_real (ntasks, sprfrc[k], n, size);
+
+      touched[2] = sprpnt[0][0];
+    }
   }
 
   /* run DEM simulation */
@@ -2316,10 +2876,16 @@ namespace parmec { /* namespace */
   {
     REAL time, dt, step0, step1;
     REAL auxiliary_interval[2];
-    timing tt;
+    long jiters = 0, jsolves = 0, steps = 0;
+    double time0[NPHASE];
+    long count0[NCOUNT];
+    timing tt, st, pt;
+    FILE *trace = NULL;
 
     timerstart (&tt);
 
+    if (domain_rank () > 0) verbose = 0; /* the first rank reports progress */
+
     if ((interval_func || interval_tms) && !interval)
     {
       interval = auxiliary_interval;
@@ -2350,16 +2916,6 @@ namespace parmec { /* namespace */
       output_path = out;
     }
 
-    REAL *icenter[6] = {center[0]+ellcon, center[1]+ellcon, center[2]+ellcon, center[3]+ellcon, center[4]+ellcon, center[5]+ellcon};
-    REAL *iradii[3] = {radii[0]+ellcon, radii[1]+ellcon, radii[2]+ellcon};
-    REAL *iorient[18] = {orient[0]+ellcon, orient[1]+ellcon, orient[2]+ellcon, orient[3]+ellcon, orient[4]+ellcon, orient[5]+ellcon,
-      orient[6]+ellcon, orient[7]+ellcon, orient[8]+ellcon, orient[9]+ellcon, orient[10]+ellcon, orient[11]+ellcon,
-      orient[12]+ellcon, orient[13]+ellcon, orient[14]+ellcon, orient[15]+ellcon, orient[16]+ellcon, orient[17]+ellcon};
-    REAL *itri[3][3] = {{tri[0][0]+tricon, tri[0][1]+tricon, tri[0][2]+tricon},
-      {tri[1][0]+tricon, tri[1][1]+tricon, tri[1][2]+tricon},
-      {tri[2][0]+tricon, tri[2][1]+tricon, tri[2][2]+tricon}};
-    int *ifacnod[3] = {facnod[0]+faccon, facnod[1]+faccon, facnod[2]+faccon};
-
     sort_materials ();
 
     if (springs_changed)
@@ -2383,13 +2939,27 @@ namespace parmec { /* namespace */
       joints_changed = 0;
     }
 
+    domain_create (ntasks); /* distributed runs keep own particles and their ghosts */
+
+    numa_touch (ntasks);
+
+    REAL *icenter[6] = {center[0]+ellcon, center[1]+ellcon, center[2]+ellcon, center[3]+ellcon, center[4]+ellcon, center[5]+ellcon};
+    REAL *iradii[3] = {radii[0]+ellcon, radii[1]+ellcon, radii[2]+ellcon};
+    REAL *iorient[18] = {orient[0]+ellcon, orient[1]+ellcon, orient[2]+ellcon, orient[3]+ellcon, orient[4]+ellcon, orient[5]+ellcon,
+      orient[6]+ellcon, orient[7]+ellcon, orient[8]+ellcon, orient[9]+ellcon, orient[10]+ellcon, orient[11]+ellcon,
+      orient[12]+ellcon, orient[13]+ellcon, orient[14]+ellcon, orient[15]+ellcon, orient[16]+ellcon, orient[17]+ellcon};
+    REAL *itri[3][3] = {{tri[0][0]+tricon, tri[0][1]+tricon, tri[0][2]+tricon},
+      {tri[1][0]+tricon, tri[1][1]+tricon, tri[1][2]+tricon},
+      {tri[2][0]+tricon, tri[2][1]+tricon, tri[2][2]+tricon}};
+    int *ifacnod[3] = {facnod[0]+faccon, facnod[1]+faccon, facnod[2]+faccon};
+
     if (curtime == 0.0)
     {
       step0 = step;
 
       if (interval)
       {
-        output_files ();
+        domain_output ();
 
         output_history ();
       }
@@ -2399,9 +2969,9 @@ namespace parmec { /* namespace */
       shapes (ntasks, ellnum, part, center, radii, orient, nodnum, nodes,
           nodpart, NULL, facnum, facnod, factri, tri, rotation, position);
 
-      obstaclev (obsnum, obsang, obslin, anghis, linhis, 0.5*step0);
+      obstaclev (obsnum, obsang, obslin, anghis, linhis, angtms, lintms, 0.5*step0);
 
-      obstacles (obsnum, trirng, obspnt, obsang, obslin, tri, step0);
+      obstacles (ntasks, obsnum, trirng, obspnt, obsang, obslin, tri, step0);
     }
     else
     {
@@ -2410,56 +2980,180 @@ namespace parmec { /* namespace */
 
     invert_inertia (ntasks, parnum, inertia, inverse, mass, invm);
 
+    schedule *sched[NSCHED]; /* task spans balanced across time steps */
+
+    for (int k = 0; k < NSCHED; k ++) sched[k] = schedule_create (ntasks);
+
+    int *mrlev = NULL, mrlmax = 0;
+    REAL *mrbuf[18];
+
+    if (mrmax > 0 && sprnum > 0)
+    {
+      mrlev = new int[parnum];
+
+      mrlmax = multirate_levels (ntasks, step0, mrlev);
+
+      if (mrlmax > 0)
+      {
+        for (int k = 0; k < 18; k ++)
+        {
+          mrbuf[k] = new REAL[parnum];
+          memset (mrbuf[k], 0, parnum * sizeof (REAL));
+        }
+
+        if (verbose)
+        {
+          int n = 0;
+          for (int i = 0; i < parnum; i ++) n += mrlev[i] > 0;
+          printf ("Multi-rate stepping: %d particles sub-cycled up to %d times per step\n", n, 1 << mrlmax);
+        }
+      }
+      else
+      {
+        delete [] mrlev;
+        mrlev = NULL;
+      }
+    }
+
     restrain_velocities (ntasks, rstnum, rstpart, rstlin, rstang, linear, angular, rotation);
 
     partitioning *tree = partitioning_create (ntasks, ellnum-ellcon, icenter);
 
+    obstacle_tree *obstree = obstacle_tree_create (trinum-tricon, triobs+tricon, itri);
+
+    if (trace_path && domain_rank () == 0)
+    {
+      ASSERT (trace = fopen (trace_path, "a"), "Trace file open failed");
+    }
+
     /* time stepping */
     for (time = 0.0; time < duration; time += 0.5*(step0+step1), curtime += 0.5*(step0+step1), step0 = step1)
     {
+      int64_t perf[NPERF] = {0};
+
+      if (trace)
+      {
+        memcpy (time0, phase_time, sizeof (time0));
+        memcpy (count0, count_total, sizeof (count0));
+      }
+
+      timerstart (&st);
+      timerstart (&pt);
+
+      if (domain_size () > 1) /* particles migrate between ranks and are renumbered */
+      {
+        if (domain_balance (ntasks, reorder && steps % reorder == 0))
+        {
+          for (int k = 0; k < 6; k ++) icenter[k] = center[k]+ellcon;
+          for (int k = 0; k < 3; k ++) iradii[k] = radii[k]+ellcon;
+          for (int k = 0; k < 18; k ++) iorient[k] = orient[k]+ellcon;
+
+          partitioning_destroy (tree);
+
+          tree = partitioning_create (ntasks, ellnum-ellcon, icenter);
+        }
+
+        phase_time[PHASE_DOMAIN] += timerlap (&pt);
+      }
+      else if (reorder && steps % reorder == 0)
+      {
+        morton_particles (ntasks, mrlev);
+
+        phase_time[PHASE_REORDER] += timerlap (&pt);
+      }
+
       if (partitioning_store (ntasks, tree, ellnum-ellcon, ellcol+ellcon, part+ellcon, icenter, iradii, iorient) > 0)
       {
+        phase_time[PHASE_STORE] += timerlap (&pt);
+
         partitioning_destroy (tree);
 
         tree = partitioning_create (ntasks, ellnum-ellcon, icenter);
 
+        phase_time[PHASE_CREATE] += timerlap (&pt);
+
         ASSERT (partitioning_store (ntasks, tree, ellnum-ellcon, ellcol+ellcon, part+ellcon, icenter, iradii, iorient) == 0, "Repartitioning failed");
+
+        count_total[COUNT_REPART] ++;
       }
 
+      phase_time[PHASE_STORE] += timerlap (&pt);
+
       condet (ntasks, tree, master, parnum, ellnum-ellcon, ellcol+ellcon, part+ellcon,
-          icenter, iradii, iorient, trinum-tricon, tricol+tricon, triobs+tricon, itri);
+          icenter, iradii, iorient, trinum-tricon, tricol+tricon, triobs+tricon, itri, obstree);
+
+      phase_time[PHASE_CONDET] += timerlap (&pt);
 
       read_gravity_and_damping (curtime, tms, gravfunc, gravtms, gravity, lindamp, lindamptms, angdamp, angdamptms, damping);
 
+      phase_time[PHASE_CALLBACKS] += timerlap (&pt);
+
       forces (ntasks, master, slave, parnum, angular, linear, rotation, position, inertia, inverse, mass, invm, obspnt, obslin,
-          obsang, parmat, mparam, pairnum, pairs, ikind, iparam, step0, sprnum, sprtype, unspring, sprmap, sprpart, sprpnt,
+          obsang, parmat, mparam, pairnum, pairs, ikind, iparam, step0, mrlev ? 0 : domain_springs (), sprtype, unspring, sprmap, sprpart, sprpnt,
           spring, spridx, dashpot, dashidx, unload, unidx, yield, sprdir, sprflg, sproffset, sprfric, sprkskn, sprsdsp, stroke0,
           stroke, sprfrc, lcurve, lcidx, gravity, trqsprnum, trqsprpart, trqzdir0, trqxdir0, krpy, krpyidx, drpy, drpyidx, trqcone,
           trqzdir1, trqxdir1, trqrpy, trqrpytot, trqrpyspr, force, torque, kact, kmax, emax, krot, (adaptive > 0.0 && adaptive <= 1.0),
           unsprnum, tsprings, tspridx, msprings, mspridx, unlim, unent, unop, unabs, nsteps, nfreq, unaction, activate, actidx,
-          stepnum, curtime);
+          stepnum, curtime, perf, sched);
+
+      forces_phases (timerlap (&pt), perf);
 
       prescribe_body_forces (prescribed_body_forces, force, torque);
 
+      if (cplnum)
+      {
+        if (steps % cplevery == 0) couple_exchange (cplnum, cplpart, curtime, cplevery*step0, position,
+          rotation, linear, angular, force, torque, cplouter, cpltimeout);
+
+        couple_forces (cplnum, cplpart, cplouter, force, torque);
+      }
+
+      phase_time[PHASE_CALLBACKS] += timerlap (&pt);
+
       if (adaptive > 0.0 && adaptive <= 1.0)
       {
-        step1 = adaptive_timestep (ntasks, parnum, mass, inertia, kact, kmax, emax, krot, step0, adaptive);
+        step1 = domain_min (adaptive_timestep (ntasks, parnum, mass, inertia, kact, kmax, emax, krot, step0, adaptive));
       }
       else
       {
         step1 = step0;
       }
 
-      solve_joints (jnum, jpart, jpoint, jreac, parnum, position, rotation, inertia,
-          inverse, mass, invm, damping, linear, angular, force, torque, step0, step1);
+      phase_time[PHASE_DYNAMICS] += timerlap (&pt);
+
+      if (mrlev) /* springs are sub-cycled here rather than in forces */
+      {
+        multirate_step (ntasks, mrlev, mrlmax, mrbuf, step0, curtime);
+
+        phase_time[PHASE_MULTIRATE] += timerlap (&pt);
+      }
+
+      if (jnum)
+      {
+        jiters += solve_joints (jnum, jpart, jpoint, jreac, parnum, position, rotation, inertia,
+          inverse, mass, invm, damping, linear, angular, force, torque, step0, step1, jtol);
+        jsolves ++;
+
+        phase_time[PHASE_JOINTS] += timerlap (&pt);
+      }
 
       restrain_forces (ntasks, rstnum, rstpart, rstlin, rstang, force, torque);
 
+      phase_time[PHASE_DYNAMICS] += timerlap (&pt);
+
       prescribe_acceleration (prsnum, tms, prspart, prslin, tmslin, linkind, prsang,
           tmsang, angkind, curtime, mass, inertia, force, torque);
 
+      phase_time[PHASE_CALLBACKS] += timerlap (&pt);
+
       dynamics (ntasks, master, slave, parnum, angular, linear, rotation, position,
-          inertia, inverse, mass, invm, damping, force, torque, flags, step0, step1);
+          inertia, inverse, mass, invm, damping, force, torque, flags, mrlev, step0, step1, sched[SCHED_DYNAMICS]);
+
+      phase_time[PHASE_DYNAMICS] += timerlap (&pt);
+
+      domain_exchange (); /* ghosts follow their owners */
+
+      phase_time[PHASE_DOMAIN] += timerlap (&pt);
 
       prescribe_velocity (prsnum, tms, prspart, prslin, tmslin, linkind, prsang,
           tmsang, angkind, curtime, rotation, linear, angular);
@@ -2482,6 +3176,8 @@ namespace parmec { /* namespace */
         interval[1] = TMS_Value ((TMS*)tms[interval_tms[1]], curtime);
       }
 
+      phase_time[PHASE_CALLBACKS] += timerlap (&pt);
+
       if (interval && curtime >= curtime_output + interval[0]) /* full update, due to output */
       {
         shapes (ntasks, ellnum, part, center, radii, orient,
@@ -2495,15 +3191,39 @@ namespace parmec { /* namespace */
             factri+faccon, tri, rotation, position);
       }
 
-      obstaclev (obsnum, obsang, obslin, anghis, linhis, curtime+step0);
+      phase_time[PHASE_SHAPES] += timerlap (&pt);
+
+      obstaclev (obsnum, obsang, obslin, anghis, linhis, angtms, lintms, curtime+step0);
+
+      phase_time[PHASE_CALLBACKS] += timerlap (&pt);
 
-      obstacles (obsnum, trirng, obspnt, obsang, obslin, tri, 0.5*(step0+step1));
+      obstacles (ntasks, obsnum, trirng, obspnt, obsang, obslin, tri, 0.5*(step0+step1));
+
+      if (obstree && obstree->moving) obstacle_tree_refit (obstree, itri);
+
+      phase_time[PHASE_OBSTACLES] += timerlap (&pt);
 
       if (interval && curtime >= curtime_output + interval[0])
       {
-        output_files ();
+        if (reorder && domain_size () == 1) /* output files use the input order */
+        {
+          restore_particles (mrlev);
+
+          phase_time[PHASE_REORDER] += timerlap (&pt);
+        }
+
+        domain_output ();
 
         curtime_output += interval[0];
+
+        if (reorder && domain_size () == 1)
+        {
+          phase_time[PHASE_OUTPUT] += timerlap (&pt);
+
+          morton_particles (ntasks, mrlev);
+
+          phase_time[PHASE_REORDER] += timerlap (&pt);
+        }
       }
 
       if (interval && curtime >= curtime_history + interval[1])
@@ -2514,10 +3234,35 @@ namespace parmec { /* namespace */
       }
 
       if (verbose) progressbar (2.0*time/(step0+step1), 2.0*duration/(step0+step1));
+
+      phase_time[PHASE_OUTPUT] += timerlap (&pt);
+
+      phase_time[PHASE_TOTAL] += timerend (&st);
+
+      count_total[COUNT_STEPS] ++;
+
+      steps ++;
+
+      if (trace) trace_step (trace, curtime, step0, time0, count0);
     }
 
+    if (trace) fclose (trace);
+
+    if (reorder && domain_size () == 1) restore_particles (mrlev);
+
     partitioning_destroy (tree);
 
+    obstacle_tree_destroy (obstree);
+
+    for (int k = 0; k < NSCHED; k ++) schedule_destroy (sched[k]);
+
+    if (mrlev)
+    {
+      for (int k = 0; k < 18; k ++) delete [] mrbuf[k];
+
+      delete [] mrlev;
+    }
+
     curstep = step1;
 
     stepnum ++;
@@ -2526,6 +3271,10 @@ namespace parmec { /* namespace */
 
     if (verbose) printf("[ ===             %10.3f sec                    === ]\n", dt);
 
+    if (verbose && jtol > 0.0 && jsolves) printf ("Joints solver: %.1f iterations per step on average\n", (double)jiters/(double)jsolves);
+
+    if (verbose > 1) print_timers ();
+
     return dt;
   }
 
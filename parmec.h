@@ -90,6 +90,8 @@ namespace parmec { /* namespace */
   extern REAL *emax; /* time step control --> maximum damper coefficient per particle */
   extern REAL *krot[6]; /* time step control --> symmetric rotational unit stiffness matrix per particle */
   extern int *flags; /* particle flags */
+  extern int *parid; /* particle id --> number returned to user */
+  extern int *parmap; /* map of particle ids to particle indices */
   extern ispc::master_conpnt *master; /* master contact points */
   extern ispc::slave_conpnt *slave; /* slave contact points */
   extern int particle_buffer_size; /* size of the buffer */
@@ -130,6 +132,8 @@ namespace parmec { /* namespace */
   extern REAL *obsang; /* obstacle angular velocities at t and t+h */
   extern pointer_t *linhis; /* linear velocity history */
   extern pointer_t *anghis; /* angular velocity history */
+  extern int *lintms[3]; /* linear velocity time series */
+  extern int *angtms[3]; /* angular velocity time series */
   extern int obstacle_buffer_size; /* size of the buffer */
   extern int obstacle_buffer_grow (); /* grow buffer */
 
@@ -218,9 +222,20 @@ namespace parmec { /* namespace */
   extern REAL *jpoint[3]; /* joint points */
   extern REAL *jreac[3]; /* joint reactions */
   extern int joints_changed; /* joints changed flag */
+  extern REAL jtol; /* joints iterative solver relative tolerance; zero selects the direct solver */
   extern int joints_buffer_size; /* size of joints buffer */
   extern int joints_buffer_grow (); /* grow buffer */
 
+  extern int mrmax; /* maximum multi-rate level of sub-cycled springs; zero disables multi-rate stepping */
+
+  extern int reorder; /* number of time steps between Morton reordering of particles; zero disables reordering */
+
+  extern const char *phase_name[NPHASE]; /* timed phase names */
+  extern const char *count_name[NCOUNT]; /* performance counter names */
+  extern double phase_time[NPHASE]; /* cumulative wall time per phase */
+  extern long count_total[NCOUNT]; /* cumulative performance counters */
+  extern char *trace_path; /* per-step CSV trace of phase times and counters; NULL disables tracing */
+
   extern int tmsnum; /* number of time series */
   extern pointer_t *tms; /* time series */
   extern int time_series_buffer_size; /* size of time series buffer */
@@ -264,6 +279,12 @@ namespace parmec { /* namespace */
   extern int *outent; /* output entities per output mode */
   extern int outrest[2]; /* 0: default output entities for unlisted particles and, 1: default output mode */
   extern int outformat; /* output format */
+  extern int *outroi; /* output region of interest kind */
+  extern REAL *outreg[6]; /* output region of interest: sphere (center, radius) or box (min, max corners) */
+  extern int *outdec[2]; /* output decimation: every n-th frame 0: inside and 1: outside of the region of interest */
+  extern int outrestroi; /* region of interest kind for unlisted particles */
+  extern REAL outrestreg[6]; /* region of interest for unlisted particles */
+  extern int outrestdec[2]; /* output decimation for unlisted particles */
   extern int output_buffer_size; /* size of output buffer */
   extern int output_list_size; /* size of output particle lists buffer */
   extern void output_buffer_grow (int list_size); /* grow buffer */
@@ -289,8 +310,20 @@ namespace parmec { /* namespace */
 
   extern MAP *prescribed_body_forces; /* particle index based map of prescibed body forces */
 
+  extern int cplnum; /* number of particles coupled with an external solver */
+  extern int *cplpart; /* coupled particle numbers indexed by coupling slot */
+  extern REAL *cplouter[6]; /* outer force and torque per coupling slot */
+  extern int cplevery; /* number of time steps between co-simulation exchanges */
+  extern double cpltimeout; /* seconds to wait for the coupled solver */
+
   extern void declare_analytical (int k); /* declare particle 'k' analytical */
 
+  extern void sort_springs (); /* sort springs according to particle indices */
+
+  extern void tidy_contacts (); /* key particle-particle contact points under smaller particle indices */
+
+  extern void reorder_particles (const int *perm, int num, int *level); /* reorder particles and keep the first 'num' */
+
   /**************** library interface ****************/
 
   void init (); /* init memory */
@@ -306,7 +339,7 @@ namespace parmec { /* namespace */
       pointer_t *interval_func, /* optional output interval callbacks (two) */
       int *interval_tms, /* optional output interval TSERIES numbers (two) */
       char *prefix, /* optional output directory prefix */
-      int verbose, /* verbosity flag; 0 disables verbose output */
+      int verbose, /* verbosity flag; 0 disables verbose output, 2 also prints phase timers */
       double adaptive); /* adaptive time stepping ratio; 0.0 disables adaptive time stepping */
 
 #ifdef __cplusplus
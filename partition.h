@@ -37,9 +37,9 @@ struct leaf_data
   uniform int color[LSIZE];
   uniform int part[LSIZE];
   uniform int ell[LSIZE];
-  uniform REAL center[3][LSIZE];
-  uniform REAL radii[3][LSIZE];
-  uniform REAL orient[9][LSIZE];
+  uniform GREAL center[3][LSIZE];
+  uniform GREAL radii[3][LSIZE];
+  uniform GREAL orient[9][LSIZE];
 };
 
 /* partitioning tree */
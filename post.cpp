@@ -0,0 +1,366 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2015 Tomasz Koziara
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+ */
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <omp.h>
+#include <hdf5.h>
+#include <hdf5_hl.h>
+#include <string>
+#include <vector>
+#include "macros.h"
+#include "h5read.h"
+#include "version.h"
+
+using namespace std;
+
+/* post-processing options */
+struct post_options
+{
+  vector<string> datasets; /* selected datasets (all double datasets if empty) */
+  vector<int> items; /* selected dataset rows (all rows if empty) */
+  double box[6]; /* box region: min and max corners */
+  double sphere[4]; /* sphere region: center and radius */
+  enum {REGION_NONE, REGION_BOX, REGION_SPHERE} region; /* region kind */
+  enum {FORMAT_CSV, FORMAT_NPY} format; /* output format */
+  string output; /* output path prefix */
+};
+
+/* per-frame statistics row layout: TIME, then for each dataset COUNT and MEAN, MIN, MAX of each component */
+static int row_size (vector<int> &widths)
+{
+  int size = 1;
+  for (size_t d = 0; d < widths.size(); d ++) size += 1 + 3*widths[d];
+  return size;
+}
+
+/* test whether a point is inside of the region */
+static int inside (post_options &opt, double *p)
+{
+  switch (opt.region)
+  {
+  case post_options::REGION_BOX:
+    return p[0] >= opt.box[0] && p[1] >= opt.box[1] && p[2] >= opt.box[2] &&
+           p[0] <= opt.box[3] && p[1] <= opt.box[4] && p[2] <= opt.box[5];
+  case post_options::REGION_SPHERE:
+    {
+      double q[3] = {p[0]-opt.sphere[0], p[1]-opt.sphere[1], p[2]-opt.sphere[2]};
+      return DOT(q,q) <= opt.sphere[3]*opt.sphere[3];
+    }
+  default:
+    return 1;
+  }
+}
+
+/* calculate statistics of one dataset */
+static double* dataset_statistics (post_options &opt, double *values, int size, int width, double *geom, int geomsize, double *row)
+{
+  double *count = row ++, *mean = row, *min = row + width, *max = row + 2*width;
+  int i, j, n, k;
+
+  ASSERT (opt.region == post_options::REGION_NONE || (geom && geomsize == size),
+    "Region based selection requires GEOM and dataset row numbers to match");
+
+  for (j = 0; j < width; j ++)
+  {
+    mean[j] = 0.0;
+    min[j] = REAL_MAX;
+    max[j] = -REAL_MAX;
+  }
+
+  n = opt.items.empty() ? size : opt.items.size();
+
+  for (*count = 0.0, k = 0; k < n; k ++)
+  {
+    i = opt.items.empty() ? k : opt.items[k];
+
+    if (i < 0 || i >= size) continue;
+
+    if (opt.region != post_options::REGION_NONE && !inside (opt, &geom[3*i])) continue;
+
+    for (j = 0; j < width; j ++)
+    {
+      double v = values[width*i+j];
+      mean[j] += v;
+      if (v < min[j]) min[j] = v;
+      if (v > max[j]) max[j] = v;
+    }
+
+    *count += 1.0;
+  }
+
+  for (j = 0; j < width; j ++)
+  {
+    if (*count > 0.0) mean[j] /= *count;
+    else mean[j] = min[j] = max[j] = 0.0;
+  }
+
+  return row + 3*width;
+}
+
+/* list floating point datasets of a frame; single precision ones are converted on read */
+static void list_datasets (hid_t h5_step, vector<string> &datasets)
+{
+  hsize_t cur, num;
+  char buf[128];
+
+  H5Gget_num_objs (h5_step, &num);
+  for (cur = 0; cur < num; cur ++)
+  {
+    H5Gget_objname_by_idx (h5_step, cur, buf, 128);
+    if (H5Gget_objtype_by_idx (h5_step, cur) != H5G_DATASET) continue;
+    hsize_t dims[2] = {0, 1};
+    H5T_class_t class_id;
+    size_t type_size;
+    H5LTget_dataset_info (h5_step, buf, dims, &class_id, &type_size);
+    if (class_id == H5T_FLOAT) datasets.push_back (buf);
+  }
+}
+
+/* column names matching the row layout */
+static void column_names (vector<string> &datasets, vector<int> &widths, vector<string> &names)
+{
+  const char *stat[3] = {"MEAN", "MIN", "MAX"};
+  char buf[256];
+
+  names.push_back ("TIME");
+
+  for (size_t d = 0; d < datasets.size(); d ++)
+  {
+    names.push_back (datasets[d] + "_COUNT");
+
+    for (int s = 0; s < 3; s ++)
+    {
+      for (int j = 0; j < widths[d]; j ++)
+      {
+        if (widths[d] == 1) snprintf (buf, 256, "%s_%s", datasets[d].c_str(), stat[s]);
+        else snprintf (buf, 256, "%s%d_%s", datasets[d].c_str(), j, stat[s]);
+        names.push_back (buf);
+      }
+    }
+  }
+}
+
+/* write .csv table */
+static void write_csv (const char *path, vector<string> &names, int nrows, double *table)
+{
+  FILE *out;
+  int i, j, ncols = names.size();
+
+  ASSERT (out = fopen (path, "w"), "Opening %s for writing has failed", path);
+
+  for (j = 0; j < ncols; j ++) fprintf (out, "%s%s", names[j].c_str(), j < ncols-1 ? "," : "\n");
+
+  for (i = 0; i < nrows; i ++)
+  {
+    for (j = 0; j < ncols; j ++) fprintf (out, "%.15e%s", table[i*ncols+j], j < ncols-1 ? "," : "\n");
+  }
+
+  fclose (out);
+}
+
+/* write .npy table (NPY format version 1.0) and a text file with column names */
+static void write_npy (const char *path, vector<string> &names, int nrows, double *table)
+{
+  int ncols = names.size();
+  char header[256];
+  FILE *out;
+
+  int len = snprintf (header, 256, "{'descr': '<f8', 'fortran_order': False, 'shape': (%d, %d), }", nrows, ncols);
+  while ((10 + len + 1) % 64) header[len ++] = ' '; /* pad to 64 byte alignment */
+  header[len ++] = '\n';
+
+  ASSERT (out = fopen (path, "wb"), "Opening %s for writing has failed", path);
+  fwrite ("\x93NUMPY\x01\x00", 1, 8, out);
+  unsigned char hlen[2] = {(unsigned char)(len & 0xff), (unsigned char)(len >> 8)};
+  fwrite (hlen, 1, 2, out);
+  fwrite (header, 1, len, out);
+  fwrite (table, sizeof(double), (size_t)nrows*ncols, out); /* assumes little endian host */
+  fclose (out);
+
+  string txt = string(path) + ".txt";
+  ASSERT (out = fopen (txt.c_str(), "w"), "Opening %s for writing has failed", txt.c_str());
+  for (int j = 0; j < ncols; j ++) fprintf (out, "%s\n", names[j].c_str());
+  fclose (out);
+}
+
+/* parse comma separated integer list */
+static void parse_items (char *str, vector<int> &items)
+{
+  for (char *tok = strtok (str, ","); tok; tok = strtok (NULL, ","))
+  {
+    items.push_back (atoi(tok));
+  }
+}
+
+int main (int argc, char *argv[])
+{
+  post_options opt;
+  char *path = NULL;
+  int i;
+
+  opt.region = post_options::REGION_NONE;
+  opt.format = post_options::FORMAT_CSV;
+
+  if (argc == 1)
+  {
+    printf ("VERSION: %s %s\n", VERSION_DATE, VERSION_HASH);
+    printf ("SYNOPSIS: parmec-post [-ntasks n] [-format csv|npy] [-output prefix] [-items i,j,...]\n");
+    printf ("                      [-box x0 y0 z0 x1 y1 z1 | -sphere x y z r] path/to/file.h5 [DATASET ...]\n");
+    printf ("         -ntasks n: number of threads (default: hardware supported maximum)\n");
+    printf ("         -format: output table format (default: csv)\n");
+    printf ("         -output prefix: output path prefix (default: path/to/file_post)\n");
+    printf ("         -items: selected dataset rows, e.g. particle numbers in a *rb.h5 file (default: all)\n");
+    printf ("         -box, -sphere: select rows whose GEOM point is inside of a region (default: all)\n");
+    printf ("         DATASET: selected datasets, e.g. LINVEL FORCE (default: all double precision datasets)\n");
+    printf ("OUTPUT: one row per frame with TIME and, for each dataset, COUNT and component MEAN, MIN, MAX;\n");
+    printf ("        time histories follow from -items with a single row, spatial averages from -box or -sphere\n");
+    return 1;
+  }
+
+  for (i = 1; i < argc; i ++)
+  {
+    if (strcmp (argv[i], "-ntasks") == 0 && i+1 < argc)
+    {
+      omp_set_num_threads (atoi (argv[++i]));
+    }
+    else if (strcmp (argv[i], "-format") == 0 && i+1 < argc)
+    {
+      i ++;
+      if (strcmp (argv[i], "csv") == 0) opt.format = post_options::FORMAT_CSV;
+      else if (strcmp (argv[i], "npy") == 0) opt.format = post_options::FORMAT_NPY;
+      else ASSERT (0, "Invalid output format: %s", argv[i]);
+    }
+    else if (strcmp (argv[i], "-output") == 0 && i+1 < argc)
+    {
+      opt.output = argv[++i];
+    }
+    else if (strcmp (argv[i], "-items") == 0 && i+1 < argc)
+    {
+      parse_items (argv[++i], opt.items);
+    }
+    else if (strcmp (argv[i], "-box") == 0 && i+6 < argc)
+    {
+      for (int j = 0; j < 6; j ++) opt.box[j] = atof (argv[++i]);
+      opt.region = post_options::REGION_BOX;
+    }
+    else if (strcmp (argv[i], "-sphere") == 0 && i+4 < argc)
+    {
+      for (int j = 0; j < 4; j ++) opt.sphere[j] = atof (argv[++i]);
+      opt.region = post_options::REGION_SPHERE;
+    }
+    else if (!path)
+    {
+      path = argv[i];
+    }
+    else
+    {
+      opt.datasets.push_back (argv[i]);
+    }
+  }
+
+  ASSERT (path, "Input .h5 file path is missing");
+
+  string h5path = path, base;
+  size_t len = h5path.length();
+  if (len > 4 && h5path.compare (len-4, 4, ".xmf") == 0) h5path.replace (len-4, 4, ".h5"); /* .xmf refers to a matching .h5 file */
+  len = h5path.length();
+  base = len > 3 && h5path.compare (len-3, 3, ".h5") == 0 ? h5path.substr (0, len-3) : h5path;
+  if (opt.output.empty()) opt.output = base + "_post";
+
+  hid_t h5_file, h5_step;
+  hsize_t nframes;
+
+  ASSERT ((h5_file = H5Fopen(h5path.c_str(), H5F_ACC_RDONLY, H5P_DEFAULT)) >= 0, "HDF5 file open error");
+  H5Gget_num_objs (h5_file, &nframes);
+  ASSERT (nframes > 0, "HDF5 file %s has no output frames", h5path.c_str());
+
+  ASSERT ((h5_step = H5Gopen (h5_file, "/0", H5P_DEFAULT)) >= 0, "HDF5 file read error");
+  if (opt.datasets.empty()) list_datasets (h5_step, opt.datasets);
+  vector<int> widths;
+  for (size_t d = 0; d < opt.datasets.size(); d ++)
+  {
+    int size, width;
+    double *values = h5read (h5_step, opt.datasets[d].c_str(), &size, &width);
+    ASSERT (values, "HDF5 file read error: %s dataset missing", opt.datasets[d].c_str());
+    widths.push_back (width);
+    free (values);
+  }
+  H5Gclose (h5_step);
+
+  vector<string> names;
+  column_names (opt.datasets, widths, names);
+  int ncols = row_size (widths);
+  ASSERT (ncols == (int)names.size(), "Inconsistent column layout");
+
+  double *table;
+  ERRMEM (table = (double*)malloc (sizeof(double)*nframes*ncols));
+
+  /* HDF5 reads are serialised, while statistics of different frames are computed concurrently */
+  #pragma omp parallel for schedule(dynamic)
+  for (int n = 0; n < (int)nframes; n ++)
+  {
+    vector<double*> values (opt.datasets.size());
+    vector<int> sizes (opt.datasets.size());
+    double *geom = NULL, *row = &table[n*ncols];
+    int geomsize = 0;
+
+    #pragma omp critical (hdf5)
+    {
+      char buf[1024];
+      snprintf (buf, 1024, "/%d", n);
+      hid_t step;
+      ASSERT ((step = H5Gopen (h5_file, buf, H5P_DEFAULT)) >= 0, "HDF5 file read error");
+      ASSERT (H5LTget_attribute_double (step, ".", "TIME", row) >= 0, "HDF5 file read error");
+      if (opt.region != post_options::REGION_NONE) geom = h5read (step, "GEOM", &geomsize);
+      for (size_t d = 0; d < opt.datasets.size(); d ++)
+      {
+        values[d] = h5read (step, opt.datasets[d].c_str(), &sizes[d]);
+      }
+      H5Gclose (step);
+    }
+
+    row ++;
+
+    for (size_t d = 0; d < opt.datasets.size(); d ++)
+    {
+      ASSERT (values[d], "HDF5 file read error: %s dataset missing in frame %d", opt.datasets[d].c_str(), n);
+      row = dataset_statistics (opt, values[d], sizes[d], widths[d], geom, geomsize, row);
+      free (values[d]);
+    }
+
+    free (geom);
+  }
+
+  H5Fclose (h5_file);
+
+  if (opt.format == post_options::FORMAT_NPY) write_npy ((opt.output + ".npy").c_str(), names, nframes, table);
+  else write_csv ((opt.output + ".csv").c_str(), names, nframes, table);
+
+  free (table);
+
+  return 0;
+}
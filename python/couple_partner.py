@@ -0,0 +1,70 @@
+# PARMEC co-simulation partner
+#
+# Stand-in coupled solver for COUPLE (particles, path): maps the channel file,
+# answers every exchange with outer forces and exits when PARMEC closes the channel
+#   python3 python/couple_partner.py /dev/shm/parmec.cpl [--drag c] [--force fx fy fz]
+# the outer force is -c*v + (fx, fy, fz) and the outer torque is -c*omega, which
+# mimics a viscous fluid; start it before or after parmec (it waits for the file)
+#
+# channel layout (native byte order, see couple.h):
+#   header: int64 magic, count, sent, received, float64 time, step, int64 unused[2]
+#   arrays: 31 float64 arrays of count items: id, position[3], rotation[9],
+#           linear[3], angular[3], inner force and torque[6], outer force and torque[6]
+
+import os, sys, time, mmap, struct, argparse
+
+MAGIC = 0x434D524150
+HEADER = struct.Struct ('=qqqqddqq')
+POSITION, ROTATION, LINEAR, ANGULAR, INNER, OUTER, ARRAYS = 1, 4, 13, 16, 19, 25, 31
+
+def attach (path, timeout):
+  '''wait for the channel file and its magic number; return (mmap, count)'''
+  start = time.time()
+  while True:
+    try:
+      fd = os.open (path, os.O_RDWR)
+      size = os.fstat (fd).st_size
+      if size >= HEADER.size:
+        mem = mmap.mmap (fd, size)
+        os.close (fd)
+        while time.time() - start < timeout:
+          head = HEADER.unpack_from (mem, 0)
+          if head[0] == MAGIC and size >= HEADER.size + 8*ARRAYS*head[1]: return mem, head[1]
+          time.sleep (0.001)
+        break
+      os.close (fd)
+    except OSError: pass
+    if time.time() - start > timeout: break
+    time.sleep (0.01)
+  sys.exit ('couple_partner: no channel at %s' % path)
+
+if __name__ == '__main__':
+  parser = argparse.ArgumentParser (description='PARMEC co-simulation partner')
+  parser.add_argument ('path', help='channel file passed to COUPLE')
+  parser.add_argument ('--drag', type=float, default=0.0, help='viscous drag coefficient')
+  parser.add_argument ('--force', nargs=3, type=float, default=[0.0, 0.0, 0.0], help='constant outer force')
+  parser.add_argument ('--timeout', type=float, default=60.0, help='seconds to wait for parmec')
+  args = parser.parse_args()
+
+  mem, count = attach (args.path, args.timeout)
+  data = memoryview (mem)[HEADER.size:HEADER.size+8*ARRAYS*count].cast ('d')
+  array = lambda k: k*count
+  exchanges = 0
+
+  while True:
+    head = HEADER.unpack_from (mem, 0)
+    sent, received = head[2], head[3]
+    if sent < 0: break
+    if sent <= received:
+      time.sleep (0) # yield
+      continue
+    for i in range (count):
+      for k in range (3):
+        data[array(OUTER+k)+i] = -args.drag*data[array(LINEAR+k)+i] + args.force[k]
+        data[array(OUTER+3+k)+i] = -args.drag*data[array(ANGULAR+k)+i]
+    struct.pack_into ('=q', mem, 24, sent) # received = sent
+    exchanges += 1
+
+  print ('couple_partner: %d exchanges' % exchanges)
+  data.release()
+  mem.close()
@@ -0,0 +1,42 @@
+# PARMEC distributed memory regression: compare a single process and an MPI run
+#   python3 python/mpi_compare.py ./parmec8 [input.py ...] [--np 2] [--tol 1E-6]
+# each input is run once directly and once as 'mpirun -np N' with an output file
+# argument (see tests/mpi.py); the MPI run is repeated with PARMEC_SHM=0, so that
+# ghosts shared through node-local memory and sent in messages are both covered;
+# the executable must be built with MPI=yes (see Config.mak); the largest relative
+# difference of the written histories is reported and the exit status is non-zero
+# when it exceeds --tol
+
+import os, sys, subprocess, argparse, tempfile
+from precision_compare import compare
+
+def run (cmd, path, out, ntasks, shm = True):
+  env = dict (os.environ, PARMEC_SHM = '1' if shm else '0')
+  subprocess.check_call (cmd + ['-ntasks', str(ntasks), path, out], stdout=subprocess.DEVNULL, env=env)
+  with open (out) as f:
+    return [[float(x) for x in line.split()] for line in f if line.strip()]
+
+if __name__ == '__main__':
+  parser = argparse.ArgumentParser (description='PARMEC distributed memory regression')
+  parser.add_argument ('executable', help='parmec executable built with MPI=yes')
+  parser.add_argument ('inputs', nargs='*', default=['tests/mpi.py'], help='input files')
+  parser.add_argument ('--np', type=int, default=2, help='number of MPI ranks')
+  parser.add_argument ('--mpirun', default='mpirun', help='MPI launcher')
+  parser.add_argument ('--tol', type=float, default=1E-6, help='relative difference tolerance')
+  parser.add_argument ('--ntasks', type=int, default=1, help='number of tasks per rank')
+  args = parser.parse_args()
+
+  failed = 0
+  tmp = tempfile.mkdtemp()
+  for path in args.inputs:
+    name = os.path.splitext(os.path.basename(path))[0]
+    a = run ([args.executable], path, os.path.join(tmp, name + '_one.txt'), args.ntasks)
+    for shm in (True, False):
+      mode = 'shared memory' if shm else 'messages'
+      b = run ([args.mpirun, '-np', str(args.np), args.executable], path, os.path.join(tmp, name + '_mpi.txt'), args.ntasks, shm)
+      diff = compare (a, b)
+      status = 'ok' if diff <= args.tol else 'FAILED'
+      if diff > args.tol: failed += 1
+      print ('%s: %d ranks (%s), max relative difference %g ... %s' % (path, args.np, mode, diff, status))
+
+  sys.exit (1 if failed else 0)
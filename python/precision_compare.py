@@ -0,0 +1,45 @@
+# PARMEC precision regression: compare histories of two builds
+#   python3 python/precision_compare.py ./parmec8 ./parmec48 [input.py ...]
+# each input is run by both executables with an output file argument (see
+# tests/mixed_precision.py); the largest relative difference of the written
+# histories is reported and the exit status is non-zero when it exceeds --tol
+
+import os, sys, subprocess, argparse, tempfile
+
+def run (exe, path, out, ntasks):
+  subprocess.check_call ([exe, '-ntasks', str(ntasks), path, out], stdout=subprocess.DEVNULL)
+  with open (out) as f:
+    return [[float(x) for x in line.split()] for line in f if line.strip()]
+
+def compare (a, b):
+  '''largest difference relative to the magnitude of each history column'''
+  if len(a) != len(b): return float('inf')
+  diff = 0.0
+  for col in range (len(a[0]) if a else 0):
+    x = [r[col] for r in a]
+    y = [r[col] for r in b]
+    scale = max([abs(z) for z in x] + [1E-30])
+    diff = max([diff] + [abs(p-q)/scale for p, q in zip(x, y)])
+  return diff
+
+if __name__ == '__main__':
+  parser = argparse.ArgumentParser (description='PARMEC precision regression')
+  parser.add_argument ('reference', help='reference (double precision) executable')
+  parser.add_argument ('candidate', help='compared (e.g. mixed precision) executable')
+  parser.add_argument ('inputs', nargs='*', default=['tests/mixed_precision.py'], help='input files')
+  parser.add_argument ('--tol', type=float, default=1E-3, help='relative difference tolerance')
+  parser.add_argument ('--ntasks', type=int, default=1, help='number of tasks')
+  args = parser.parse_args()
+
+  failed = 0
+  tmp = tempfile.mkdtemp()
+  for path in args.inputs:
+    name = os.path.splitext(os.path.basename(path))[0]
+    a = run (args.reference, path, os.path.join(tmp, name + '_ref.txt'), args.ntasks)
+    b = run (args.candidate, path, os.path.join(tmp, name + '_cnd.txt'), args.ntasks)
+    diff = compare (a, b)
+    status = 'ok' if diff <= args.tol else 'FAILED'
+    if diff > args.tol: failed += 1
+    print ('%s: max relative difference %g ... %s' % (path, diff, status))
+
+  sys.exit (1 if failed else 0)
@@ -0,0 +1,89 @@
+# PARMEC streaming output reader
+#
+# Consumes frames written by OUTPUT (format = 'STREAM', stream = path):
+#   python3 python/stream_reader.py /tmp/run.sock        # Unix domain socket (created here)
+#   python3 python/stream_reader.py --fifo /tmp/run.fifo # named pipe (created here)
+# start the reader before parmec and wait for the path to appear (the socket
+# is listening by then); each frame is summarised on one line;
+# with --max-speed and --pid the reader kills a run whose particles exceed the speed
+#
+# frame layout (native byte order):
+#   header: 'PMST', int32 version, int32 frame, int32 number of fields, float64 time
+#   field:  char[16] name, int32 count, int32 width, float64 values[count*width]
+#   fields: NUMBER, GEOM, optional DISPL, LINVEL, ANGVEL, FORCE, TORQUE, ORIENT
+#           of the output particles and HISTORY holding the latest HISTORY samples
+
+import os, sys, struct, socket, signal, argparse, array, math
+
+HEADER = struct.Struct ('=4siiid')
+FIELD = struct.Struct ('=16sii')
+
+def read_exact (stream, size):
+  data = b''
+  while len(data) < size:
+    chunk = stream.read (size - len(data))
+    if not chunk: return None
+    data += chunk
+  return data
+
+def read_frame (stream):
+  '''return (frame, time, {name: (count, width, values)}) or None at the end of the stream'''
+  head = read_exact (stream, HEADER.size)
+  if head is None: return None
+  magic, version, frame, nfields, time = HEADER.unpack (head)
+  if magic != b'PMST' or version != 1:
+    raise ValueError ('not a PARMEC stream frame')
+  fields = {}
+  for i in range (nfields):
+    name, count, width = FIELD.unpack (read_exact (stream, FIELD.size))
+    values = array.array ('d')
+    values.frombytes (read_exact (stream, 8*count*width))
+    fields[name.rstrip(b'\0').decode()] = (count, width, values)
+  return (frame, time, fields)
+
+def max_norm (count, width, values):
+  return max([math.sqrt(sum(values[i*width+j]**2 for j in range(width))) for i in range(count)] or [0.0])
+
+if __name__ == '__main__':
+  parser = argparse.ArgumentParser (description='PARMEC streaming output reader')
+  parser.add_argument ('path', help='socket or named pipe path')
+  parser.add_argument ('--fifo', action='store_true', help='create a named pipe instead of a socket')
+  parser.add_argument ('--max-speed', type=float, help='abort threshold of particle linear speed')
+  parser.add_argument ('--pid', type=int, help='process to terminate when the threshold is exceeded')
+  args = parser.parse_args()
+
+  if os.path.exists (args.path): os.unlink (args.path)
+
+  if args.fifo:
+    os.mkfifo (args.path)
+    stream = open (args.path, 'rb')
+  else:
+    server = socket.socket (socket.AF_UNIX, socket.SOCK_STREAM)
+    temp = '%s.%d' % (args.path, os.getpid())
+    if os.path.exists (temp): os.unlink (temp)
+    server.bind (temp)
+    server.listen (1)
+    os.rename (temp, args.path) # the path appears only once connections are accepted
+    connection, address = server.accept()
+    stream = connection.makefile ('rb')
+
+  while True:
+    frame = read_frame (stream)
+    if frame is None: break
+    number, time, fields = frame
+    line = 'frame %d, time %g, particles %d' % (number, time, fields['NUMBER'][0])
+    if 'LINVEL' in fields:
+      speed = max_norm (*fields['LINVEL'])
+      line += ', max speed %g' % speed
+      if args.max_speed is not None and speed > args.max_speed:
+        print (line)
+        print ('speed threshold %g exceeded' % args.max_speed)
+        if args.pid: os.kill (args.pid, signal.SIGTERM)
+        break
+    if 'HISTORY' in fields:
+      line += ', history ' + ' '.join('%g' % x for x in fields['HISTORY'][2])
+    print (line)
+    sys.stdout.flush()
+
+  stream.close()
+  os.unlink (args.path)
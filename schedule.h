@@ -0,0 +1,105 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2015 Tomasz Koziara
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+ */
+
+#ifndef __schedule__
+#define __schedule__
+
+/* task spans balanced by the clock ticks measured in the previous launch */
+struct schedule
+{
+  uniform int ntasks; /* number of spans */
+  uniform int size; /* number of scheduled items */
+  uniform int * uniform bounds; /* items bounds[i] ... bounds[i+1]-1 belong to task i */
+  uniform int * uniform work; /* balancing work space */
+  uniform int64 * uniform ticks; /* clock ticks measured per task */
+};
+
+/* reset to equal spans when the number of items changes; the schedule is launched with s->ntasks tasks */
+static inline void schedule_prepare (uniform schedule * uniform s, uniform int n)
+{
+  if (s->size != n)
+  {
+    for (uniform int i = 0; i <= s->ntasks; i ++) s->bounds[i] = (uniform int) (((uniform int64)n * i) / s->ntasks);
+
+    s->size = n;
+  }
+
+  for (uniform int i = 0; i < s->ntasks; i ++) s->ticks[i] = 0;
+}
+
+/* items span of a task; equal spans are used without a schedule */
+static inline void schedule_span (uniform schedule * uniform s, uniform int span, uniform int n,
+  uniform int index, uniform int count, uniform int * uniform start, uniform int * uniform end)
+{
+  if (s)
+  {
+    *start = s->bounds[index];
+    *end = s->bounds[index+1];
+  }
+  else
+  {
+    *start = index*span;
+    *end = index == count-1 ? n : *start+span;
+  }
+}
+
+/* move span bounds so that each task gets an equal share of the measured ticks; the cost
+ * per item is assumed constant within each previous span and the new bounds are averaged
+ * with the previous ones to damp the timing noise */
+static inline void schedule_balance (uniform schedule * uniform s)
+{
+  uniform int ntasks = s->ntasks, k = 0;
+  uniform int * uniform b = s->bounds;
+  uniform int64 * uniform t = s->ticks;
+  uniform double total = 0.0, acc = 0.0;
+
+  for (uniform int i = 0; i < ntasks; i ++) total += (uniform double) t[i];
+
+  if (ntasks < 2 || total <= 0.0) return;
+
+  s->work[0] = 0;
+  s->work[ntasks] = s->size;
+
+  for (uniform int j = 1; j < ntasks; j ++)
+  {
+    uniform double target = total * (uniform double) j / (uniform double) ntasks;
+
+    while (k < ntasks-1 && acc + (uniform double) t[k] < target)
+    {
+      acc += (uniform double) t[k];
+      k ++;
+    }
+
+    uniform double frac = t[k] > 0 ? (target - acc) / (uniform double) t[k] : 0.0;
+    if (frac < 0.0) frac = 0.0;
+    else if (frac > 1.0) frac = 1.0;
+    uniform int x = b[k] + (uniform int) (frac * (uniform double) (b[k+1]-b[k]));
+
+    s->work[j] = min (max ((b[j] + x) / 2, s->work[j-1]), s->size);
+  }
+
+  for (uniform int i = 1; i < ntasks; i ++) b[i] = s->work[i];
+}
+
+#endif
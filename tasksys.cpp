@@ -164,6 +164,11 @@ using namespace Concurrency;
 #endif // ISPC_USE_TBB
 #ifdef ISPC_USE_OMP
 #include <omp.h>
+#include <stdlib.h>
+#include <vector>
+#ifdef ISPC_IS_LINUX
+#include <sched.h>
+#endif // ISPC_IS_LINUX
 #endif // ISPC_USE_OMP
 #ifdef ISPC_USE_HPX
 #include <hpx/include/async.hpp>
@@ -979,9 +984,45 @@ TaskGroup::Sync() {
 
 #ifdef ISPC_USE_OMP
 
+// With PARMEC_PIN=1 in the environment thread i is pinned to the i-th CPU
+// allowed for the process and tasks are statically scheduled, so that task i
+// of every launch runs on the same core; buffers first touched along equal task
+// spans (see parmec.cpp:numa_touch) then stay local to the socket that uses them
+// as long as the balanced kernel spans remain close to the equal ones; this is
+// done once, since afterwards the calling thread is itself pinned to one CPU and
+// querying its affinity again would pin every thread to that CPU
+static volatile int32_t ompPinned = 0;
+
 static void
 InitTaskSystem() {
-  // No initialization needed
+  if (lAtomicCompareAndSwap32(&ompPinned, 1, 0) != 0)
+    return;
+
+  const char *pin = getenv("PARMEC_PIN");
+
+  if (pin == NULL || atoi(pin) == 0) return;
+
+  omp_set_schedule(omp_sched_static, 0);
+
+#ifdef ISPC_IS_LINUX
+  cpu_set_t allowed;
+  std::vector<int> cpus;
+
+  if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) return;
+
+  for (int i = 0; i < CPU_SETSIZE; i++) 
+    if (CPU_ISSET(i, &allowed)) cpus.push_back(i);
+
+  if (cpus.empty()) return;
+
+#pragma omp parallel
+  {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpus[omp_get_thread_num() % cpus.size()], &set);
+    sched_setaffinity(0, sizeof(set), &set); // calling thread only
+  }
+#endif // ISPC_IS_LINUX
 }
 
 inline void
@@ -0,0 +1,45 @@
+# PARMEC test --> BALL_JOINT command test with the iterative joints solver
+#                 chains are tied together at their free ends so that all
+#                 joints form a single, large, connected joint set
+
+nedge  = 10
+nchain = 10
+
+matnum = MATERIAL (1E3, 1E9, 0.25)
+
+prevpar = -1
+toppar = {}
+
+for x in range (0, nchain*nedge, nchain):
+  for y in range (0, nchain*nedge, nchain):
+    for i in range (0, nchain):
+      nodes = [x+i, y+i, i,
+               x+i+1, y+i, i,
+               x+i+1, y+i+1, i,
+               x+i, y+i+1, i,
+               x+i, y+i, i+1,
+               x+i+1, y+i, i+1,
+               x+i+1, y+i+1, i+1,
+               x+i, y+i+1, i+1]
+
+      elements = [8, 0, 1, 2, 3, 4, 5, 6, 7, matnum]
+
+      colors = [1, 4, 0, 1, 2, 3, 2, 4, 4, 5, 6, 7, 3]
+
+      parnum = MESH (nodes, elements, matnum, colors)
+
+      if i: BALL_JOINT (parnum, (x+i, y+i, i), prevpar)
+      else: toppar[(x,y)] = parnum
+
+      prevpar = parnum
+
+    BALL_JOINT (parnum, (x+i+1, y+i+1, i+1))
+
+for (x, y), parnum in toppar.items(): # tie neighbouring chains together
+  if (x+nchain, y) in toppar: BALL_JOINT (parnum, (x+nchain, y+0.5, 0.5), toppar[(x+nchain, y)])
+  if (x, y+nchain) in toppar: BALL_JOINT (parnum, (x+0.5, y+nchain, 0.5), toppar[(x, y+nchain)])
+
+GRAVITY (0., 0., -10.)
+
+h = 0.001
+DEM (1.0, h, (0.05, h), jtol = 1E-8) # warm-started AMG preconditioned CG
@@ -0,0 +1,23 @@
+# PARMEC test --> CLUMP command test: rigid clumps of overlapping spheres
+#                 (bulk sphere arrays) tumbling onto an obstacle floor
+
+mat = MATERIAL (1E3, 1E6, 0.25)
+
+OBSTACLE ([(-3,-3,0, 3,-3,0, 3,3,0), (-3,-3,0, 3,3,0, -3,3,0)], 2)
+
+for k in range (3):
+  centers = []
+  radii = []
+  for l in range (5): # a bent rod of five spheres
+    centers += [-0.5+0.25*l, 0.05*l*l, 0.5+1.0*k+0.1*l]
+    radii.append (0.2 - 0.02*l)
+  CLUMP (centers, radii, mat, 1)
+
+CLUMP ([0, 0, 4, 0.2, 0, 4, 0, 0.2, 4], [0.2, 0.2, 0.2], mat, 1, resolution = 32)
+
+GRANULAR (1, 1, 1E6, 0.5, 0.0)
+
+GRAVITY (0., 0., -10.)
+
+h = 0.1 * CRITICAL()
+DEM (2.0, h, (0.05, h))
@@ -0,0 +1,34 @@
+# PARMEC test --> co-simulation channel: spheres fall under gravity while a
+#                 stand-in coupled solver (python/couple_partner.py) applies
+#                 viscous drag -c*v to the first one; it approaches the terminal
+#                 velocity -m*g/c, while the uncoupled spheres fall freely
+from __future__ import print_function
+import os, subprocess
+from math import pi
+
+path = '/dev/shm/parmec_couple.cpl' if os.path.isdir ('/dev/shm') else 'tests/couple.cpl'
+rad, rho, g = 0.1, 1E3, 10.0
+m = rho*4.0/3.0*pi*rad**3
+c = 10.0*m # relaxation time of 0.1
+
+# stand-in coupled solver: it waits for the channel created by COUPLE
+partner = subprocess.Popen (['python3', 'python/couple_partner.py', path, '--drag', str(c)])
+
+mat = MATERIAL (rho, 1E6, 0.25)
+parts = [SPHERE ((0.5*i, 0.0, 0.0), rad, mat, 1) for i in range (3)]
+GRAVITY (0., 0., -g)
+
+COUPLE (parts[0:1], path)
+vz0 = HISTORY ('VZ', parts[0])
+vz2 = HISTORY ('VZ', parts[2])
+
+DEM (1.0, 1E-3, 0.1)
+
+RESET () # closes the channel
+
+partner.wait()
+
+vt = -m*g/c
+print ('couple: terminal velocity %g, coupled %g, free %g' % (vt, vz0[-1], vz2[-1]))
+assert abs (vz0[-1]-vt) < 0.01*abs(vt)
+assert abs (vz2[-1]+g*1.0) < 0.01*g
@@ -0,0 +1,23 @@
+# PARMEC test --> ELLIPSOID command test: a stack of ellipsoids
+#                 and spheres settling on an obstacle floor
+
+from math import sin, cos
+
+mat = MATERIAL (1E3, 1E6, 0.25)
+
+OBSTACLE ([(-2,-2,0, 2,-2,0, 2,2,0), (-2,-2,0, 2,2,0, -2,2,0)], 2)
+
+for k in range (4):
+  a = 0.4*k
+  orient = (cos(a), sin(a), 0, -sin(a), cos(a), 0, 0, 0, 1)
+  ELLIPSOID ((0.1*k, 0.0, 0.3+0.5*k), (0.5, 0.3, 0.2), mat, 1, orient)
+
+SPHERE ((0.2, 0.1, 2.5), 0.2, mat, 1)
+ELLIPSOID ((-0.6, 0.5, 0.4), (0.1, 0.2, 0.3), mat, 1)
+
+GRANULAR (1, 1, 1E6, 0.5, 0.0)
+
+GRAVITY (0., 0., -10.)
+
+h = 0.1 * CRITICAL()
+DEM (2.0, h, (0.05, h))
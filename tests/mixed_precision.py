@@ -0,0 +1,32 @@
+# PARMEC test --> mixed precision regression input: a granular pile of spheres
+#                 and ellipsoids; when a file name is passed as an argument the
+#                 histories are written there (see python/precision_compare.py)
+
+mat = MATERIAL (1E3, 1E6, 0.25)
+
+OBSTACLE ([(-2,-2,0, 2,-2,0, 2,2,0), (-2,-2,0, 2,2,0, -2,2,0)], 2)
+
+parts = []
+for i in range (4):
+  for j in range (4):
+    for k in range (4):
+      c = (-0.6+0.4*i+0.01*k, -0.6+0.4*j, 0.2+0.4*k)
+      if (i+j+k) % 3: parts.append (SPHERE (c, 0.15, mat, 1))
+      else: parts.append (ELLIPSOID (c, (0.18, 0.12, 0.1), mat, 1))
+
+GRANULAR (1, 1, 1E6, 0.5, 0.0)
+
+GRAVITY (0., 0., -10.)
+
+t = HISTORY ('TIME')
+h = [HISTORY ('PZ', p) for p in parts[::8]]
+v = HISTORY ('|V|', parts)
+
+step = 0.1 * CRITICAL()
+DEM (1.0, step, (0.1, step))
+
+args = ARGV()
+if args:
+  with open (args[0], 'w') as f:
+    for row in zip (t, v, *h):
+      f.write (' '.join ('%.12e' % x for x in row) + '\n')
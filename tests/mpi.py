@@ -0,0 +1,44 @@
+# PARMEC test --> distributed memory run: a granular pile of spheres and ellipsoids
+#                 falls into a box, with a spring between two particles and a spring
+#                 to the ground; run as 'mpirun -np 2 ./parmec8 tests/mpi.py [file]';
+#                 when a file name is passed the histories are written there by the
+#                 first rank (see python/mpi_compare.py, which compares them with a
+#                 single process run)
+
+mat = MATERIAL (1E3, 1E6, 0.25)
+
+OBSTACLE ([(-2,-2,0, 2,-2,0, 2,2,0), (-2,-2,0, 2,2,0, -2,2,0)], 2)
+OBSTACLE ([(-2,-2,0, -2,2,0, -2,2,3), (-2,-2,0, -2,2,3, -2,-2,3)], 2)
+OBSTACLE ([(2,-2,0, 2,2,3, 2,2,0), (2,-2,0, 2,-2,3, 2,2,3)], 2)
+
+parts = []
+for i in range (8):
+  for j in range (4):
+    for k in range (4):
+      c = (-1.4+0.4*i+0.01*k, -0.6+0.4*j, 0.2+0.4*k)
+      if (i+j+k) % 3: parts.append (SPHERE (c, 0.15, mat, 1))
+      else: parts.append (ELLIPSOID (c, (0.18, 0.12, 0.1), mat, 1))
+
+p, q = parts[0], parts[-1] # opposite corners, likely on different ranks
+SPRING (p, (-1.4, -0.6, 0.2), q, (1.43, 0.6, 1.4), [-1,-1E4, 1,1E4], [-1, -1E1, 1, 1E1])
+SPRING (parts[5], (-1.4, -0.2, 0.2), -1, (-1.4, -0.2, 0.0), [-1,-1E4, 1,1E4], [-1, -1E1, 1, 1E1])
+
+GRANULAR (1, 1, 1E6, 0.5, 0.2)
+
+GRAVITY (0., 0., -10.)
+
+t = HISTORY ('TIME')
+h = [HISTORY ('PZ', x) for x in parts[::16]]
+v = HISTORY ('|V|', parts[::5])
+
+step = 0.1 * CRITICAL()
+DEM (1.0, step, (0.1, step), reorder = 100)
+
+rank, size = RANK()
+print ('mpi: rank %d of %d' % (rank, size))
+
+args = ARGV()
+if args and rank == 0:
+  with open (args[0], 'w') as f:
+    for row in zip (t, v, *h):
+      f.write (' '.join ('%.12e' % x for x in row) + '\n')
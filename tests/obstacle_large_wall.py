@@ -0,0 +1,26 @@
+# PARMEC test --> OBSTACLE command test with a large static wall
+#                 a finely triangulated floor and a few bouncing spheres
+
+mat = MATERIAL (1E3, 1E6, 0.25)
+
+n = 200
+d = 0.05
+triangles = []
+for i in range (n):
+  for j in range (n):
+    x = i*d
+    y = j*d
+    triangles.append ((x,y,0, x+d,y,0, x+d,y+d,0))
+    triangles.append ((x,y,0, x+d,y+d,0, x,y+d,0))
+OBSTACLE (triangles, 2)
+
+for i in range (5):
+  for j in range (5):
+    SPHERE ((1.0+2.0*i, 1.0+2.0*j, 0.5+0.1*(i+j)), 0.25, mat, 1)
+
+GRANULAR (0, 0, 1E6, 0.5, 0.0)
+
+GRAVITY (0., 0., -10.)
+
+h = 0.1 * CRITICAL()
+DEM (1.0, h, (0.05, h))
@@ -0,0 +1,32 @@
+# PARMEC test --> OBSTACLE command test with time series driven velocities
+#                 a grid of shaking plates, each carrying a sphere
+
+from math import sin, pi
+
+mat = MATERIAL (1E3, 1E6, 0.25)
+
+freq = 5.0
+amp = 0.1
+times = [0.01*i for i in range(101)]
+vx = TSERIES ([x for t in times for x in (t, amp*2*pi*freq*sin(2*pi*freq*t))])
+zero = TSERIES (0.0)
+spin = TSERIES (0.5)
+
+n = 10
+
+for i in range (n):
+  for j in range (n):
+    x = 2.0*i
+    y = 2.0*j
+    triangles = [(x-0.9,y-0.9,0, x+0.9,y-0.9,0, x+0.9,y+0.9,0),
+                 (x-0.9,y-0.9,0, x+0.9,y+0.9,0, x-0.9,y+0.9,0)]
+    if (i+j) % 2: OBSTACLE (triangles, 2, (x, y, 0), linear = (vx, zero, zero))
+    else: OBSTACLE (triangles, 2, (x, y, 0), linear = (vx, zero, zero), angular = (zero, zero, spin))
+    SPHERE ((x, y, 0.5), 0.25, mat, 1)
+
+GRANULAR (0, 0, 1E6, 1.0, 0.5)
+
+GRAVITY (0., 0., -10.)
+
+h = 0.1 * CRITICAL()
+DEM (1.0, h, (0.05, h))
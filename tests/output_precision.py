@@ -0,0 +1,37 @@
+# PARMEC test --> OUTPUT precision test
+
+matnum = MATERIAL (1E3, 1E9, 0.25)
+
+nodes = [0, 0, 0,
+         1, 0, 0,
+         1, 1, 0,
+         0, 1, 0,
+         0, 0, 1,
+         1, 0, 1,
+         1, 1, 1,
+         0, 1, 1]
+
+elements = [8, 0, 1, 2, 3, 4, 5, 6, 7, matnum]
+
+colors = [1, 4, 0, 1, 2, 3, 2, 4, 4, 5, 6, 7, 3]
+
+parnum = MESH (nodes, elements, matnum, colors)
+
+SPRING (parnum, (1, 1, 1), -1, (1, 1, 1), [-1,-1E7, 1,1E7], [-1, -8E5, 1, 8E5])
+
+GRAVITY (0., 0., -10.)
+
+# GEOM delta encoded (unchanged frames are linked to previous ones), velocities
+# stored as float32, forces quantised with 1E-3 absolute error --> ./tests/output_precision0*.h5
+OUTPUT (precision = [('GEOM', 'DELTA', 1E-9), ('LINVEL', 'FLOAT'), ('ANGVEL', 'FLOAT'), ('FORCE', 'SCALED', 1E-3)])
+
+h = 0.2 * CRITICAL()
+
+DEM (1.0, h, 0.05)
+
+t = HISTORY ('TIME', h5file = 'tests/output_precision0rb.h5')
+vz = HISTORY ('VZ', 0, h5file = 'tests/output_precision0rb.h5')
+fz = HISTORY ('FZ', 0, h5file = 'tests/output_precision0rb.h5', h5last = True)
+
+print ('VZ:', vz)
+print ('FZ:', fz)
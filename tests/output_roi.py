@@ -0,0 +1,47 @@
+# PARMEC test --> OUTPUT region of interest and decimation test
+
+matnum = MATERIAL (1E3, 1E9, 0.25)
+
+prevpar = -1
+
+for i in range (0, 10):
+  nodes = [i, i, i,
+           i+1, i, i,
+           i+1, i+1, i,
+           i, i+1, i,
+           i, i, i+1,
+           i+1, i, i+1,
+           i+1, i+1, i+1,
+           i, i+1, i+1]
+
+  elements = [8, 0, 1, 2, 3, 4, 5, 6, 7, matnum]
+
+  colors = [1, 4, 0, 1, 2, 3, 2, 4, 4, 5, 6, 7, 3]
+
+  parnum = MESH (nodes, elements, matnum, colors)
+
+  if i: SPRING (parnum, (i, i, i), prevpar, (i, i, i), [-1,-1E7, 1,1E7], [-1, -8E5, 1, 8E5])
+
+  prevpar = parnum
+
+SPRING (parnum, (i+1, i+1, i+1), -1, (i+1, i+1, i+1), [-1,-1E7, 1,1E7], [-1, -8E5, 1, 8E5])
+
+GRAVITY (0., 0., -10.)
+
+# unselected particles: every 5th frame --> ./tests/output_roi0*
+OUTPUT (decimate = 5)
+
+# particles inside of a box every frame, outside every 10th frame --> ./tests/output_roi1*
+OUTPUT (['NUMBER', 'LINVEL'], [0, 1, 2, 3, 4], region = (0, 0, -10, 3, 3, 10), decimate = (1, 10))
+
+# particles inside of a sphere only, every 2nd frame --> ./tests/output_roi2*
+OUTPUT (['NUMBER', 'FORCE', 'TORQUE'], [5, 6, 7, 8, 9], region = (7.5, 7.5, 7.5, 1.5), decimate = 2)
+
+h = 0.2 * CRITICAL()
+
+DEM (2.5, h, 0.05)
+
+# frames of decimated output sets are numbered consecutively and remain readable
+t = HISTORY ('TIME', h5file = 'tests/output_roi2rb.h5', h5last = True)
+
+print ('Region of interest output frames:', len(t))
@@ -0,0 +1,40 @@
+# PARMEC test --> OUTPUT streaming test
+import subprocess, time, os
+
+# stand-in consumer: it creates the socket and summarises the received frames
+reader = subprocess.Popen (['python3', 'python/stream_reader.py', 'tests/output_stream.sock'])
+while not os.path.exists ('tests/output_stream.sock'): time.sleep (0.1)
+
+matnum = MATERIAL (1E3, 1E9, 0.25)
+
+nodes = [0, 0, 0,
+         1, 0, 0,
+         1, 1, 0,
+         0, 1, 0,
+         0, 0, 1,
+         1, 0, 1,
+         1, 1, 1,
+         0, 1, 1]
+
+elements = [8, 0, 1, 2, 3, 4, 5, 6, 7, matnum]
+
+colors = [1, 4, 0, 1, 2, 3, 2, 4, 4, 5, 6, 7, 3]
+
+parnum = MESH (nodes, elements, matnum, colors)
+
+SPRING (parnum, (1, 1, 1), -1, (1, 1, 1), [-1,-1E7, 1,1E7], [-1, -8E5, 1, 8E5])
+
+GRAVITY (0., 0., -10.)
+
+OUTPUT (['LINVEL', 'FORCE'], format = 'STREAM', stream = 'tests/output_stream.sock')
+
+t = HISTORY ('TIME')
+vz = HISTORY ('VZ', parnum)
+
+h = 0.2 * CRITICAL()
+
+DEM (1.0, h, (0.05, h))
+
+RESET () # closes the stream
+
+reader.wait()
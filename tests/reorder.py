@@ -0,0 +1,35 @@
+# PARMEC test --> Morton reordering of particles: a shuffled bed of spheres,
+#                 a spring and a restrained particle are run with and without
+#                 reordering; histories refer to input particle numbers and
+#                 should agree up to round-off
+
+from __future__ import print_function
+import random
+
+def model ():
+  rnd = random.Random (1)
+  mat = MATERIAL (1E3, 1E6, 0.25)
+  OBSTACLE ([(-1,-1,0, 2,-1,0, 2,2,0), (-1,-1,0, 2,2,0, -1,2,0)], 2)
+  cells = [(i, j, k) for i in range (5) for j in range (5) for k in range (5)]
+  rnd.shuffle (cells) # input order unrelated to space
+  parts = [SPHERE ((0.1+0.21*i, 0.1+0.21*j, 0.1+0.21*k), 0.1, mat, 1) for (i, j, k) in cells]
+  SPRING (parts[0], (0.1+0.21*cells[0][0], 0.1+0.21*cells[0][1], 0.1+0.21*cells[0][2]), -1,
+          (0.1+0.21*cells[0][0], 0.1+0.21*cells[0][1], 0.1+0.21*cells[0][2]), [-1,-1E5, 1,1E5], [-1, -1E2, 1, 1E2])
+  RESTRAIN (parts[1], [0, 0, 1], [1, 0, 0, 0, 1, 0, 0, 0, 1])
+  GRANULAR (1, 1, 1E6, 0.5, 0.2)
+  GRAVITY (0., 0., -10.)
+  return parts
+
+parts = model ()
+z0 = HISTORY ('PZ', parts[0:3])
+DEM (0.1, 1E-4, (0.05, 1E-3))
+
+RESET ()
+
+parts = model ()
+z1 = HISTORY ('PZ', parts[0:3])
+DEM (0.1, 1E-4, (0.05, 1E-3), reorder = 10)
+
+err = max (abs (a-b) for (a, b) in zip (z0, z1))
+print ('reorder: maximal z history difference', err)
+assert err < 1E-6
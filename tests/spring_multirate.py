@@ -0,0 +1,33 @@
+# PARMEC test --> DEM multirate test: a stiff spring restrains one sphere
+#                 of a soft granular column; the stiff sphere is sub-cycled
+#                 while the rest of the column steps at its own critical step
+
+from __future__ import print_function
+
+def column():
+  mat = MATERIAL (1E3, 1E6, 0.25)
+  OBSTACLE ([(-1,-1,0, 1,-1,0, 1,1,0), (-1,-1,0, 1,1,0, -1,1,0)], 2)
+  parts = [SPHERE ((0.0, 0.0, 0.1+0.2*i), 0.1, mat, 1) for i in range (10)]
+  SPRING (parts[0], (0.0, 0.0, 0.1), -1, (0.0, 0.0, 0.1), [-1,-1E9, 1,1E9], [-1, -1E3, 1, 1E3])
+  GRANULAR (1, 1, 1E6, 0.5, 0.0)
+  GRAVITY (0., 0., -10.)
+  return parts[-1]
+
+top = column()
+steps = CRITICAL (perparticle = 10)
+hfine = 0.5 * steps[0][0] # stiff sphere
+hcoarse = 0.5 * steps[1][0] # soft spheres
+print ('Fine step:', hfine, 'coarse step:', hcoarse)
+
+t0 = HISTORY ('TIME')
+z0 = HISTORY ('PZ', top)
+DEM (0.5, hfine, (0.05, hfine))
+
+RESET ()
+
+top = column()
+t1 = HISTORY ('TIME')
+z1 = HISTORY ('PZ', top)
+DEM (0.5, hcoarse, (0.05, hcoarse), multirate = 8)
+
+print ('Top sphere z, single rate:', z0[-1], 'multi-rate:', z1[-1])
@@ -0,0 +1,18 @@
+# PARMEC test --> phase timers and performance counters: a column of spheres
+#                 settles on a plane while being held by a spring; phase times
+#                 are printed (verbose = 2), traced per step to a CSV file and
+#                 returned by TIMERS
+
+from __future__ import print_function
+
+mat = MATERIAL (1E3, 1E6, 0.25)
+OBSTACLE ([(-1,-1,0, 1,-1,0, 1,1,0), (-1,-1,0, 1,1,0, -1,1,0)], 2)
+parts = [SPHERE ((0.0, 0.0, 0.1+0.2*i), 0.1, mat, 1) for i in range (10)]
+SPRING (parts[0], (0.0, 0.0, 0.1), -1, (0.0, 0.0, 0.1), [-1,-1E6, 1,1E6], [-1, -1E2, 1, 1E2])
+GRANULAR (1, 1, 1E6, 0.5, 0.0)
+GRAVITY (0., 0., -10.)
+
+DEM (0.1, 1E-4, 0.01, verbose = 2, trace = 'tests/timers.csv')
+
+timers = TIMERS ()
+for name in sorted (timers): print (name, timers[name])
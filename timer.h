@@ -48,4 +48,12 @@ static inline double timerend (struct timing *t)
   return t->sec;
 }
 
+/* return the time elapsed since the last start or lap and restart */
+static inline double timerlap (struct timing *t)
+{
+  double sec = timerend (t);
+  timerstart (t);
+  return sec;
+}
+
 #endif